@@ -0,0 +1,214 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Asynchronous requests
+ *
+ * Requests are queued per bus and carried out one at a time by an
+ * asynchronous transport: the transport starts a transfer and reports its
+ * end with tcv_aio_complete(), the completion callback of the request then
+ * runs and the next queued request is started. A single thread can drive
+ * any number of ports on independent buses this way.
+ *
+ * A request holds the bus of its handle (see tcv_bus_attach()) from start to
+ * completion. Requests of other queues on that bus wait meanwhile and start
+ * once it is released, blocking calls on its handles wait as well. Only the
+ * thread driving the queue, the one that last submitted to it or completed
+ * one of its requests, gets TCV_ERR_BUSY instead: the completion it would
+ * wait for can only come from itself.
+ *
+ * Queues bound to a tcv_loop_t run their callbacks from tcv_loop_step()
+ * only, whichever thread the transport completes in. The loop exposes an
+ * eventfd to be watched by an existing poll/epoll/libevent loop.
+ */
+
+#ifndef __LIBTCV_ASYNC_H__
+#define __LIBTCV_ASYNC_H__
+
+#include "libtcv/tcv.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/******************************************************************************/
+
+/** Request queue of one bus, serializes the requests of its handles */
+typedef struct tcv_queue tcv_queue_t;
+
+/** Transfer handed to the transport, passed back to tcv_aio_complete() */
+typedef struct tcv_aio_req tcv_aio_req_t;
+
+/** Completion dispatcher driven by an application event loop */
+typedef struct tcv_loop tcv_loop_t;
+
+/**
+ * \brief	Completion callback of a submitted request
+ * \param	tcv		handle the request was submitted on
+ * \param	status	0 if ok, error code otherwise
+ * \param	arg		user argument given at submission
+ */
+typedef void (*tcv_aio_cb_t)(tcv_t *tcv, int status, void *arg);
+
+/**
+ * \struct tcv_aio_ops_t
+ * \brief  Asynchronous transport
+ */
+typedef struct {
+	/**
+	 * \brief	Start reading, tcv_aio_complete(req, ...) must follow once
+	 *          data is filled in. It may be called before returning.
+	 *          Transfers never exceed the handle's transport capabilities.
+	 * \param	ctx		context given to tcv_create_ex()
+	 * \param	req		request to complete
+	 * \param	devaddr	Device address to be read.
+	 * \param	regaddr	First register address to be read.
+	 * \param	data	(out) register content read
+	 * \param	len		Size in bytes to be read.
+	 * \return	0 if started, error code otherwise (no completion follows)
+	 */
+	int (*submit_read)(void *ctx, tcv_aio_req_t *req, uint8_t devaddr,
+	                   uint8_t regaddr, uint8_t *data, size_t len);
+} tcv_aio_ops_t;
+
+/******************************************************************************/
+/**
+ * \brief	Create a request queue, usually one per bus
+ * \param	ops		asynchronous transport, referenced not copied. NULL for a
+ *                  queue carried out with the handles' blocking callbacks,
+ *                  one request per tcv_loop_step(), see tcv_queue_set_loop()
+ * \return	allocated queue or NULL
+ */
+tcv_queue_t *tcv_queue_create(const tcv_aio_ops_t *ops);
+
+/******************************************************************************/
+/**
+ * \brief	Free a queue, requests not started yet complete with
+ *          TCV_ERR_CANCELED. Handles must be detached before, the queue is
+ *          removed from its loop.
+ * \param	q		queue
+ * \return	0 if ok, TCV_ERR_BUSY while a transfer is in flight
+ */
+int tcv_queue_destroy(tcv_queue_t *q);
+
+/******************************************************************************/
+/**
+ * \brief	Number of requests queued or in flight
+ * \param	q		queue
+ * \return	number of requests
+ */
+size_t tcv_queue_pending(tcv_queue_t *q);
+
+/******************************************************************************/
+/**
+ * \brief	Route the requests of a handle through a queue
+ * \param	tcv		handle created by tcv_create_ex()
+ * \param	q		queue, NULL to detach
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_set_queue(tcv_t *tcv, tcv_queue_t *q);
+
+/******************************************************************************/
+/**
+ * \brief	Queue a raw read, see tcv_read()
+ * \param	tcv		initialized handle attached to a queue
+ * \param	devaddr	device address
+ * \param	regaddr	first register address
+ * \param	data	(out) buffer, must stay valid until completion
+ * \param	len		size of data
+ * \param	cb		completion callback
+ * \param	arg		user argument passed to cb
+ * \return	0 if queued (cb follows), error code otherwise
+ */
+int tcv_submit_read(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr,
+                    uint8_t *data, size_t len, tcv_aio_cb_t cb, void *arg);
+
+/******************************************************************************/
+/**
+ * \brief	Queue a digital diagnostics snapshot, see tcv_get_dd_snapshot()
+ * \param	tcv		initialized handle attached to a queue
+ * \param	snapshot	(out) must stay valid until completion
+ * \param	cb		completion callback
+ * \param	arg		user argument passed to cb
+ * \return	0 if queued (cb follows), error code otherwise
+ */
+int tcv_submit_dd_snapshot(tcv_t *tcv, tcv_dd_snapshot_t *snapshot,
+                           tcv_aio_cb_t cb, void *arg);
+
+/******************************************************************************/
+/**
+ * \brief	Create a loop, its file descriptor becomes readable whenever
+ *          tcv_loop_step() has work to do
+ * \return	allocated loop or NULL
+ */
+tcv_loop_t *tcv_loop_create(void);
+
+/******************************************************************************/
+/**
+ * \brief	Free a loop, completions not dispatched yet are dropped
+ * \param	loop	loop without queues
+ * \return	0 if ok, TCV_ERR_BUSY while queues are bound to it
+ */
+int tcv_loop_destroy(tcv_loop_t *loop);
+
+/******************************************************************************/
+/**
+ * \brief	File descriptor to poll for POLLIN, owned by the loop
+ * \param	loop	loop
+ * \return	file descriptor or error code
+ */
+int tcv_loop_get_fd(tcv_loop_t *loop);
+
+/******************************************************************************/
+/**
+ * \brief	Run pending completion callbacks and one request of every queue
+ *          without transport. Does not block.
+ * \param	loop	loop
+ * \return	number of callbacks run, error code otherwise
+ */
+int tcv_loop_step(tcv_loop_t *loop);
+
+/******************************************************************************/
+/**
+ * \brief	Dispatch the completions of a queue from a loop
+ * \param	q		queue, idle
+ * \param	loop	loop, NULL to complete from the transport again
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_queue_set_loop(tcv_queue_t *q, tcv_loop_t *loop);
+
+/******************************************************************************/
+/**
+ * \brief	Report the end of a transfer started by submit_read()
+ * \param	req		request passed to submit_read()
+ * \param	status	0 if ok, error code otherwise
+ */
+void tcv_aio_complete(tcv_aio_req_t *req, int status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LIBTCV_ASYNC_H__ */
@@ -0,0 +1,126 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Bus topology
+ *
+ * Transceivers sharing an I2C bus, often behind PCA9548 style muxes, are
+ * attached to one tcv_bus_t. Transactions of its handles are serialized,
+ * different buses still run in parallel. The selected mux channel is cached
+ * so the select write is only issued when the channel changes, and queued
+ * requests are started channel by channel.
+ */
+
+#ifndef __LIBTCV_BUS_H__
+#define __LIBTCV_BUS_H__
+
+#include "libtcv/tcv.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/******************************************************************************/
+
+/** Shared I2C bus */
+typedef struct tcv_bus tcv_bus_t;
+
+/** Channel of handles reached without mux */
+#define TCV_BUS_NO_MUX		(-1)
+
+/**
+ * \brief	Mux select callback
+ * \param	ctx		Opaque pointer given to tcv_bus_create().
+ * \param	channel	Mux channel to route the bus to.
+ * \return	0 if ok, error code otherwise.
+ */
+typedef int (*tcv_mux_select_cb_t)(void *, int);
+
+/**
+ * \struct tcv_bus_stats_t
+ * \brief  Bus usage counters
+ */
+typedef struct {
+	uint64_t transactions;	//! Exclusive bus accesses
+	uint64_t mux_selects;	//! Select writes issued
+	uint64_t mux_skipped;	//! Select writes avoided, channel already set
+} tcv_bus_stats_t;
+
+/******************************************************************************/
+/**
+ * \brief	Create a bus
+ * \param	ctx		passed to select()
+ * \param	select	mux select callback, NULL if there is no mux
+ * \return	allocated bus or NULL
+ */
+tcv_bus_t *tcv_bus_create(void *ctx, tcv_mux_select_cb_t select);
+
+/******************************************************************************/
+/**
+ * \brief	Free a bus
+ * \param	bus		bus without handles
+ * \return	0 if ok, TCV_ERR_BUSY while handles are attached
+ */
+int tcv_bus_destroy(tcv_bus_t *bus);
+
+/******************************************************************************/
+/**
+ * \brief	Attach a handle to a bus
+ * \param	bus		bus
+ * \param	tcv		handle, not attached to another bus
+ * \param	channel	mux channel of the port or TCV_BUS_NO_MUX
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_bus_attach(tcv_bus_t *bus, tcv_t *tcv, int channel);
+
+/******************************************************************************/
+/**
+ * \brief	Detach a handle from its bus, it must have no request in flight
+ * \param	tcv		handle
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_bus_detach(tcv_t *tcv);
+
+/******************************************************************************/
+/**
+ * \brief	Forget the cached mux channel, e.g. after a bus reset
+ * \param	bus		bus
+ */
+void tcv_bus_invalidate(tcv_bus_t *bus);
+
+/******************************************************************************/
+/**
+ * \brief	Bus usage counters
+ * \param	bus		bus
+ * \param	stats	(out) counters since creation
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_bus_get_stats(tcv_bus_t *bus, tcv_bus_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LIBTCV_BUS_H__ */
@@ -0,0 +1,109 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Persistent EEPROM cache
+ *
+ * Keeps the A0h image of every port in a directory, one file per port index,
+ * so a restarted process does not have to read all of it again. tcv_init()
+ * of an attached handle only reads a validation slice (CC_BASE and bytes
+ * 68-95: serial number, date code, diagnostics type, CC_EXT) and reuses the
+ * stored image when it matches. The vendor specific bytes 96-255 are taken
+ * from the stored image unchecked, writes through tcv_write() drop it.
+ */
+
+#ifndef __LIBTCV_EEPROM_CACHE_H__
+#define __LIBTCV_EEPROM_CACHE_H__
+
+#include "libtcv/tcv.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/******************************************************************************/
+
+/** Directory of stored EEPROM images */
+typedef struct tcv_eeprom_cache tcv_eeprom_cache_t;
+
+/**
+ * \struct tcv_eeprom_cache_stats_t
+ * \brief  EEPROM cache counters
+ */
+typedef struct {
+	uint64_t hits;		//! stored image reused
+	uint64_t misses;	//! no or outdated image, full read
+	uint64_t stores;	//! images written
+} tcv_eeprom_cache_stats_t;
+
+/******************************************************************************/
+/**
+ * \brief	Open a cache directory
+ * \param	dir		existing directory writable by the process
+ * \return	allocated cache or NULL
+ */
+tcv_eeprom_cache_t *tcv_eeprom_cache_open(const char *dir);
+
+/******************************************************************************/
+/**
+ * \brief	Free a cache, the stored images are kept
+ * \param	cache	cache without handles
+ * \return	0 if ok, TCV_ERR_BUSY while handles are attached
+ */
+int tcv_eeprom_cache_close(tcv_eeprom_cache_t *cache);
+
+/******************************************************************************/
+/**
+ * \brief	Use a cache for the next tcv_init() of a handle
+ * \param	cache	cache
+ * \param	tcv		handle, not attached to another cache. Its port index
+ * 					names the stored image.
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_eeprom_cache_attach(tcv_eeprom_cache_t *cache, tcv_t *tcv);
+
+/******************************************************************************/
+/**
+ * \brief	Stop using the cache of a handle
+ * \param	tcv		handle
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_eeprom_cache_detach(tcv_t *tcv);
+
+/******************************************************************************/
+/**
+ * \brief	Cache counters
+ * \param	cache	cache
+ * \param	stats	(out) counters since opening
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_eeprom_cache_get_stats(tcv_eeprom_cache_t *cache,
+                               tcv_eeprom_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LIBTCV_EEPROM_CACHE_H__ */
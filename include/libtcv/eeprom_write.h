@@ -0,0 +1,98 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * EEPROM write engine
+ *
+ * Module EEPROMs take writes one page (typically 8 or 16 bytes) at a time
+ * and then go through an internal write cycle, NACKing their address until
+ * it is over. With a page size configured, tcv_write() splits writes on page
+ * boundaries and polls for the ACK after every page instead of relying on
+ * fixed sleeps. Pages can optionally be read back and compared.
+ *
+ * Deferred writes are collected per device and merged, tcv_flush() then
+ * writes every run of adjacent bytes at once.
+ */
+
+#ifndef __LIBTCV_EEPROM_WRITE_H__
+#define __LIBTCV_EEPROM_WRITE_H__
+
+#include "libtcv/tcv.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/******************************************************************************/
+
+/**
+ * \struct tcv_write_config_t
+ * \brief  EEPROM write parameters of a handle
+ */
+typedef struct {
+	size_t page_size;			//! EEPROM write page, 0 writes as given (default)
+	uint32_t ack_timeout_ms;	//! ACK polling limit per page, 0 does not poll
+	uint8_t verify;				//! read back and compare every page, needs ACK polling
+} tcv_write_config_t;
+
+/******************************************************************************/
+/**
+ * \brief	Configure how tcv_write() and tcv_flush() write
+ * \param	tcv		handle
+ * \param	config	write parameters, page_size must be a power of two, verify
+ * 					needs an ack_timeout_ms with pages
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_set_write_config(tcv_t *tcv, const tcv_write_config_t *config);
+
+/******************************************************************************/
+/**
+ * \brief	Collect a write for the next tcv_flush(). Overlapping deferred
+ * 			writes keep the latest data.
+ * \param	tcv		initialized handle
+ * \param	devaddr	device address
+ * \param	regaddr	first register address
+ * \param	data	data to write, copied
+ * \param	len		number of bytes, up to the end of the device
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_write_deferred(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr,
+                       const uint8_t *data, size_t len);
+
+/******************************************************************************/
+/**
+ * \brief	Write all deferred data as by tcv_write(), one write per run of
+ * 			adjacent bytes. Runs that failed are kept for the next flush,
+ * 			except for those rejected as invalid.
+ * \param	tcv		initialized handle
+ * \return	0 if ok, error code of the first failed write otherwise
+ */
+int tcv_flush(tcv_t *tcv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LIBTCV_EEPROM_WRITE_H__ */
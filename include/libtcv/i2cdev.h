@@ -0,0 +1,98 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Linux i2c-dev transport for libtcv
+ *
+ * Provides ready made read/write callbacks on top of /dev/i2c-N. Register
+ * addressed reads are issued as one combined I2C_RDWR transaction (pointer
+ * write, repeated start, read). Adapters without plain I2C support fall back
+ * to SMBus I2C block transfers, which select the module with I2C_SLAVE_FORCE
+ * so they also work while a kernel driver like at24 or optoe is bound to it.
+ */
+
+#ifndef __LIBTCV_I2CDEV_H__
+#define __LIBTCV_I2CDEV_H__
+
+#include "libtcv/tcv.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/******************************************************************************/
+/** Default device node, %d is replaced by the bus number */
+#define TCV_I2CDEV_DEFAULT_PATH		"/dev/i2c-%d"
+
+/**
+ * \brief Pool of opened i2c-dev buses, one file descriptor per bus shared
+ *        by all transceivers created on it.
+ */
+typedef struct tcv_i2cdev tcv_i2cdev_t;
+
+/******************************************************************************/
+/**
+ * \brief Create an empty bus pool, buses are opened on first use
+ * \param path_fmt printf format of the device node taking the bus number,
+ *                 NULL for TCV_I2CDEV_DEFAULT_PATH
+ * \return allocated pool or NULL
+ */
+tcv_i2cdev_t *tcv_i2cdev_open(const char *path_fmt);
+
+/******************************************************************************/
+/**
+ * \brief Close all buses and free the pool.
+ *        Transceivers created on the pool must be destroyed before.
+ * \param pool bus pool
+ */
+void tcv_i2cdev_close(tcv_i2cdev_t *pool);
+
+/******************************************************************************/
+/**
+ * \brief Create a transceiver handle reached through an i2c-dev bus
+ *
+ * The bus is opened and its functionality queried if not done yet. The
+ * handle index is the bus number, it must be released with tcv_destroy().
+ * \param pool bus pool
+ * \param bus bus number
+ * \return allocated tcv_t or NULL
+ */
+tcv_t *tcv_i2cdev_create(tcv_i2cdev_t *pool, int bus);
+
+/******************************************************************************/
+/**
+ * \brief Adapter functionality as reported by the I2C_FUNCS ioctl
+ * \param pool bus pool
+ * \param bus bus number, opened if needed
+ * \param funcs (out) I2C_FUNC_* bitmap
+ * \return 0 if ok, error code otherwise
+ */
+int tcv_i2cdev_get_funcs(tcv_i2cdev_t *pool, int bus, unsigned long *funcs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LIBTCV_I2CDEV_H__ */
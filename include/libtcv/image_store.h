@@ -0,0 +1,105 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Shared A0h image store
+ *
+ * Modules of the same part carry the same A0h page except for a few per
+ * module fields: CC_BASE and bytes 68-95 (serial number, date code,
+ * diagnostics type, CC_EXT). Handles attached to a store keep those fields
+ * in a small per handle copy and share one read-only image of the remaining
+ * bytes with all other modules of the part. Accessors are not affected.
+ */
+
+#ifndef __LIBTCV_IMAGE_STORE_H__
+#define __LIBTCV_IMAGE_STORE_H__
+
+#include "libtcv/tcv.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/******************************************************************************/
+
+/** Interned A0h images */
+typedef struct tcv_image_store tcv_image_store_t;
+
+/**
+ * \struct tcv_image_store_stats_t
+ * \brief  Image store counters
+ */
+typedef struct {
+	uint64_t images;		//! distinct images held
+	uint64_t references;	//! handles using one of them
+} tcv_image_store_stats_t;
+
+/******************************************************************************/
+/**
+ * \brief	Create an empty store
+ * \return	allocated store or NULL
+ */
+tcv_image_store_t *tcv_image_store_create(void);
+
+/******************************************************************************/
+/**
+ * \brief	Free a store
+ * \param	store	store without handles and images in use
+ * \return	0 if ok, TCV_ERR_BUSY while handles are attached or use images
+ */
+int tcv_image_store_destroy(tcv_image_store_t *store);
+
+/******************************************************************************/
+/**
+ * \brief	Share the A0h image of a handle from its next tcv_init() on
+ * \param	store	store
+ * \param	tcv		handle, not attached to another store
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_image_store_attach(tcv_image_store_t *store, tcv_t *tcv);
+
+/******************************************************************************/
+/**
+ * \brief	Stop sharing images of a handle from its next tcv_init() on
+ * \param	tcv		handle
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_image_store_detach(tcv_t *tcv);
+
+/******************************************************************************/
+/**
+ * \brief	Store counters
+ * \param	store	store
+ * \param	stats	(out) current counters
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_image_store_get_stats(tcv_image_store_t *store,
+                              tcv_image_store_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LIBTCV_IMAGE_STORE_H__ */
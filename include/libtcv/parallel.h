@@ -0,0 +1,91 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Parallel initialization
+ *
+ * tcv_init_many() initializes a whole fleet of handles with a small pool of
+ * worker threads. Handles attached to the same tcv_bus_t are initialized one
+ * after the other by one worker, different buses in parallel, so the time to
+ * the first inventory follows the number of buses rather than the number of
+ * ports. Handles not attached to a bus are independent of each other.
+ */
+
+#ifndef __LIBTCV_PARALLEL_H__
+#define __LIBTCV_PARALLEL_H__
+
+#include "libtcv/tcv.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/******************************************************************************/
+
+/** Upper limit of worker threads of tcv_init_many() */
+#define TCV_PARALLEL_MAX_THREADS	64
+
+/** Worker threads of tcv_init_many() if not given */
+#define TCV_PARALLEL_DEFAULT_THREADS	16
+
+/**
+ * \brief	Completion callback of one handle
+ * \param	tcv		handle as passed in
+ * \param	status	result of tcv_init()
+ * \param	arg		Opaque pointer of tcv_parallel_opts_t.
+ */
+typedef void (*tcv_parallel_cb_t)(tcv_t *tcv, int status, void *arg);
+
+/**
+ * \struct tcv_parallel_opts_t
+ * \brief  Options of tcv_init_many(), zero initialized for the defaults
+ */
+typedef struct {
+	unsigned int threads;	//! workers including the caller, 0 for the default
+	int *results;			//! (out) result of tcv_init() per handle, may be NULL
+	tcv_parallel_cb_t done;	//! called by the worker after each handle, may be NULL
+	void *arg;				//! passed to done
+} tcv_parallel_opts_t;
+
+/******************************************************************************/
+/**
+ * \brief	Initialize many handles in parallel, tcv_init() for each one
+ *
+ * The calling thread works as one of the workers and returns when all
+ * handles are done. Buses with the most handles are started first. Worker
+ * threads that cannot be created are left out, in the worst case the caller
+ * initializes all handles by itself.
+ * \param	handles	handles, entries may be NULL
+ * \param	n		number of handles
+ * \param	opts	options, NULL for the defaults
+ * \return	number of handles initialized, error code < 0 otherwise
+ */
+int tcv_init_many(tcv_t **handles, size_t n, const tcv_parallel_opts_t *opts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LIBTCV_PARALLEL_H__ */
@@ -0,0 +1,133 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Digital diagnostics poll engine
+ *
+ * A poller reads the digital diagnostics snapshot of a fixed set of handles
+ * once per cycle with a pool of worker threads and hands every result to a
+ * callback. Handles attached to the same tcv_bus_t form one task queue that
+ * is worked off one handle at a time, handles without bus are spread over
+ * queues of their own. Each queue belongs to a worker, a worker running out
+ * of work steals the next handle from the queues of the other workers.
+ *
+ * Cycles start on a fixed schedule. A slow or stuck port holds up its own
+ * bus only: ports its bus did not reach in time are polled in the next
+ * cycle, before the ports that were polled already.
+ */
+
+#ifndef __LIBTCV_POLLER_H__
+#define __LIBTCV_POLLER_H__
+
+#include "libtcv/tcv.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/******************************************************************************/
+
+/** Poll engine */
+typedef struct tcv_poller tcv_poller_t;
+
+/** Upper limit of worker threads of a poller */
+#define TCV_POLL_MAX_THREADS		64
+
+/** Worker threads of a poller if not given */
+#define TCV_POLL_DEFAULT_THREADS	8
+
+/**
+ * \brief	Result of one poll
+ * \param	tcv			polled handle
+ * \param	status		result of tcv_get_dd_snapshot()
+ * \param	snapshot	diagnostics read, NULL on error. Only valid during
+ *						the call.
+ * \param	arg			Opaque pointer of tcv_poll_opts_t.
+ */
+typedef void (*tcv_poll_cb_t)(tcv_t *tcv, int status,
+                              const tcv_dd_snapshot_t *snapshot, void *arg);
+
+/**
+ * \struct tcv_poll_opts_t
+ * \brief  Options of tcv_poller_create()
+ */
+typedef struct {
+	unsigned int threads;	//! worker threads, 0 for the default
+	uint32_t interval_ms;	//! time between cycle starts, > 0
+	tcv_poll_cb_t cb;		//! called by the worker after each poll
+	void *arg;				//! passed to cb
+} tcv_poll_opts_t;
+
+/**
+ * \struct tcv_poll_stats_t
+ * \brief  Poller counters since creation
+ */
+typedef struct {
+	uint64_t cycles;		//! cycles started
+	uint64_t completed;		//! cycles done before the next one was due
+	uint64_t overruns;		//! cycles still running when the next one was due
+	uint64_t snapshots;		//! successful polls
+	uint64_t errors;		//! failed polls
+	uint64_t steals;		//! polls taken from the queues of another worker
+	uint64_t last_cycle_ns;	//! duration of the last completed cycle
+	uint64_t max_cycle_ns;	//! longest completed cycle
+} tcv_poll_stats_t;
+
+/******************************************************************************/
+/**
+ * \brief	Create a poller and start polling
+ *
+ * The bus of each handle is looked up once. The handles must not be
+ * destroyed or moved to another bus before the poller is destroyed.
+ * \param	handles	handles to poll, copied
+ * \param	n		number of handles, > 0
+ * \param	opts	options
+ * \return	allocated poller or NULL
+ */
+tcv_poller_t *tcv_poller_create(tcv_t **handles, size_t n,
+                                const tcv_poll_opts_t *opts);
+
+/******************************************************************************/
+/**
+ * \brief	Stop polling and free a poller, waits for polls in progress
+ * \param	poller	poller
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_poller_destroy(tcv_poller_t *poller);
+
+/******************************************************************************/
+/**
+ * \brief	Poller counters
+ * \param	poller	poller
+ * \param	stats	(out) counters since creation
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_poller_get_stats(tcv_poller_t *poller, tcv_poll_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LIBTCV_POLLER_H__ */
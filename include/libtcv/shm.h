@@ -0,0 +1,147 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Shared memory publisher
+ *
+ * One process owns the handles and publishes the A0h image and the digital
+ * diagnostics of every port into a POSIX shared memory object. Any number of
+ * local processes map it read-only and read the ports without I2C access and
+ * without taking locks: every slot is guarded by a sequence counter, readers
+ * retry while the publisher is updating the slot.
+ */
+
+#ifndef __LIBTCV_SHM_H__
+#define __LIBTCV_SHM_H__
+
+#include "libtcv/tcv.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/******************************************************************************/
+
+/** Shared memory object, publisher or reader side */
+typedef struct tcv_shm tcv_shm_t;
+
+/** tcv_shm_port_t.a0 holds the A0h image */
+#define TCV_SHM_A0_VALID		(1 << 0)
+/** tcv_shm_port_t.dd holds a digital diagnostics snapshot */
+#define TCV_SHM_DD_VALID		(1 << 1)
+
+/**
+ * \struct tcv_shm_port_t
+ * \brief  Published data of one port
+ */
+typedef struct {
+	int index;				//! port index of the publishing handle
+	uint32_t flags;			//! TCV_SHM_A0_VALID, TCV_SHM_DD_VALID
+	uint8_t a0[256];		//! A0h image
+	tcv_dd_snapshot_t dd;	//! latest digital diagnostics
+} tcv_shm_port_t;
+
+/******************************************************************************/
+/**
+ * \brief	Create the shared memory object of a publisher. An object of
+ *          that name must not exist, see tcv_shm_unlink().
+ * \param	name	shm_open() name, e.g. "/libtcv"
+ * \param	nslots	number of ports
+ * \return	allocated publisher or NULL
+ */
+tcv_shm_t *tcv_shm_create(const char *name, size_t nslots);
+
+/******************************************************************************/
+/**
+ * \brief	Remove an object left behind by a publisher that did not close,
+ *          readers still mapping it keep their view
+ * \param	name	name given to tcv_shm_create()
+ * \return	0 if removed or absent, error code otherwise
+ */
+int tcv_shm_unlink(const char *name);
+
+/******************************************************************************/
+/**
+ * \brief	Map the shared memory object of a publisher read-only
+ * \param	name	name given to tcv_shm_create()
+ * \return	allocated reader or NULL
+ */
+tcv_shm_t *tcv_shm_open(const char *name);
+
+/******************************************************************************/
+/**
+ * \brief	Unmap a publisher or reader, the object is removed by the
+ *          publisher
+ * \param	shm		publisher or reader
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_shm_close(tcv_shm_t *shm);
+
+/******************************************************************************/
+/**
+ * \brief	Number of port slots
+ * \param	shm		publisher or reader
+ * \return	slots, 0 on error
+ */
+size_t tcv_shm_slots(const tcv_shm_t *shm);
+
+/******************************************************************************/
+/**
+ * \brief	Publish the A0h image and a digital diagnostics snapshot of a
+ *          handle. Modules without diagnostics publish the image only.
+ * \param	shm		publisher
+ * \param	slot	slot of the port
+ * \param	tcv		initialized handle
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_shm_publish(tcv_shm_t *shm, size_t slot, tcv_t *tcv);
+
+/******************************************************************************/
+/**
+ * \brief	Publish a snapshot taken elsewhere, e.g. by a queued request
+ * \param	shm		publisher
+ * \param	slot	slot of the port, keeps its A0h image
+ * \param	snapshot	digital diagnostics
+ * \return	0 if ok, error code otherwise
+ */
+int tcv_shm_publish_dd(tcv_shm_t *shm, size_t slot,
+                       const tcv_dd_snapshot_t *snapshot);
+
+/******************************************************************************/
+/**
+ * \brief	Read a consistent copy of a port, without locks or I2C access
+ * \param	shm		publisher or reader
+ * \param	slot	slot of the port
+ * \param	port	(out) published data
+ * \return	0 if ok, TCV_ERR_NOT_INITIALIZED if nothing was published yet,
+ *          TCV_ERR_BUSY if the slot kept changing, error code otherwise
+ */
+int tcv_shm_read(const tcv_shm_t *shm, size_t slot, tcv_shm_port_t *port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LIBTCV_SHM_H__ */
@@ -71,6 +71,14 @@ extern "C"{
 #define TCV_ERR_FEATURE_NOT_AVAILABLE			-12
 /* Function called on not initialized handle */
 #define TCV_ERR_NOT_INITIALIZED					-13
+/* Queued request dropped before it was carried out */
+#define TCV_ERR_CANCELED						-14
+/* Object still has requests in flight */
+#define TCV_ERR_BUSY							-15
+/* Device did not finish in time, e.g. an EEPROM write cycle */
+#define TCV_ERR_TIMEOUT							-16
+/* Data read back differs from the data written */
+#define TCV_ERR_VERIFY							-17
 
 /**
  * transceiver reference in client code
@@ -109,6 +117,65 @@ typedef int (*i2c_read_cb_t)(int, uint8_t, uint8_t, uint8_t*, size_t);
  */
 typedef int (*i2c_write_cb_t)(int, uint8_t, uint8_t, const uint8_t*, size_t);
 
+/**
+ * \brief	I2C read callback carrying a user context.
+ * \param	ctx		Opaque pointer given to tcv_create_ex().
+ * \param	devaddr	Device address to be read.
+ * \param	regaddr	First register address to be read.
+ * \param	data	(out) register content read
+ * \param	size	Size in bytes to be read.
+ * \return	0 if ok, error code otherwise.
+ */
+typedef int (*i2c_read_ex_cb_t)(void *, uint8_t, uint8_t, uint8_t*, size_t);
+
+/**
+ * \brief	I2C write callback carrying a user context.
+ * \param	ctx		Opaque pointer given to tcv_create_ex().
+ * \param	devaddr	Device address to be written.
+ * \param	regaddr	First register address to be written.
+ * \param	data	(in) data to write
+ * \param	size	Size in bytes to be written.
+ * \return	0 if ok, error code otherwise.
+ */
+typedef int (*i2c_write_ex_cb_t)(void *, uint8_t, uint8_t, const uint8_t*, size_t);
+
+/**
+ * \struct tcv_i2c_segment_t
+ * \brief  One register region of a vectored I2C read
+ */
+typedef struct {
+	uint8_t devaddr;	//! Device address to be read.
+	uint8_t regaddr;	//! First register address to be read.
+	uint8_t *data;		//! (out) register content read
+	size_t len;			//! Size in bytes to be read.
+} tcv_i2c_segment_t;
+
+/**
+ * \brief	Vectored I2C read callback.
+ *          Reads every segment, adapters supporting combined messages
+ *          (e.g. I2C_RDWR) can issue all of them in a single bus transaction.
+ * \param	ctx		Opaque pointer given to tcv_create_ex().
+ * \param	segs	Segments to be read.
+ * \param	nsegs	Number of segments.
+ * \return	0 if ok, error code otherwise.
+ */
+typedef int (*i2c_readv_cb_t)(void *, const tcv_i2c_segment_t *, size_t);
+
+/** Largest SMBus block transfer */
+#define TCV_SMBUS_BLOCK_MAX		32
+
+/**
+ * \struct tcv_transport_caps_t
+ * \brief  Limits of the I2C adapter behind the read/write callbacks.
+ *         The library splits transfers accordingly, so callbacks never
+ *         see a request the adapter cannot perform in one go.
+ */
+typedef struct {
+	size_t max_xfer;		//! Largest read or write in bytes, 0 for no limit
+	uint8_t smbus_only;		//! SMBus controller, caps transfers at TCV_SMBUS_BLOCK_MAX
+	uint8_t repeated_start;	//! Combined messages possible, required for readv
+} tcv_transport_caps_t;
+
 /******************************************************************************/
 
 /**
@@ -122,6 +189,48 @@ typedef int (*i2c_write_cb_t)(int, uint8_t, uint8_t, const uint8_t*, size_t);
  */
 tcv_t* tcv_create(int index, i2c_read_cb_t read, i2c_write_cb_t write);
 
+/**
+ * \brief Create a Transceiver handle whose I2C callbacks receive a user context
+ * 		  instead of the port index, so no index lookup is needed per transaction.
+ * 		  return value must be deallocated with tcv_destroy()
+ * @param index - port identifier, kept for reference only
+ * @param ctx - opaque pointer passed as first argument to read() and write()
+ * @param read function to read data from transceiver
+ * @param write function to write to transceiver
+ * @return allocated tcv_t or NULL
+ */
+tcv_t* tcv_create_ex(int index, void *ctx, i2c_read_ex_cb_t read,
+                     i2c_write_ex_cb_t write);
+
+/******************************************************************************/
+/**
+ * \brief	Register an optional vectored read callback.
+ *          The library then submits all regions needed by one operation as
+ *          a single batch instead of one read() per region.
+ * \param	tcv		Handle created by tcv_create_ex()
+ * \param	readv	Vectored read callback, NULL to fall back to read()
+ * \return	0 if ok, error code otherwise.
+ */
+int tcv_set_readv(tcv_t *tcv, i2c_readv_cb_t readv);
+
+/******************************************************************************/
+/**
+ * \brief	Describe the adapter the handle is reached through.
+ *          Default is no size limit, plain I2C with repeated start.
+ * \param	tcv		Transceiver handle
+ * \param	caps	Adapter capabilities, copied
+ * \return	0 if ok, error code otherwise.
+ */
+int tcv_set_transport_caps(tcv_t *tcv, const tcv_transport_caps_t *caps);
+
+/**
+ * \brief	Adapter capabilities set by tcv_set_transport_caps()
+ * \param	tcv		Transceiver handle
+ * \param	caps	(out) Adapter capabilities
+ * \return	0 if ok, error code otherwise.
+ */
+int tcv_get_transport_caps(tcv_t *tcv, tcv_transport_caps_t *caps);
+
 /******************************************************************************/
 /**
  * \brief	Transceiver structure initialization.
@@ -131,6 +240,37 @@ tcv_t* tcv_create(int index, i2c_read_cb_t read, i2c_write_cb_t write);
  */
 int tcv_init(tcv_t *tcv);
 
+/******************************************************************************/
+/**
+ * \brief	Let tcv_init() read only the MSA defined part of A0h (bytes 0-95).
+ *          The vendor specific and SFF-8079 areas are read on first access
+ *          by tcv_get_vendor_rom() and tcv_get_8079_rom().
+ * \param	tcv		Pointer to TCV's structure, applies to the next tcv_init().
+ * \param	lazy	non-zero to enable, 0 to read all of A0h (default).
+ * \return	0 if ok, error code otherwise.
+ */
+int tcv_set_lazy_init(tcv_t *tcv, int lazy);
+
+/******************************************************************************/
+/**
+ * \brief	Re-read static module data cached by tcv_init(), e.g. the external
+ *          calibration constants of digital diagnostics.
+ * \param	tcv		Pointer to initialized TCV's structure.
+ * \return	0 if ok, error code otherwise.
+ */
+int tcv_refresh(tcv_t *tcv);
+
+/******************************************************************************/
+/**
+ * \brief	Check if the module is still the one tcv_init() found, reading only
+ *          the identifier, serial number, date code and checksums. A
+ *          different module is initialized as by tcv_init().
+ * \param	tcv		Pointer to initialized TCV's structure.
+ * \return	0 if the module is unchanged, 1 if it changed and was initialized,
+ *          error code otherwise.
+ */
+int tcv_revalidate(tcv_t *tcv);
+
 /******************************************************************************/
 /**
  * \brief	Deallocate resources for given transceiver
@@ -1041,7 +1181,10 @@ size_t tcv_get_vendor_rom_size(tcv_t *tcv);
 /******************************************************************************/
 
 /**
- * \brief	Allow direct access to user writable eeprom area of page a2
+ * \brief	Allow direct access to user writable eeprom area of page a2.
+ *          The area is read once and kept up to date by tcv_write(). The
+ *          memory may change as soon as another thread writes to the area,
+ *          use tcv_copy_user_writable_eeprom() for a stable copy.
  * \param	tcv Pointer to transceiver structure
  * \return	memory at byte 128-247 of page a2
  */
@@ -1049,6 +1192,18 @@ const uint8_t* tcv_get_user_writable_eeprom(tcv_t *tcv);
 
 /******************************************************************************/
 
+/**
+ * \brief	Copy the user writable eeprom area of page a2
+ * \param	tcv Pointer to transceiver structure
+ * \param	buf (out) copy of byte 128 onwards
+ * \param	len size of buf, at most tcv_get_user_writable_eeprom_size() bytes
+ * 			are copied
+ * \return	number of bytes copied, error code < 0 otherwise
+ */
+int tcv_copy_user_writable_eeprom(tcv_t *tcv, uint8_t *buf, size_t len);
+
+/******************************************************************************/
+
 /**
  * \brief	Inform the size of user writable eeprom area of page a2
  * \param	tcv Pointer to transceiver structure
@@ -1091,6 +1246,31 @@ int tcv_read(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr, uint8_t* data, size_t
  */
 int tcv_write(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr, const uint8_t* data, size_t len);
 
+/**
+ * \brief	Read from a page of the diagnostics device (A2h).
+ * 			Bytes 128-255 show the page selected by byte 127, the select is
+ * 			only written when the page differs from the last one selected.
+ * \param	tcv	Pointer to transceiver structure
+ * @param page upper memory page
+ * @param regaddr register offset, regaddr + len <= 256
+ * @param data  (out) data read
+ * @param len size of data
+ * @return length read or errorcode
+ */
+int tcv_read_paged(tcv_t *tcv, uint8_t page, uint8_t regaddr, uint8_t* data, size_t len);
+
+/**
+ * \brief	Write to a page of the diagnostics device (A2h), see tcv_read_paged()
+ * 			The page select byte 127 itself cannot be written this way.
+ * \param	tcv	Pointer to transceiver structure
+ * @param page upper memory page
+ * @param regaddr register offset, regaddr + len <= 256
+ * @param data  (in) data write
+ * @param len size of data
+ * @return length written or errorcode
+ */
+int tcv_write_paged(tcv_t *tcv, uint8_t page, uint8_t regaddr, const uint8_t* data, size_t len);
+
 /**
  * Get the temperature of the transceiver as 16-Bit signed (8.8 fixed-point) integer
  * @param tcv
@@ -1155,6 +1335,161 @@ int tcv_get_rx_pwr_warning(tcv_t* tcv, uint16_t* threshold);
  */
 int tcv_get_tx_pwr_warning(tcv_t* tcv, uint16_t* threshold);
 
+/**
+ * \struct tcv_dd_snapshot_t
+ * \brief  All digital diagnostics values taken in one burst
+ */
+typedef struct {
+	int16_t temp;		//! temperature, see tcv_get_temperature()
+	uint16_t vcc;		//! supply voltage, see tcv_get_voltage()
+	uint16_t tx_cur;	//! tx-current, see tcv_get_tx_cur()
+	uint16_t tx_pwr;	//! tx-power, see tcv_get_tx_pwr()
+	uint16_t rx_pwr;	//! rx-power, see tcv_get_rx_pwr()
+	uint64_t timestamp;	//! CLOCK_MONOTONIC time of the read in nanoseconds
+} tcv_dd_snapshot_t;
+
+/**
+ * Read temperature, voltage, tx-current, tx-power and rx-power in a single
+ * I2C transaction and calibrate all of them
+ * \param tcv initialized transceiver @see{tcv_init}
+ * \param snapshot (out) calibrated values
+ * \return	0 if ok; code error otherwise.
+ */
+int tcv_get_dd_snapshot(tcv_t* tcv, tcv_dd_snapshot_t* snapshot);
+
+/**
+ * \struct tcv_dd_cache_stats_t
+ * \brief  Digital diagnostics cache counters since tcv_init()
+ */
+typedef struct {
+	uint64_t hits;		//! values served without I2C access
+	uint64_t misses;	//! values read from the module
+} tcv_dd_cache_stats_t;
+
+/**
+ * Serve the digital diagnostics getters and tcv_get_dd_snapshot() from one
+ * burst read of the measured values, repeated once older than max_age_ms.
+ * Values may therefore be up to max_age_ms old. Writes to A2h and
+ * tcv_refresh() drop the cached values.
+ * \param tcv transceiver handle, may not be initialized yet
+ * \param max_age_ms maximum age of the cached values, 0 disables the cache
+ * \return	0 if ok; code error otherwise.
+ */
+int tcv_set_dd_cache(tcv_t *tcv, uint32_t max_age_ms);
+
+/**
+ * Read the digital diagnostics cache counters
+ * \param tcv initialized transceiver @see{tcv_init}
+ * \param stats (out) counters
+ * \return	0 if ok; code error otherwise.
+ */
+int tcv_get_dd_cache_stats(tcv_t *tcv, tcv_dd_cache_stats_t *stats);
+
+/**
+ * \enum tcv_read_ahead_t
+ * \brief Read-ahead policy of the digital diagnostics getters
+ */
+typedef enum {
+	TCV_READ_AHEAD_OFF = 0,	//! read the requested value only (default)
+	TCV_READ_AHEAD_ON,		//! always read the status region A2h 96-111
+	TCV_READ_AHEAD_AUTO,	//! read the region when cheaper, see tcv_set_read_ahead()
+} tcv_read_ahead_t;
+
+/**
+ * \struct tcv_read_ahead_stats_t
+ * \brief  Read-ahead counters since tcv_init()
+ *
+ * Every getter request is either a fill, a word read or a hit, the hit rate
+ * is hits / (fills + word_reads + hits).
+ */
+typedef struct {
+	uint64_t fills;			//! requests that read the region 96-111
+	uint64_t word_reads;	//! requests that read the requested value only
+	uint64_t hits;			//! requests served from an earlier fill
+	uint64_t bytes_read;	//! bytes read by fills and word reads
+	uint64_t bytes_saved;	//! bytes served by hits, each also saved a transaction
+	uint32_t xfer_ns;		//! measured cost per bus transaction, 0 if unknown
+	uint32_t byte_ns;		//! measured cost per byte, 0 if unknown
+} tcv_read_ahead_stats_t;
+
+/**
+ * Let the digital diagnostics getters read the whole status region A2h 96-111
+ * instead of the requested value and serve further getters from it. A value
+ * is served from a region read at most once and only within window_ms of
+ * it, so polling one value always reads the module while reading several
+ * values in a row costs one transaction.
+ *
+ * TCV_READ_AHEAD_AUTO times the reads of the handle to estimate the cost per
+ * transaction and per byte, counts how many values are requested per window
+ * and reads the region only when that is cheaper than the single reads it
+ * replaces. Values covered by tcv_set_dd_cache() are served from that cache.
+ * \param tcv transceiver handle, may not be initialized yet
+ * \param mode read-ahead policy
+ * \param window_ms lifetime of a region read, > 0 unless mode is off
+ * \return	0 if ok; code error otherwise.
+ */
+int tcv_set_read_ahead(tcv_t *tcv, tcv_read_ahead_t mode, uint32_t window_ms);
+
+/**
+ * Read the read-ahead counters and cost estimates
+ * \param tcv initialized transceiver @see{tcv_init}
+ * \param stats (out) counters
+ * \return	0 if ok; code error otherwise.
+ */
+int tcv_get_read_ahead_stats(tcv_t *tcv, tcv_read_ahead_stats_t *stats);
+
+/**
+ * \struct tcv_lock_stats_t
+ * \brief  Contention counters of one handle lock since tcv_create()
+ *
+ * Bus transfers run under the I/O lock, lifecycle checks, transport
+ * capabilities and counters under the state lock. Only contended
+ * acquisitions are timed.
+ */
+typedef struct {
+	uint64_t acquired;	//! times the lock was taken
+	uint64_t contended;	//! times it was held by another thread
+	uint64_t wait_ns;	//! total time spent waiting for it
+} tcv_lock_stats_t;
+
+/**
+ * Read the contention counters of the handle locks, without taking them
+ * \param tcv transceiver handle, may not be initialized yet
+ * \param io (out) I/O lock counters, may be NULL
+ * \param state (out) state lock counters, may be NULL
+ * \return	0 if ok; code error otherwise.
+ */
+int tcv_get_lock_stats(tcv_t *tcv, tcv_lock_stats_t *io, tcv_lock_stats_t *state);
+
+/** Buckets of tcv_lock_hist_t */
+#define TCV_LOCK_HIST_BUCKETS	20
+
+/**
+ * \struct tcv_lock_hist_t
+ * \brief  Wait and hold time histograms of one handle lock since tcv_create()
+ *
+ * Bucket 0 counts durations below 1 us, bucket i durations from 2^(i-1) us
+ * up to 2^i us, the last bucket also everything longer. Hold times of the
+ * state lock cover writers only.
+ */
+typedef struct {
+	uint64_t wait[TCV_LOCK_HIST_BUCKETS];	//! time from request to acquisition
+	uint64_t hold[TCV_LOCK_HIST_BUCKETS];	//! time from acquisition to release
+	uint64_t max_wait_ns;	//! longest wait
+	uint64_t max_hold_ns;	//! longest hold
+} tcv_lock_hist_t;
+
+/**
+ * Read the lock histograms of a library built with -DLOCK_DEBUG=On, which
+ * defines TCV_LOCK_DEBUG. That build also aborts with a report instead of
+ * deadlocking when a thread takes a handle lock it holds already.
+ * \param tcv transceiver handle, may not be initialized yet
+ * \param io (out) I/O lock histograms, may be NULL
+ * \param state (out) state lock histograms, may be NULL
+ * \return	0 if ok; TCV_ERR_FEATURE_NOT_AVAILABLE without TCV_LOCK_DEBUG,
+ *          code error otherwise.
+ */
+int tcv_get_lock_histograms(tcv_t *tcv, tcv_lock_hist_t *io, tcv_lock_hist_t *state);
 
 #ifdef __cplusplus
 } /*extern "C" */
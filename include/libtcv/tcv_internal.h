@@ -41,6 +41,7 @@
 #include <stdbool.h>
 /* include public interface */
 #include "libtcv/tcv.h"
+#include "libtcv/eeprom_write.h"
 
 /**
  * \brief	Generic transceiver structure.
@@ -49,73 +50,109 @@
  */
 struct tcv_t{
 	int index;				//! Port index referent to TCV port.
-	i2c_read_cb_t read;		//! Callback to I2C read function.
-	i2c_write_cb_t write;	//! Callback to I2C write function.
+	void *ctx;				//! User context passed to read() and write()
+	i2c_read_ex_cb_t read;		//! Callback to I2C read function.
+	i2c_write_ex_cb_t write;	//! Callback to I2C write function.
+	i2c_read_cb_t legacy_read;		//! tcv_create() read callback, if any
+	i2c_write_cb_t legacy_write;	//! tcv_create() write callback, if any
+	i2c_readv_cb_t readv;	//! Optional vectored read callback
+	tcv_transport_caps_t caps;	//! Adapter limits
+	size_t xfer_max;		//! Largest single transfer derived from caps
+	struct tcv_queue *queue;	//! Asynchronous request queue, if attached
+	struct tcv_bus *bus;	//! Shared bus, if attached
+	struct tcv_bus *bus_wake;	//! Bus to wake the waiters of at tcv_io_unlock()
+	int bus_channel;		//! Mux channel on bus
+	struct tcv_eeprom_cache *eeprom_cache;	//! Persistent A0h images, if attached
+	struct tcv_image_store *image_store;	//! Shared A0h images, if attached
+	tcv_write_config_t wcfg;	//! EEPROM write engine parameters
+	struct tcv_write_pending *pending;	//! Deferred writes, see tcv_flush()
+	bool lazy_init;			//! Read A0h beyond the MSA fields on demand
+	uint64_t dd_max_age_ns;	//! Diagnostics cache lifetime, 0 if disabled
+	tcv_read_ahead_t read_ahead;	//! Diagnostics read-ahead policy
+	uint64_t read_ahead_window_ns;	//! Lifetime of a read-ahead region read
 	const struct tcv_functions * fun; //! Transceiver methods
+	struct tcv_sync *sync;	//! Static data publication and lock counters
 	/** TCV internal data - don't touch !*/
 	void *data;
-	pthread_mutex_t lock; //! Lock for library functions
+	pthread_mutex_t io_lock; //! Module access and module data, see tcv_io_lock()
+	pthread_rwlock_t state_lock; //! What cheap queries read, see tcv_state_rdlock()
 	bool created; //! tcv has been initialized by tcv_create()
 	bool initialized; //! tcv has been initialized by tcv_init()
 };
 
 
+struct tcv_static;
+
 /**
  * \brief Transceiver methods
  *
- * generic get/set operations on transceivers
+ * generic get/set operations on transceivers. The static getters get the
+ * static data their caller acquired and must not load it again.
  */
 struct tcv_functions {
-	int (*get_identifier)(tcv_t *);
-	int (*get_ext_identifier)(tcv_t *);
-	int (*get_connector)(tcv_t *);
-	int (*get_vendor_name)(tcv_t *, char* name);
-	int (*get_vendor_oui)(tcv_t *);
-	int (*get_vendor_revision)(tcv_t *, char* rev);
-	int (*get_vendor_part_number)(tcv_t *, char* pn);
-	int (*get_vendor_serial_number)(tcv_t *, char* sn);
-	int (*get_vendor_date_code)(tcv_t *, tcv_date_code_t *);
+	int (*get_identifier)(const struct tcv_static *);
+	int (*get_ext_identifier)(const struct tcv_static *);
+	int (*get_connector)(const struct tcv_static *);
+	int (*get_vendor_name)(const struct tcv_static *, char* name);
+	int (*get_vendor_oui)(const struct tcv_static *);
+	int (*get_vendor_revision)(const struct tcv_static *, char* rev);
+	int (*get_vendor_part_number)(const struct tcv_static *, char* pn);
+	int (*get_vendor_serial_number)(const struct tcv_static *, char* sn);
+	int (*get_vendor_date_code)(const struct tcv_static *, tcv_date_code_t *);
 	const uint8_t* (*get_vendor_rom)(tcv_t *);
 	size_t (*get_vendor_rom_size)(tcv_t *);
 	const uint8_t* (*get_user_writable_eeprom)(tcv_t *);
 	size_t (*get_user_writable_eeprom_size)(tcv_t *);
-	int (*get_10g_compliance_codes)(tcv_t *, tcv_10g_eth_compliance_codes_t *);
-	int (*get_infiniband_compliance_codes)(tcv_t *,
+	int (*get_10g_compliance_codes)(const struct tcv_static *,
+	                                tcv_10g_eth_compliance_codes_t *);
+	int (*get_infiniband_compliance_codes)(const struct tcv_static *,
 	                                       tcv_infiniband_compliance_codes_t *);
-	int (*get_escon_compliance_codes)(tcv_t *, tcv_escon_compliance_codes_t *);
-	int (*get_sonet_compliance_codes)(tcv_t *, tcv_sonet_compliance_codes_t *);
-	int (*get_eth_compliance_codes)(tcv_t *, tcv_eth_compliance_codes_t *);
-	int (*get_fibre_channel_link_length)(tcv_t *,
+	int (*get_escon_compliance_codes)(const struct tcv_static *,
+	                                  tcv_escon_compliance_codes_t *);
+	int (*get_sonet_compliance_codes)(const struct tcv_static *,
+	                                  tcv_sonet_compliance_codes_t *);
+	int (*get_eth_compliance_codes)(const struct tcv_static *,
+	                                tcv_eth_compliance_codes_t *);
+	int (*get_fibre_channel_link_length)(const struct tcv_static *,
 	                                     tcv_fibre_channel_link_length_t *);
-	int (*get_fibre_channel_technology)(tcv_t *,
+	int (*get_fibre_channel_technology)(const struct tcv_static *,
 	                                    tcv_fibre_channel_technology_t *);
-	int (*get_sfp_plus_cable_technology)(tcv_t *,
+	int (*get_sfp_plus_cable_technology)(const struct tcv_static *,
 	                                     sfp_plus_cable_technology_t *);
-	int (*get_fibre_channel_media)(tcv_t *, tcv_fibre_channel_media_t *);
-	int (*get_fibre_channel_speed)(tcv_t *, fibre_channel_speed_t *);
-	int (*get_encoding)(tcv_t*);
-	int (*get_nominal_bit_rate)(tcv_t*);
-	int (*get_rate_identifier)(tcv_t*);
-	int (*get_sm_length)(tcv_t *);
-	int (*get_max_bit_rate)(tcv_t*);
-	int (*get_min_bit_rate)(tcv_t*);
-	int (*get_diagnostic_type)(tcv_t *, tcv_diagnostic_type_t *);
-	int (*get_enhanced_options)(tcv_t *, tcv_enhanced_options_type_t *);
-	int (*get_cc_ext)(tcv_t*);
-	int (*calculate_cc_ext)(tcv_t *);
-	int (*get_om1_length)(tcv_t *);
-	int (*get_om2_length)(tcv_t *);
-	int (*get_om3_length)(tcv_t *);
-	int (*get_om4_copper_length)(tcv_t *);
-	int (*get_wave_len)(tcv_t*);
-	int (*get_passive_cable_compliance)(tcv_t *, passive_cable_compliance_t *);
-	int (*get_active_cable_compliance)(tcv_t *, active_cable_compliance_t *);
-	int (*get_cc_base)(tcv_t*);
-	int (*calculate_cc_base)(tcv_t *);
-	int (*get_implemented_options)(tcv_t *, tcv_implemented_options_t *);
+	int (*get_fibre_channel_media)(const struct tcv_static *,
+	                               tcv_fibre_channel_media_t *);
+	int (*get_fibre_channel_speed)(const struct tcv_static *,
+	                               fibre_channel_speed_t *);
+	int (*get_encoding)(const struct tcv_static *);
+	int (*get_nominal_bit_rate)(const struct tcv_static *);
+	int (*get_rate_identifier)(const struct tcv_static *);
+	int (*get_sm_length)(const struct tcv_static *);
+	int (*get_max_bit_rate)(const struct tcv_static *);
+	int (*get_min_bit_rate)(const struct tcv_static *);
+	int (*get_diagnostic_type)(const struct tcv_static *,
+	                           tcv_diagnostic_type_t *);
+	int (*get_enhanced_options)(const struct tcv_static *,
+	                            tcv_enhanced_options_type_t *);
+	int (*get_cc_ext)(const struct tcv_static *);
+	int (*calculate_cc_ext)(const struct tcv_static *);
+	int (*get_om1_length)(const struct tcv_static *);
+	int (*get_om2_length)(const struct tcv_static *);
+	int (*get_om3_length)(const struct tcv_static *);
+	int (*get_om4_copper_length)(const struct tcv_static *);
+	int (*get_wave_len)(const struct tcv_static *);
+	int (*get_passive_cable_compliance)(const struct tcv_static *,
+	                                    passive_cable_compliance_t *);
+	int (*get_active_cable_compliance)(const struct tcv_static *,
+	                                   active_cable_compliance_t *);
+	int (*get_cc_base)(const struct tcv_static *);
+	int (*calculate_cc_base)(const struct tcv_static *);
+	int (*get_implemented_options)(const struct tcv_static *,
+	                               tcv_implemented_options_t *);
 	const uint8_t* (*get_8079_rom)(tcv_t *);
 	int (*raw_read)(tcv_t *, uint8_t, uint8_t, uint8_t*, size_t);
 	int (*raw_write)(tcv_t *, uint8_t, uint8_t, const uint8_t*, size_t);
+	int (*read_paged)(tcv_t *, uint8_t, uint8_t, uint8_t*, size_t);
+	int (*write_paged)(tcv_t *, uint8_t, uint8_t, const uint8_t*, size_t);
 	/* digital diagnostics */
 	int (*get_rx_pwr)(tcv_t*, uint16_t*);
 	int (*get_tx_pwr)(tcv_t*, uint16_t*);
@@ -125,7 +162,323 @@ struct tcv_functions {
 	int (*get_temp_high_warning)(tcv_t*, uint16_t*);
 	int (*get_tx_pwr_high_warning)(tcv_t*, uint16_t*);
 	int (*get_rx_pwr_high_warning)(tcv_t*, uint16_t*);
+	int (*get_dd_snapshot)(tcv_t*, tcv_dd_snapshot_t*);
+	/* complete A0h image, read on demand if loaded lazily */
+	int (*get_a0_image)(tcv_t*, uint8_t*, size_t);
+	int (*get_dd_cache_stats)(tcv_t*, tcv_dd_cache_stats_t*);
+	int (*get_read_ahead_stats)(tcv_t*, tcv_read_ahead_stats_t*);
+	/* queued snapshots: region to read, then its conversion */
+	int (*prepare_dd_snapshot)(tcv_t*, tcv_i2c_segment_t*);
+	int (*decode_dd_snapshot)(tcv_t*, const uint8_t*, tcv_dd_snapshot_t*);
+	int (*refresh)(tcv_t*);
+	/* 0 if the module is unchanged, 1 if it needs init */
+	int (*revalidate)(tcv_t*);
+};
+/******************************************************************************/
+
+/**
+ * \brief Take the I/O lock of a handle
+ *
+ * It serializes module access and guards the module data in tcv->data as
+ * well as the configuration the I/O paths use. It may be held for as long as
+ * the module takes to answer. Neither handle lock is recursive: code holding
+ * one calls the module functions, not the public API of the same handle.
+ * \param tcv valid transceiver handle
+ */
+void tcv_io_lock(tcv_t *tcv);
+
+/**
+ * \brief Release the I/O lock
+ * \param tcv transceiver handle
+ */
+void tcv_io_unlock(tcv_t *tcv);
+
+/**
+ * \brief Take the state lock of a handle for reading
+ *
+ * It guards what cheap queries read: the lifecycle fields initialized, data
+ * and fun, the transport capabilities and the module counters. It is only
+ * held for short updates, writers that also need the I/O lock take that one
+ * first, so code holding the I/O lock may read these fields without it.
+ * \param tcv valid transceiver handle
+ */
+void tcv_state_rdlock(tcv_t *tcv);
+
+/**
+ * \brief Take the state lock of a handle for writing
+ * \param tcv valid transceiver handle
+ */
+void tcv_state_wrlock(tcv_t *tcv);
+
+/**
+ * \brief Release the state lock
+ * \param tcv transceiver handle
+ */
+void tcv_state_unlock(tcv_t *tcv);
+
+/******************************************************************************/
+
+/**
+ * \brief Static data of an initialized handle
+ *
+ * Modules publish it at init and the static getters read it without
+ * taking a lock. A published entry is never modified: it is replaced as a whole
+ * and freed once no getter can be using it anymore. Modules embed it as the
+ * first member of their own static data.
+ */
+struct tcv_static {
+	const struct tcv_functions *fun;	//! Transceiver methods
+	void (*free)(struct tcv_static *);	//! Release an entry nobody uses
+	struct tcv_static *retired;	//! Next replaced entry waiting to be freed
+};
+
+/**
+ * \brief Start using the published static data, lock-free. Callers pass the
+ *        returned entry down instead of loading it again.
+ * \param tcv valid transceiver handle, need not be locked
+ * \param slot (out) to hand to tcv_static_release()
+ * \return static data, NULL if the handle is not initialized. Valid until
+ *         tcv_static_release(), which must be called in any case.
+ */
+const struct tcv_static *tcv_static_acquire(tcv_t *tcv, unsigned *slot);
+
+/**
+ * \brief Stop using the static data of tcv_static_acquire()
+ * \param tcv transceiver handle
+ * \param slot as returned by tcv_static_acquire()
+ */
+void tcv_static_release(tcv_t *tcv, unsigned slot);
+
+/**
+ * \brief Published static data, for callers that hold the I/O lock
+ * \param tcv transceiver handle
+ * \return static data, NULL if the handle is not initialized
+ */
+const struct tcv_static *tcv_static_get(const tcv_t *tcv);
+
+/**
+ * \brief Replace the published static data in one step, getters see either
+ *        entry. The previous entry is freed by tcv_init() or tcv_destroy()
+ *        once the getters that may use it have returned, so pointers into it
+ *        stay valid until then.
+ * \param tcv transceiver handle, I/O locked
+ * \param st new static data, NULL to unpublish
+ */
+void tcv_static_publish(tcv_t *tcv, struct tcv_static *st);
+
+/******************************************************************************/
+
+/**
+ * \brief Read several register regions, in one batch if the transport supports
+ * 		  vectored reads, one read() per segment otherwise
+ * \param tcv transceiver handle
+ * \param segs segments to be read
+ * \param nsegs number of segments
+ * \return 0 if ok, error code otherwise
+ */
+int tcv_readv(tcv_t *tcv, const tcv_i2c_segment_t *segs, size_t nsegs);
+
+/******************************************************************************/
+/**
+ * \brief Read through the read() callback in chunks the adapter can handle
+ * \param tcv transceiver handle, I/O locked
+ * \param devaddr device address
+ * \param regaddr first register address
+ * \param data (out) register content
+ * \param len number of bytes
+ * \return 0 or the byte count reported by the callback, error code < 0 otherwise
+ */
+int tcv_xfer_read(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr,
+                  uint8_t *data, size_t len);
+
+/**
+ * \brief Write through the write() callback in chunks the adapter can handle
+ * \param tcv transceiver handle, I/O locked
+ * \param devaddr device address
+ * \param regaddr first register address
+ * \param data data to write
+ * \param len number of bytes
+ * \return 0 or the byte count reported by the callback, error code < 0 otherwise
+ */
+int tcv_xfer_write(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr,
+                   const uint8_t *data, size_t len);
+
+/** Size of the images of struct tcv_image_store */
+#define TCV_IMAGE_SIZE		256
+
+/**
+ * \brief Share an image with the other users of the store
+ * \param store image store
+ * \param image TCV_IMAGE_SIZE bytes
+ * \return read-only copy to be given back by tcv_image_release(), NULL if
+ *         out of memory
+ */
+const uint8_t *tcv_image_intern(struct tcv_image_store *store, const uint8_t *image);
+
+/**
+ * \brief Give back an image of tcv_image_intern()
+ * \param store image store
+ * \param image interned copy
+ */
+void tcv_image_release(struct tcv_image_store *store, const uint8_t *image);
+
+/******************************************************************************/
+/**
+ * \brief tcv_xfer_write() in EEPROM pages, waiting for the write cycle of
+ *        every page and verifying it as configured by tcv_set_write_config()
+ * \param tcv transceiver handle, I/O locked
+ * \param devaddr device address
+ * \param regaddr first register address
+ * \param data data to write
+ * \param len number of bytes
+ * \return 0 or the byte count reported by the callback, error code < 0 otherwise
+ */
+int tcv_xfer_write_eeprom(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr,
+                          const uint8_t *data, size_t len);
+
+/**
+ * \brief Drop the deferred writes of a handle
+ * \param tcv transceiver handle, I/O locked
+ */
+void tcv_write_pending_free(tcv_t *tcv);
+
+/******************************************************************************/
+/**
+ * \brief Take the handle's bus exclusively and route its mux channel, no-op
+ *        without bus. Waits for the transfers of other handles, except for an
+ *        asynchronous request the calling thread is to complete.
+ * \param tcv transceiver handle, I/O locked
+ * \return 0 if ok, TCV_ERR_BUSY while an asynchronous request driven by the
+ *         calling thread holds the bus, error code otherwise (bus not taken)
+ */
+int tcv_bus_enter(tcv_t *tcv);
+
+/**
+ * \brief Release the bus taken by tcv_bus_enter(). Waiters are woken when the
+ *        I/O lock is released, their completions may need it.
+ * \param tcv transceiver handle, I/O locked
+ * \param status transfer status, the cached mux channel is dropped on error
+ */
+void tcv_bus_leave(tcv_t *tcv, int status);
+
+/**
+ * \brief Waits for a bus taken by someone else, see tcv_bus_try_enter()
+ */
+struct tcv_bus_waiter {
+	struct tcv_bus_waiter *next;	//! Next waiter of the same bus
+	struct tcv_bus *bus;	//! Bus waited for, NULL if none
+	bool waking;	//! wake() is running
+	void (*wake)(struct tcv_bus_waiter *);	//! The bus was released, retry
+};
+
+/**
+ * \brief Take the handle's bus for an asynchronous request without waiting.
+ *        If it is busy, w->wake() is called once it is released. May be
+ *        released from another thread with tcv_bus_leave_async().
+ * \param tcv transceiver handle
+ * \param w waiter, at most one bus at a time
+ * \param driver thread that completes the request, tcv_bus_enter() does not
+ *        wait for it in that thread
+ * \return 0 if ok, TCV_ERR_BUSY if w waits, error code otherwise
+ */
+int tcv_bus_try_enter(tcv_t *tcv, struct tcv_bus_waiter *w, pthread_t driver);
+
+/**
+ * \brief Release the bus taken by tcv_bus_try_enter() and wake its waiters
+ * \param tcv transceiver handle, not I/O locked
+ * \param status transfer status, the cached mux channel is dropped on error
+ */
+void tcv_bus_leave_async(tcv_t *tcv, int status);
+
+/**
+ * \brief Call the waiters of a bus pinned by a release
+ * \param bus bus
+ */
+void tcv_bus_wake(struct tcv_bus *bus);
+
+/**
+ * \brief Stop waiting, returns once no wake() of w runs anymore
+ * \param w waiter
+ */
+void tcv_bus_unwait(struct tcv_bus_waiter *w);
+
+/**
+ * \brief Check if the bus is routed to the handle already
+ * \param tcv transceiver handle
+ * \return true when no mux select is needed
+ */
+bool tcv_bus_on_channel(const tcv_t *tcv);
+
+/******************************************************************************/
+/**
+ * \brief Load the stored image of the handle's port
+ * \param tcv transceiver handle, I/O locked
+ * \param image (out) stored image, undefined on error
+ * \param len image size
+ * \return 0 if ok, error code if there is no cache or no valid image
+ */
+int tcv_eeprom_cache_load(tcv_t *tcv, uint8_t *image, size_t len);
+
+/**
+ * \brief Replace the stored image of the handle's port, no-op without cache
+ * \param tcv transceiver handle, I/O locked
+ * \param image image read from the module
+ * \param len image size
+ */
+void tcv_eeprom_cache_store(tcv_t *tcv, const uint8_t *image, size_t len);
+
+/**
+ * \brief Remove the stored image of the handle's port, no-op without cache
+ * \param tcv transceiver handle, I/O locked
+ */
+void tcv_eeprom_cache_drop(tcv_t *tcv);
+
+/**
+ * \brief Count a reused (hit) or replaced image, no-op without cache
+ * \param tcv transceiver handle, I/O locked
+ * \param hit stored image was valid
+ */
+void tcv_eeprom_cache_account(tcv_t *tcv, bool hit);
+
+/******************************************************************************/
+/**
+ * \brief Handles sharing one bus, see tcv_group_by_bus()
+ */
+struct tcv_bus_group {
+	size_t first;	//! first entry of the group in order
+	size_t count;	//! number of handles
+	bool serial;	//! attached to a tcv_bus_t, used by one handle at a time
 };
+
+/**
+ * \brief Group handles by the bus they are attached to, largest group first
+ *
+ * Handles without bus and invalid handles get a group of their own. Within
+ * a group the handles keep their order.
+ * \param handles handles, entries may be NULL
+ * \param n number of handles
+ * \param order (out) n handle indices, grouped
+ * \param groups (out) up to n groups
+ * \return number of groups, error code < 0 otherwise
+ */
+int tcv_group_by_bus(tcv_t **handles, size_t n, size_t *order,
+                     struct tcv_bus_group *groups);
+
+/******************************************************************************/
+/**
+ * \brief Time the module functions base their timing decisions on, like
+ *        read-ahead costs and cache ages
+ * \return nanoseconds, CLOCK_MONOTONIC unless replaced
+ */
+uint64_t tcv_clock_ns(void);
+
+/**
+ * \brief Replace the clock of tcv_clock_ns(), for tests simulating bus timing.
+ *        Not thread safe, set it while no handle is in use.
+ * \param now_ns clock in nanoseconds, NULL for CLOCK_MONOTONIC
+ */
+void tcv_set_clock(uint64_t (*now_ns)(void));
+
 /******************************************************************************/
 
 #endif /* TCV_INTERNAL_H_ */
@@ -0,0 +1,771 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Asynchronous request queues, see libtcv/async.h
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+
+#include "libtcv/async.h"
+#include "libtcv/tcv_internal.h"
+
+/** Largest digital diagnostics region a queued snapshot can read */
+#define AIO_RAW_MAX		16
+/** Times the oldest request yields to requests on the current mux channel */
+#define AIO_MAX_SKIP	16
+/** aio_start() result: the bus is busy, the queue is woken once it is free */
+#define AIO_WAIT		1
+
+enum aio_kind {
+	AIO_READ,
+	AIO_DD_SNAPSHOT,
+};
+
+struct tcv_aio_req {
+	struct tcv_aio_req *next;
+	tcv_queue_t *q;
+	tcv_t *tcv;
+	enum aio_kind kind;
+	uint8_t devaddr;
+	uint8_t regaddr;
+	uint8_t *data;			//! destination, raw for snapshots
+	size_t len;
+	size_t done;			//! bytes transferred so far
+	size_t chunk;			//! size of the transfer in flight
+	size_t max_xfer;		//! transport limit of the handle
+	bool bus_held;			//! bus taken until the last chunk completes
+	unsigned int skipped;	//! times passed over for another mux channel
+	tcv_dd_snapshot_t *snapshot;
+	uint8_t raw[AIO_RAW_MAX];
+	int status;				//! result, kept until the loop dispatches it
+	tcv_aio_cb_t cb;
+	void *arg;
+};
+
+struct tcv_queue {
+	struct tcv_bus_waiter bus_wait;	//! first, see queue_bus_free()
+	const tcv_aio_ops_t *ops;
+	pthread_mutex_t lock;
+	struct tcv_aio_req *head;	//! next request to start
+	struct tcv_aio_req *tail;
+	struct tcv_aio_req *inflight;	//! request owned by the transport
+	size_t pending;			//! queued and in flight
+	bool kicking;			//! a thread is starting requests
+	bool again;				//! kicked meanwhile, the kicking thread retries
+	pthread_t driver;		//! last submitted or completed, see tcv_bus_try_enter()
+	tcv_loop_t *loop;		//! dispatching completions, if bound
+	struct tcv_queue *loop_next;	//! next queue bound to the same loop
+};
+
+struct tcv_loop {
+	int fd;					//! eventfd, readable while work is pending
+	pthread_mutex_t lock;	//! protects done and queues
+	struct tcv_aio_req *done_head;	//! completions to dispatch
+	struct tcv_aio_req *done_tail;
+	tcv_queue_t *queues;	//! bound queues
+};
+
+static void queue_bus_free(struct tcv_bus_waiter *w);
+
+/******************************************************************************/
+
+tcv_queue_t *tcv_queue_create(const tcv_aio_ops_t *ops)
+{
+	tcv_queue_t *q;
+
+	if (ops && !ops->submit_read)
+		return NULL;
+
+	q = malloc(sizeof(tcv_queue_t));
+	if (!q)
+		return NULL;
+
+	if (pthread_mutex_init(&q->lock, NULL)) {
+		free(q);
+		return NULL;
+	}
+
+	q->ops = ops;
+	q->head = NULL;
+	q->tail = NULL;
+	q->inflight = NULL;
+	q->pending = 0;
+	q->kicking = false;
+	q->again = false;
+	q->driver = pthread_self();
+	q->bus_wait.next = NULL;
+	q->bus_wait.bus = NULL;
+	q->bus_wait.waking = false;
+	q->bus_wait.wake = queue_bus_free;
+	q->loop = NULL;
+	q->loop_next = NULL;
+	return q;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Make the loop's descriptor readable
+ * \param loop loop
+ */
+static void loop_signal(tcv_loop_t *loop)
+{
+	uint64_t one = 1;
+
+	/* counter saturation only means it is readable already */
+	if (write(loop->fd, &one, sizeof(one)) < 0)
+		return;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Convert the data of a finished request and call its callback
+ * \param req request, freed
+ * \param status transfer status
+ */
+static void aio_finish(struct tcv_aio_req *req, int status)
+{
+	tcv_t *tcv = req->tcv;
+
+	if (status >= 0 && req->kind == AIO_DD_SNAPSHOT) {
+		tcv_io_lock(tcv);
+		status = tcv->fun->decode_dd_snapshot(tcv, req->raw, req->snapshot);
+		tcv_io_unlock(tcv);
+	}
+
+	/* transports may report byte counts */
+	if (status > 0)
+		status = 0;
+
+	req->cb(tcv, status, req->arg);
+	free(req);
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Finish a request now, or hand it to the loop of its queue
+ * \param req request, queue not locked
+ * \param status transfer status
+ */
+static void aio_done(struct tcv_aio_req *req, int status)
+{
+	tcv_loop_t *loop = req->q->loop;
+
+	if (!loop) {
+		aio_finish(req, status);
+		return;
+	}
+
+	req->status = status;
+	req->next = NULL;
+	pthread_mutex_lock(&loop->lock);
+	if (loop->done_tail)
+		loop->done_tail->next = req;
+	else
+		loop->done_head = req;
+	loop->done_tail = req;
+	pthread_mutex_unlock(&loop->lock);
+
+	loop_signal(loop);
+}
+
+/******************************************************************************/
+
+int tcv_queue_destroy(tcv_queue_t *q)
+{
+	struct tcv_aio_req *req, *next;
+
+	if (!q)
+		return TCV_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&q->lock);
+	if (q->inflight || q->kicking) {
+		pthread_mutex_unlock(&q->lock);
+		return TCV_ERR_BUSY;
+	}
+	req = q->head;
+	q->head = NULL;
+	q->tail = NULL;
+	pthread_mutex_unlock(&q->lock);
+
+	/* a wake running meanwhile finds nothing to start */
+	tcv_bus_unwait(&q->bus_wait);
+
+	for (; req; req = next) {
+		next = req->next;
+		aio_finish(req, TCV_ERR_CANCELED);
+	}
+
+	tcv_queue_set_loop(q, NULL);
+	pthread_mutex_destroy(&q->lock);
+	free(q);
+	return 0;
+}
+
+/******************************************************************************/
+
+size_t tcv_queue_pending(tcv_queue_t *q)
+{
+	size_t pending;
+
+	if (!q)
+		return 0;
+
+	pthread_mutex_lock(&q->lock);
+	pending = q->pending;
+	pthread_mutex_unlock(&q->lock);
+	return pending;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Hand the next chunk of a request to the transport, taking the bus
+ *        of the handle for the whole request
+ * \param req request
+ * \param driver thread expected to complete it
+ * \return 0 if started, AIO_WAIT if the bus is busy, transport status
+ *         otherwise: no completion follows
+ */
+static int aio_start(struct tcv_aio_req *req, pthread_t driver)
+{
+	size_t left = req->len - req->done;
+	int ret;
+
+	if (!req->bus_held) {
+		ret = tcv_bus_try_enter(req->tcv, &req->q->bus_wait, driver);
+		if (ret == TCV_ERR_BUSY)
+			return AIO_WAIT;
+		if (ret < 0)
+			return ret;
+		req->bus_held = true;
+	}
+
+	req->chunk = left < req->max_xfer ? left : req->max_xfer;
+	ret = req->q->ops->submit_read(req->tcv->ctx, req, req->devaddr,
+	                               req->regaddr + req->done,
+	                               req->data + req->done, req->chunk);
+	if (ret < 0) {
+		tcv_bus_leave_async(req->tcv, ret);
+		req->bus_held = false;
+		return ret;
+	}
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Take the next request to start, queue locked.
+ *
+ * Requests for the mux channel the bus is routed to go first, the oldest
+ * request is passed over at most AIO_MAX_SKIP times.
+ * \param q queue with requests
+ * \return request, unlinked
+ */
+static struct tcv_aio_req *queue_pop(tcv_queue_t *q)
+{
+	struct tcv_aio_req *req = q->head, *prev = NULL;
+
+	if (!req->bus_held && req->skipped < AIO_MAX_SKIP &&
+	    !tcv_bus_on_channel(req->tcv)) {
+		for (prev = req, req = req->next; req; prev = req, req = req->next) {
+			if (req->tcv->bus == q->head->tcv->bus && tcv_bus_on_channel(req->tcv))
+				break;
+		}
+
+		if (req) {
+			q->head->skipped++;
+		} else {
+			req = q->head;
+			prev = NULL;
+		}
+	}
+
+	if (prev)
+		prev->next = req->next;
+	else
+		q->head = req->next;
+	if (q->tail == req)
+		q->tail = prev;
+	req->next = NULL;
+	return req;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Start queued requests while the bus is idle.
+ *
+ * Transports may complete from within submit_read(), the completion then only
+ * clears the in-flight slot and this loop carries on instead of recursing.
+ * A request whose bus is busy stays first, the queue is kicked again when the
+ * bus is released.
+ * \param q queue
+ */
+static void queue_kick(tcv_queue_t *q)
+{
+	struct tcv_aio_req *req;
+	pthread_t driver;
+	int ret;
+
+	pthread_mutex_lock(&q->lock);
+	if (!q->ops) {
+		/* no transport, the loop carries requests out */
+		pthread_mutex_unlock(&q->lock);
+		if (q->loop)
+			loop_signal(q->loop);
+		return;
+	}
+	if (q->kicking) {
+		q->again = true;
+		pthread_mutex_unlock(&q->lock);
+		return;
+	}
+	q->kicking = true;
+
+	do {
+		q->again = false;
+		while (!q->inflight && q->head) {
+			req = queue_pop(q);
+			q->inflight = req;
+			driver = q->driver;
+			pthread_mutex_unlock(&q->lock);
+
+			ret = aio_start(req, driver);
+
+			pthread_mutex_lock(&q->lock);
+			if (ret == AIO_WAIT) {
+				q->inflight = NULL;
+				req->next = q->head;
+				q->head = req;
+				if (!q->tail)
+					q->tail = req;
+				break;
+			}
+			if (ret < 0) {
+				q->inflight = NULL;
+				q->pending--;
+				pthread_mutex_unlock(&q->lock);
+				aio_done(req, ret);
+				pthread_mutex_lock(&q->lock);
+			}
+		}
+	} while (q->again);
+
+	q->kicking = false;
+	pthread_mutex_unlock(&q->lock);
+}
+
+/******************************************************************************/
+
+/**
+ * \brief The bus a request of the queue waits for was released
+ * \param w waiter of the queue
+ */
+static void queue_bus_free(struct tcv_bus_waiter *w)
+{
+	/* bus_wait is the first member */
+	queue_kick((tcv_queue_t *) w);
+}
+
+/******************************************************************************/
+
+void tcv_aio_complete(tcv_aio_req_t *req, int status)
+{
+	tcv_queue_t *q = req->q;
+
+	pthread_mutex_lock(&q->lock);
+	q->inflight = NULL;
+	q->driver = pthread_self();
+
+	if (status >= 0 && req->done + req->chunk < req->len) {
+		/* more chunks, keep the bus for this request */
+		req->done += req->chunk;
+		req->next = q->head;
+		q->head = req;
+		if (!q->tail)
+			q->tail = req;
+		pthread_mutex_unlock(&q->lock);
+		queue_kick(q);
+		return;
+	}
+
+	q->pending--;
+	pthread_mutex_unlock(&q->lock);
+
+	tcv_bus_leave_async(req->tcv, status);
+	req->bus_held = false;
+	aio_done(req, status);
+	queue_kick(q);
+}
+
+/******************************************************************************/
+
+int tcv_set_queue(tcv_t *tcv, tcv_queue_t *q)
+{
+	if (!tcv || !tcv->created)
+		return TCV_ERR_INVALID_ARG;
+
+	tcv_io_lock(tcv);
+	/* Transports get the context, index based handles have none */
+	if (tcv->legacy_read) {
+		tcv_io_unlock(tcv);
+		return TCV_ERR_INVALID_ARG;
+	}
+	tcv->queue = q;
+	tcv_io_unlock(tcv);
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Allocate a request for an initialized handle attached to a queue,
+ *        handle I/O locked
+ * \param tcv handle
+ * \param kind request type
+ * \param cb completion callback
+ * \param arg callback argument
+ * \param req (out) allocated request
+ * \return 0 if ok, error code otherwise
+ */
+static int aio_alloc(tcv_t *tcv, enum aio_kind kind, tcv_aio_cb_t cb,
+                     void *arg, struct tcv_aio_req **req)
+{
+	if (!tcv->initialized)
+		return TCV_ERR_NOT_INITIALIZED;
+
+	/* Without transport only a loop can carry requests out */
+	if (!tcv->queue || (!tcv->queue->ops && !tcv->queue->loop))
+		return TCV_ERR_INVALID_ARG;
+
+	*req = malloc(sizeof(struct tcv_aio_req));
+	if (!*req)
+		return TCV_ERR_GENERIC;
+
+	(*req)->next = NULL;
+	(*req)->q = tcv->queue;
+	(*req)->tcv = tcv;
+	(*req)->kind = kind;
+	(*req)->done = 0;
+	(*req)->chunk = 0;
+	(*req)->max_xfer = tcv->xfer_max;
+	(*req)->bus_held = false;
+	(*req)->skipped = 0;
+	(*req)->snapshot = NULL;
+	(*req)->cb = cb;
+	(*req)->arg = arg;
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Append a request and start it if the bus is idle
+ * \param req request
+ */
+static void aio_enqueue(struct tcv_aio_req *req)
+{
+	tcv_queue_t *q = req->q;
+
+	pthread_mutex_lock(&q->lock);
+	if (q->tail)
+		q->tail->next = req;
+	else
+		q->head = req;
+	q->tail = req;
+	q->pending++;
+	q->driver = pthread_self();
+	pthread_mutex_unlock(&q->lock);
+
+	queue_kick(q);
+}
+
+/******************************************************************************/
+
+int tcv_submit_read(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr,
+                    uint8_t *data, size_t len, tcv_aio_cb_t cb, void *arg)
+{
+	struct tcv_aio_req *req;
+	int ret;
+
+	if (!tcv || !tcv->created || !data || !cb || len == 0)
+		return TCV_ERR_INVALID_ARG;
+
+	if (regaddr + len > 256)
+		return TCV_ERR_INVALID_ARG;
+
+	tcv_io_lock(tcv);
+	ret = aio_alloc(tcv, AIO_READ, cb, arg, &req);
+	tcv_io_unlock(tcv);
+	if (ret < 0)
+		return ret;
+
+	req->devaddr = devaddr;
+	req->regaddr = regaddr;
+	req->data = data;
+	req->len = len;
+
+	aio_enqueue(req);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_submit_dd_snapshot(tcv_t *tcv, tcv_dd_snapshot_t *snapshot,
+                           tcv_aio_cb_t cb, void *arg)
+{
+	struct tcv_aio_req *req;
+	tcv_i2c_segment_t region;
+	int ret;
+
+	if (!tcv || !tcv->created || !snapshot || !cb)
+		return TCV_ERR_INVALID_ARG;
+
+	tcv_io_lock(tcv);
+	ret = aio_alloc(tcv, AIO_DD_SNAPSHOT, cb, arg, &req);
+	if (ret == 0) {
+		if (!tcv->fun->prepare_dd_snapshot || !tcv->fun->decode_dd_snapshot)
+			ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
+		else
+			ret = tcv->fun->prepare_dd_snapshot(tcv, &region);
+
+		if (ret == 0 && region.len > sizeof(req->raw))
+			ret = TCV_ERR_GENERIC;
+		if (ret < 0)
+			free(req);
+	}
+	tcv_io_unlock(tcv);
+	if (ret < 0)
+		return ret;
+
+	req->devaddr = region.devaddr;
+	req->regaddr = region.regaddr;
+	req->data = req->raw;
+	req->len = region.len;
+	req->snapshot = snapshot;
+
+	aio_enqueue(req);
+	return 0;
+}
+
+/******************************************************************************/
+
+tcv_loop_t *tcv_loop_create(void)
+{
+	tcv_loop_t *loop;
+
+	loop = malloc(sizeof(tcv_loop_t));
+	if (!loop)
+		return NULL;
+
+	loop->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (loop->fd < 0) {
+		free(loop);
+		return NULL;
+	}
+
+	if (pthread_mutex_init(&loop->lock, NULL)) {
+		close(loop->fd);
+		free(loop);
+		return NULL;
+	}
+
+	loop->done_head = NULL;
+	loop->done_tail = NULL;
+	loop->queues = NULL;
+	return loop;
+}
+
+/******************************************************************************/
+
+int tcv_loop_destroy(tcv_loop_t *loop)
+{
+	struct tcv_aio_req *req, *next;
+
+	if (!loop)
+		return TCV_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&loop->lock);
+	if (loop->queues) {
+		pthread_mutex_unlock(&loop->lock);
+		return TCV_ERR_BUSY;
+	}
+	req = loop->done_head;
+	pthread_mutex_unlock(&loop->lock);
+
+	for (; req; req = next) {
+		next = req->next;
+		free(req);
+	}
+
+	pthread_mutex_destroy(&loop->lock);
+	close(loop->fd);
+	free(loop);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_loop_get_fd(tcv_loop_t *loop)
+{
+	if (!loop)
+		return TCV_ERR_INVALID_ARG;
+
+	return loop->fd;
+}
+
+/******************************************************************************/
+
+int tcv_queue_set_loop(tcv_queue_t *q, tcv_loop_t *loop)
+{
+	tcv_loop_t *old;
+	tcv_queue_t **pq;
+
+	if (!q)
+		return TCV_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&q->lock);
+	if (q->pending) {
+		pthread_mutex_unlock(&q->lock);
+		return TCV_ERR_BUSY;
+	}
+	old = q->loop;
+	pthread_mutex_unlock(&q->lock);
+
+	if (old == loop)
+		return 0;
+
+	if (old) {
+		pthread_mutex_lock(&old->lock);
+		for (pq = &old->queues; *pq; pq = &(*pq)->loop_next) {
+			if (*pq == q) {
+				*pq = q->loop_next;
+				break;
+			}
+		}
+		pthread_mutex_unlock(&old->lock);
+	}
+
+	if (loop) {
+		pthread_mutex_lock(&loop->lock);
+		q->loop_next = loop->queues;
+		loop->queues = q;
+		pthread_mutex_unlock(&loop->lock);
+	}
+
+	pthread_mutex_lock(&q->lock);
+	q->loop = loop;
+	pthread_mutex_unlock(&q->lock);
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Carry out a request of a queue without transport, marked in flight
+ * \param req request
+ */
+static void queue_run(struct tcv_aio_req *req)
+{
+	tcv_queue_t *q = req->q;
+	tcv_t *tcv = req->tcv;
+	int ret;
+
+	tcv_io_lock(tcv);
+	ret = tcv_xfer_read(tcv, req->devaddr, req->regaddr, req->data, req->len);
+	tcv_io_unlock(tcv);
+
+	pthread_mutex_lock(&q->lock);
+	q->inflight = NULL;
+	q->pending--;
+	pthread_mutex_unlock(&q->lock);
+
+	aio_finish(req, ret);
+}
+
+/******************************************************************************/
+
+int tcv_loop_step(tcv_loop_t *loop)
+{
+	struct tcv_aio_req *req, *next, *run = NULL, **run_tail = &run;
+	tcv_queue_t *q;
+	uint64_t count;
+	bool more = false;
+	int ran = 0;
+
+	if (!loop)
+		return TCV_ERR_INVALID_ARG;
+
+	/* drain first, anything arriving later signals again */
+	if (read(loop->fd, &count, sizeof(count)) < 0)
+		count = 0;
+
+	pthread_mutex_lock(&loop->lock);
+	req = loop->done_head;
+	loop->done_head = NULL;
+	loop->done_tail = NULL;
+
+	/* one request per queue and step keeps the caller's loop responsive,
+	 * in flight they pin their queue until run */
+	for (q = loop->queues; q; q = q->loop_next) {
+		if (q->ops)
+			continue;
+
+		pthread_mutex_lock(&q->lock);
+		if (q->head && !q->inflight) {
+			*run_tail = q->inflight = queue_pop(q);
+			run_tail = &(*run_tail)->next;
+		}
+		more |= q->head != NULL;
+		pthread_mutex_unlock(&q->lock);
+	}
+	pthread_mutex_unlock(&loop->lock);
+
+	for (; req; req = next) {
+		next = req->next;
+		aio_finish(req, req->status);
+		ran++;
+	}
+
+	for (req = run; req; req = next) {
+		next = req->next;
+		queue_run(req);
+		ran++;
+	}
+
+	if (more)
+		loop_signal(loop);
+
+	return ran;
+}
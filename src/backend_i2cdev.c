@@ -0,0 +1,394 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Linux i2c-dev backend, see libtcv/i2cdev.h
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include "libtcv/i2cdev.h"
+#include "libtcv/tcv_internal.h"
+
+/** Largest register window, device address space of 256 bytes */
+#define I2CDEV_MAX_XFER		256
+/** Segments of a vectored read fitting in one I2C_RDWR ioctl */
+#define I2CDEV_MAX_SEGS		(I2C_RDWR_IOCTL_MAX_MSGS / 2)
+
+/**
+ * One opened adapter, used as callback context of every handle on it
+ */
+struct i2cdev_bus {
+	struct i2cdev_bus *next;
+	int bus;				//! bus number
+	int fd;					//! opened device node
+	unsigned long funcs;	//! I2C_FUNC_* reported by the adapter
+	int slave;				//! address selected by I2C_SLAVE_FORCE, -1 if none
+	pthread_mutex_t lock;	//! serializes slave selection + SMBus transfer pairs
+};
+
+struct tcv_i2cdev {
+	char *path_fmt;
+	struct i2cdev_bus *buses;
+	pthread_mutex_t lock;	//! protects buses
+};
+
+/******************************************************************************/
+
+tcv_i2cdev_t *tcv_i2cdev_open(const char *path_fmt)
+{
+	tcv_i2cdev_t *pool;
+
+	pool = malloc(sizeof(tcv_i2cdev_t));
+	if (!pool)
+		return NULL;
+
+	pool->path_fmt = strdup(path_fmt ? path_fmt : TCV_I2CDEV_DEFAULT_PATH);
+	if (!pool->path_fmt) {
+		free(pool);
+		return NULL;
+	}
+
+	if (pthread_mutex_init(&pool->lock, NULL)) {
+		free(pool->path_fmt);
+		free(pool);
+		return NULL;
+	}
+	pool->buses = NULL;
+
+	return pool;
+}
+
+/******************************************************************************/
+
+void tcv_i2cdev_close(tcv_i2cdev_t *pool)
+{
+	struct i2cdev_bus *b, *next;
+
+	if (!pool)
+		return;
+
+	for (b = pool->buses; b; b = next) {
+		next = b->next;
+		close(b->fd);
+		pthread_mutex_destroy(&b->lock);
+		free(b);
+	}
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->path_fmt);
+	free(pool);
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Look up a bus in the pool, open it and query its functionality
+ *        on first use
+ * \param pool bus pool
+ * \param bus bus number
+ * \return bus or NULL if it cannot be opened
+ */
+static struct i2cdev_bus *i2cdev_get_bus(tcv_i2cdev_t *pool, int bus)
+{
+	struct i2cdev_bus *b;
+	char path[256];
+
+	pthread_mutex_lock(&pool->lock);
+
+	for (b = pool->buses; b; b = b->next) {
+		if (b->bus == bus)
+			goto out;
+	}
+
+	b = malloc(sizeof(struct i2cdev_bus));
+	if (!b)
+		goto out;
+
+	snprintf(path, sizeof(path), pool->path_fmt, bus);
+	b->fd = open(path, O_RDWR | O_CLOEXEC);
+	if (b->fd < 0)
+		goto err_free;
+
+	if (ioctl(b->fd, I2C_FUNCS, &b->funcs) < 0)
+		goto err_close;
+
+	if (pthread_mutex_init(&b->lock, NULL))
+		goto err_close;
+
+	b->bus = bus;
+	b->slave = -1;
+	b->next = pool->buses;
+	pool->buses = b;
+	goto out;
+
+err_close:
+	close(b->fd);
+err_free:
+	free(b);
+	b = NULL;
+out:
+	pthread_mutex_unlock(&pool->lock);
+	return b;
+}
+
+/******************************************************************************/
+
+int tcv_i2cdev_get_funcs(tcv_i2cdev_t *pool, int bus, unsigned long *funcs)
+{
+	struct i2cdev_bus *b;
+
+	if (!pool || !funcs)
+		return TCV_ERR_INVALID_ARG;
+
+	b = i2cdev_get_bus(pool, bus);
+	if (!b)
+		return TCV_ERR_GENERIC;
+
+	*funcs = b->funcs;
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Select the slave for following SMBus transfers, bus lock held
+ *
+ * Forced: an at24 or optoe driver bound to the module makes I2C_SLAVE fail
+ * with EBUSY, I2C_RDWR never checks that either.
+ */
+static int i2cdev_set_slave(struct i2cdev_bus *b, uint8_t devaddr)
+{
+	if (b->slave == devaddr)
+		return 0;
+
+	if (ioctl(b->fd, I2C_SLAVE_FORCE, (unsigned long) devaddr) < 0) {
+		b->slave = -1;
+		return TCV_ERR_GENERIC;
+	}
+	b->slave = devaddr;
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Read or write one SMBus I2C block transfer.
+ *        Longer requests are split by the library, see tcv_set_transport_caps()
+ */
+static int i2cdev_smbus_xfer(struct i2cdev_bus *b, char read_write,
+                             uint8_t devaddr, uint8_t regaddr, uint8_t *data,
+                             size_t len)
+{
+	struct i2c_smbus_ioctl_data args;
+	union i2c_smbus_data block;
+	int ret = 0;
+
+	if (len > I2C_SMBUS_BLOCK_MAX)
+		return TCV_ERR_INVALID_ARG;
+
+	block.block[0] = len;
+	if (read_write == I2C_SMBUS_WRITE)
+		memcpy(&block.block[1], data, len);
+
+	args.read_write = read_write;
+	args.command = regaddr;
+	args.size = I2C_SMBUS_I2C_BLOCK_DATA;
+	args.data = &block;
+
+	pthread_mutex_lock(&b->lock);
+	if (i2cdev_set_slave(b, devaddr) < 0 || ioctl(b->fd, I2C_SMBUS, &args) < 0)
+		ret = TCV_ERR_GENERIC;
+	pthread_mutex_unlock(&b->lock);
+
+	if (ret == 0 && read_write == I2C_SMBUS_READ)
+		memcpy(data, &block.block[1], len);
+
+	return ret;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Read callback: pointer write and data read in one I2C_RDWR
+ */
+static int i2cdev_read(void *ctx, uint8_t devaddr, uint8_t regaddr,
+                       uint8_t *data, size_t len)
+{
+	struct i2cdev_bus *b = ctx;
+	struct i2c_msg msgs[2];
+	struct i2c_rdwr_ioctl_data xfer;
+
+	if (len == 0)
+		return 0;
+	if (len > I2CDEV_MAX_XFER)
+		return TCV_ERR_INVALID_ARG;
+
+	if (!(b->funcs & I2C_FUNC_I2C)) {
+		if (!(b->funcs & I2C_FUNC_SMBUS_READ_I2C_BLOCK))
+			return TCV_ERR_FEATURE_NOT_AVAILABLE;
+		return i2cdev_smbus_xfer(b, I2C_SMBUS_READ, devaddr, regaddr, data, len);
+	}
+
+	msgs[0].addr = devaddr;
+	msgs[0].flags = 0;
+	msgs[0].len = 1;
+	msgs[0].buf = &regaddr;
+	msgs[1].addr = devaddr;
+	msgs[1].flags = I2C_M_RD;
+	msgs[1].len = len;
+	msgs[1].buf = data;
+
+	xfer.msgs = msgs;
+	xfer.nmsgs = 2;
+	if (ioctl(b->fd, I2C_RDWR, &xfer) < 0)
+		return TCV_ERR_GENERIC;
+
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Write callback: register address and data in a single message
+ */
+static int i2cdev_write(void *ctx, uint8_t devaddr, uint8_t regaddr,
+                        const uint8_t *data, size_t len)
+{
+	struct i2cdev_bus *b = ctx;
+	uint8_t buf[I2CDEV_MAX_XFER + 1];
+	struct i2c_msg msg;
+	struct i2c_rdwr_ioctl_data xfer;
+
+	if (len > I2CDEV_MAX_XFER)
+		return TCV_ERR_INVALID_ARG;
+
+	if (!(b->funcs & I2C_FUNC_I2C)) {
+		if (!(b->funcs & I2C_FUNC_SMBUS_WRITE_I2C_BLOCK))
+			return TCV_ERR_FEATURE_NOT_AVAILABLE;
+		memcpy(buf, data, len);
+		return i2cdev_smbus_xfer(b, I2C_SMBUS_WRITE, devaddr, regaddr, buf, len);
+	}
+
+	buf[0] = regaddr;
+	memcpy(&buf[1], data, len);
+
+	msg.addr = devaddr;
+	msg.flags = 0;
+	msg.len = len + 1;
+	msg.buf = buf;
+
+	xfer.msgs = &msg;
+	xfer.nmsgs = 1;
+	if (ioctl(b->fd, I2C_RDWR, &xfer) < 0)
+		return TCV_ERR_GENERIC;
+
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Vectored read callback, up to I2CDEV_MAX_SEGS segments per I2C_RDWR
+ */
+static int i2cdev_readv(void *ctx, const tcv_i2c_segment_t *segs, size_t nsegs)
+{
+	struct i2cdev_bus *b = ctx;
+	struct i2c_msg msgs[2 * I2CDEV_MAX_SEGS];
+	uint8_t regs[I2CDEV_MAX_SEGS];
+	struct i2c_rdwr_ioctl_data xfer;
+	size_t i, n;
+
+	while (nsegs) {
+		n = nsegs > I2CDEV_MAX_SEGS ? I2CDEV_MAX_SEGS : nsegs;
+
+		for (i = 0; i < n; i++) {
+			if (segs[i].len > I2CDEV_MAX_XFER)
+				return TCV_ERR_INVALID_ARG;
+
+			regs[i] = segs[i].regaddr;
+			msgs[2 * i].addr = segs[i].devaddr;
+			msgs[2 * i].flags = 0;
+			msgs[2 * i].len = 1;
+			msgs[2 * i].buf = &regs[i];
+			msgs[2 * i + 1].addr = segs[i].devaddr;
+			msgs[2 * i + 1].flags = I2C_M_RD;
+			msgs[2 * i + 1].len = segs[i].len;
+			msgs[2 * i + 1].buf = segs[i].data;
+		}
+
+		xfer.msgs = msgs;
+		xfer.nmsgs = 2 * n;
+		if (ioctl(b->fd, I2C_RDWR, &xfer) < 0)
+			return TCV_ERR_GENERIC;
+
+		segs += n;
+		nsegs -= n;
+	}
+
+	return 0;
+}
+
+/******************************************************************************/
+
+tcv_t *tcv_i2cdev_create(tcv_i2cdev_t *pool, int bus)
+{
+	struct i2cdev_bus *b;
+	tcv_transport_caps_t caps;
+	tcv_t *tcv;
+
+	if (!pool)
+		return NULL;
+
+	b = i2cdev_get_bus(pool, bus);
+	if (!b)
+		return NULL;
+
+	tcv = tcv_create_ex(bus, b, i2cdev_read, i2cdev_write);
+	if (!tcv)
+		return NULL;
+
+	/* Combined messages need a plain I2C adapter */
+	if (b->funcs & I2C_FUNC_I2C) {
+		caps.max_xfer = I2CDEV_MAX_XFER;
+		caps.smbus_only = 0;
+		caps.repeated_start = 1;
+		tcv_set_readv(tcv, i2cdev_readv);
+	} else {
+		caps.max_xfer = I2C_SMBUS_BLOCK_MAX;
+		caps.smbus_only = 1;
+		caps.repeated_start = 0;
+	}
+	tcv_set_transport_caps(tcv, &caps);
+
+	return tcv;
+}
@@ -0,0 +1,407 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Bus topology, see libtcv/bus.h
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "libtcv/bus.h"
+#include "libtcv/tcv_internal.h"
+
+/** Channel cache value when the mux state is unknown */
+#define BUS_CHANNEL_UNKNOWN		(-2)
+
+/** Guards the waiter lists and fields, a waiter moves between buses */
+static pthread_mutex_t bus_wait_lock = PTHREAD_MUTEX_INITIALIZER;
+/** Signalled when a wake() returned */
+static pthread_cond_t bus_woken = PTHREAD_COND_INITIALIZER;
+
+struct tcv_bus {
+	void *ctx;
+	tcv_mux_select_cb_t select;
+	pthread_mutex_t lock;	//! protects everything below but waiters
+	pthread_cond_t idle;	//! signalled when busy is cleared
+	bool busy;				//! owned by a transaction, possibly asynchronous
+	bool async;				//! owned by an asynchronous request
+	pthread_t driver;		//! completes the asynchronous request
+	int channel;			//! selected mux channel or BUS_CHANNEL_UNKNOWN
+	size_t handles;			//! attached handles
+	size_t pins;			//! wakes pending or running
+	struct tcv_bus_waiter *waiters;	//! woken once busy is cleared
+	tcv_bus_stats_t stats;
+};
+
+/******************************************************************************/
+
+tcv_bus_t *tcv_bus_create(void *ctx, tcv_mux_select_cb_t select)
+{
+	tcv_bus_t *bus;
+
+	bus = malloc(sizeof(tcv_bus_t));
+	if (!bus)
+		return NULL;
+
+	if (pthread_mutex_init(&bus->lock, NULL)) {
+		free(bus);
+		return NULL;
+	}
+
+	if (pthread_cond_init(&bus->idle, NULL)) {
+		pthread_mutex_destroy(&bus->lock);
+		free(bus);
+		return NULL;
+	}
+
+	bus->ctx = ctx;
+	bus->select = select;
+	bus->busy = false;
+	bus->async = false;
+	bus->channel = BUS_CHANNEL_UNKNOWN;
+	bus->handles = 0;
+	bus->pins = 0;
+	bus->waiters = NULL;
+	bus->stats.transactions = 0;
+	bus->stats.mux_selects = 0;
+	bus->stats.mux_skipped = 0;
+	return bus;
+}
+
+/******************************************************************************/
+
+int tcv_bus_destroy(tcv_bus_t *bus)
+{
+	if (!bus)
+		return TCV_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&bus->lock);
+	if (bus->handles || bus->pins) {
+		pthread_mutex_unlock(&bus->lock);
+		return TCV_ERR_BUSY;
+	}
+	pthread_mutex_unlock(&bus->lock);
+
+	pthread_cond_destroy(&bus->idle);
+	pthread_mutex_destroy(&bus->lock);
+	free(bus);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_bus_attach(tcv_bus_t *bus, tcv_t *tcv, int channel)
+{
+	if (!bus || !tcv || !tcv->created)
+		return TCV_ERR_INVALID_ARG;
+
+	/* a mux channel needs a mux */
+	if (channel < TCV_BUS_NO_MUX || (channel != TCV_BUS_NO_MUX && !bus->select))
+		return TCV_ERR_INVALID_ARG;
+
+	tcv_io_lock(tcv);
+	if (tcv->bus) {
+		tcv_io_unlock(tcv);
+		return TCV_ERR_INVALID_ARG;
+	}
+	tcv->bus = bus;
+	tcv->bus_channel = channel;
+	tcv_io_unlock(tcv);
+
+	pthread_mutex_lock(&bus->lock);
+	bus->handles++;
+	pthread_mutex_unlock(&bus->lock);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_bus_detach(tcv_t *tcv)
+{
+	tcv_bus_t *bus;
+
+	if (!tcv || !tcv->created)
+		return TCV_ERR_INVALID_ARG;
+
+	tcv_io_lock(tcv);
+	bus = tcv->bus;
+	tcv->bus = NULL;
+	tcv_io_unlock(tcv);
+
+	if (!bus)
+		return TCV_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&bus->lock);
+	bus->handles--;
+	pthread_mutex_unlock(&bus->lock);
+	return 0;
+}
+
+/******************************************************************************/
+
+void tcv_bus_invalidate(tcv_bus_t *bus)
+{
+	if (!bus)
+		return;
+
+	pthread_mutex_lock(&bus->lock);
+	bus->channel = BUS_CHANNEL_UNKNOWN;
+	pthread_mutex_unlock(&bus->lock);
+}
+
+/******************************************************************************/
+
+int tcv_bus_get_stats(tcv_bus_t *bus, tcv_bus_stats_t *stats)
+{
+	if (!bus || !stats)
+		return TCV_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&bus->lock);
+	*stats = bus->stats;
+	pthread_mutex_unlock(&bus->lock);
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Take an idle bus and route it to the handle's mux channel
+ * \param tcv transceiver handle
+ * \param bus bus of the handle, locked and not busy
+ * \param async taken for an asynchronous request
+ * \return 0 if ok, error code otherwise (bus not taken)
+ */
+static int bus_take(tcv_t *tcv, tcv_bus_t *bus, bool async)
+{
+	int ret = 0;
+
+	bus->busy = true;
+	bus->async = async;
+	bus->stats.transactions++;
+
+	if (tcv->bus_channel != TCV_BUS_NO_MUX) {
+		if (bus->channel == tcv->bus_channel) {
+			bus->stats.mux_skipped++;
+		} else {
+			bus->stats.mux_selects++;
+			/* the bus is ours, nobody needs the lock during the write */
+			pthread_mutex_unlock(&bus->lock);
+			ret = bus->select(bus->ctx, tcv->bus_channel);
+			pthread_mutex_lock(&bus->lock);
+			bus->channel = ret < 0 ? BUS_CHANNEL_UNKNOWN : tcv->bus_channel;
+		}
+	}
+
+	if (ret < 0) {
+		bus->busy = false;
+		pthread_cond_signal(&bus->idle);
+	}
+	return ret;
+}
+
+/******************************************************************************/
+
+int tcv_bus_enter(tcv_t *tcv)
+{
+	tcv_bus_t *bus = tcv->bus;
+	int ret;
+
+	if (!bus)
+		return 0;
+
+	pthread_mutex_lock(&bus->lock);
+	while (bus->busy) {
+		/* the request can only complete once this thread returns */
+		if (bus->async && pthread_equal(bus->driver, pthread_self())) {
+			pthread_mutex_unlock(&bus->lock);
+			return TCV_ERR_BUSY;
+		}
+		pthread_cond_wait(&bus->idle, &bus->lock);
+	}
+	ret = bus_take(tcv, bus, false);
+	pthread_mutex_unlock(&bus->lock);
+	return ret;
+}
+
+/******************************************************************************/
+
+int tcv_bus_try_enter(tcv_t *tcv, struct tcv_bus_waiter *w, pthread_t driver)
+{
+	tcv_bus_t *bus = tcv->bus;
+	int ret;
+
+	if (!bus)
+		return 0;
+
+	pthread_mutex_lock(&bus->lock);
+	if (bus->busy) {
+		/* a waiter of another bus is woken by that one and retries */
+		pthread_mutex_lock(&bus_wait_lock);
+		if (!w->bus) {
+			w->next = bus->waiters;
+			bus->waiters = w;
+			w->bus = bus;
+		}
+		pthread_mutex_unlock(&bus_wait_lock);
+		pthread_mutex_unlock(&bus->lock);
+		return TCV_ERR_BUSY;
+	}
+	ret = bus_take(tcv, bus, true);
+	bus->driver = driver;
+	pthread_mutex_unlock(&bus->lock);
+	return ret;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Clear busy
+ * \param tcv transceiver handle
+ * \param bus bus of the handle
+ * \param status transfer status, the cached mux channel is dropped on error
+ * \return true if waiters need to be woken, the bus is pinned until then
+ */
+static bool bus_release(tcv_t *tcv, tcv_bus_t *bus, int status)
+{
+	bool wake;
+
+	pthread_mutex_lock(&bus->lock);
+	/* a failed transfer may have left the mux anywhere */
+	if (status < 0 && tcv->bus_channel != TCV_BUS_NO_MUX)
+		bus->channel = BUS_CHANNEL_UNKNOWN;
+	bus->busy = false;
+	bus->async = false;
+	pthread_cond_signal(&bus->idle);
+
+	pthread_mutex_lock(&bus_wait_lock);
+	wake = bus->waiters != NULL;
+	pthread_mutex_unlock(&bus_wait_lock);
+	if (wake)
+		bus->pins++;
+	pthread_mutex_unlock(&bus->lock);
+	return wake;
+}
+
+/******************************************************************************/
+
+void tcv_bus_leave(tcv_t *tcv, int status)
+{
+	tcv_bus_t *bus = tcv->bus;
+
+	if (!bus || !bus_release(tcv, bus, status))
+		return;
+
+	/* one wake per I/O lock hold is enough */
+	if (tcv->bus_wake) {
+		pthread_mutex_lock(&bus->lock);
+		bus->pins--;
+		pthread_mutex_unlock(&bus->lock);
+	} else {
+		tcv->bus_wake = bus;
+	}
+}
+
+/******************************************************************************/
+
+void tcv_bus_leave_async(tcv_t *tcv, int status)
+{
+	tcv_bus_t *bus = tcv->bus;
+
+	if (bus && bus_release(tcv, bus, status))
+		tcv_bus_wake(bus);
+}
+
+/******************************************************************************/
+
+void tcv_bus_wake(tcv_bus_t *bus)
+{
+	struct tcv_bus_waiter *list, *w;
+
+	/* waiters in list keep bus set, so nobody links them elsewhere while
+	 * list runs through them */
+	pthread_mutex_lock(&bus_wait_lock);
+	list = bus->waiters;
+	bus->waiters = NULL;
+	while ((w = list)) {
+		list = w->next;
+		w->bus = NULL;
+		w->waking = true;
+		pthread_mutex_unlock(&bus_wait_lock);
+
+		w->wake(w);
+
+		pthread_mutex_lock(&bus_wait_lock);
+		w->waking = false;
+		pthread_cond_broadcast(&bus_woken);
+	}
+	pthread_mutex_unlock(&bus_wait_lock);
+
+	pthread_mutex_lock(&bus->lock);
+	bus->pins--;
+	pthread_mutex_unlock(&bus->lock);
+}
+
+/******************************************************************************/
+
+void tcv_bus_unwait(struct tcv_bus_waiter *w)
+{
+	struct tcv_bus_waiter **pw;
+
+	pthread_mutex_lock(&bus_wait_lock);
+	for (;;) {
+		if (w->bus) {
+			for (pw = &w->bus->waiters; *pw; pw = &(*pw)->next) {
+				if (*pw == w) {
+					*pw = w->next;
+					w->bus = NULL;
+					break;
+				}
+			}
+		}
+		/* otherwise a wake has it already */
+		if (!w->bus && !w->waking)
+			break;
+		pthread_cond_wait(&bus_woken, &bus_wait_lock);
+	}
+	pthread_mutex_unlock(&bus_wait_lock);
+}
+
+/******************************************************************************/
+
+bool tcv_bus_on_channel(const tcv_t *tcv)
+{
+	tcv_bus_t *bus = tcv->bus;
+	bool ret;
+
+	if (!bus || tcv->bus_channel == TCV_BUS_NO_MUX)
+		return true;
+
+	pthread_mutex_lock(&bus->lock);
+	ret = bus->channel == tcv->bus_channel;
+	pthread_mutex_unlock(&bus->lock);
+	return ret;
+}
@@ -0,0 +1,294 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Persistent EEPROM cache, see libtcv/eeprom_cache.h
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "libtcv/eeprom_cache.h"
+#include "libtcv/tcv_internal.h"
+
+/** Stored image: header followed by the image */
+#define CACHE_MAGIC			0x41564354u	/* "TCVA" */
+
+struct cache_header {
+	uint32_t magic;
+	uint32_t len;	//! image bytes following the header
+	uint32_t hash;	//! FNV-1a of the image, catches torn files
+};
+
+struct tcv_eeprom_cache {
+	char *dir;
+	pthread_mutex_t lock;	//! protects everything below
+	size_t handles;			//! attached handles
+	tcv_eeprom_cache_stats_t stats;
+};
+
+/******************************************************************************/
+
+static uint32_t cache_hash(const uint8_t *data, size_t len)
+{
+	uint32_t hash = 2166136261u;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= data[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Stored image path of a port, tmp selects the file being written
+ */
+static int cache_path(const tcv_eeprom_cache_t *cache, int index, bool tmp,
+                      char *path, size_t size)
+{
+	int n;
+
+	n = snprintf(path, size, "%s/a0-%d%s", cache->dir, index, tmp ? ".tmp" : "");
+	if (n < 0 || (size_t) n >= size)
+		return TCV_ERR_INVALID_ARG;
+
+	return 0;
+}
+
+/******************************************************************************/
+
+tcv_eeprom_cache_t *tcv_eeprom_cache_open(const char *dir)
+{
+	tcv_eeprom_cache_t *cache;
+
+	if (!dir)
+		return NULL;
+
+	cache = malloc(sizeof(tcv_eeprom_cache_t));
+	if (!cache)
+		return NULL;
+
+	cache->dir = strdup(dir);
+	if (!cache->dir) {
+		free(cache);
+		return NULL;
+	}
+
+	if (pthread_mutex_init(&cache->lock, NULL)) {
+		free(cache->dir);
+		free(cache);
+		return NULL;
+	}
+
+	cache->handles = 0;
+	cache->stats.hits = 0;
+	cache->stats.misses = 0;
+	cache->stats.stores = 0;
+	return cache;
+}
+
+/******************************************************************************/
+
+int tcv_eeprom_cache_close(tcv_eeprom_cache_t *cache)
+{
+	if (!cache)
+		return TCV_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&cache->lock);
+	if (cache->handles) {
+		pthread_mutex_unlock(&cache->lock);
+		return TCV_ERR_BUSY;
+	}
+	pthread_mutex_unlock(&cache->lock);
+
+	pthread_mutex_destroy(&cache->lock);
+	free(cache->dir);
+	free(cache);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_eeprom_cache_attach(tcv_eeprom_cache_t *cache, tcv_t *tcv)
+{
+	if (!cache || !tcv || !tcv->created)
+		return TCV_ERR_INVALID_ARG;
+
+	tcv_io_lock(tcv);
+	if (tcv->eeprom_cache) {
+		tcv_io_unlock(tcv);
+		return TCV_ERR_INVALID_ARG;
+	}
+	tcv->eeprom_cache = cache;
+	tcv_io_unlock(tcv);
+
+	pthread_mutex_lock(&cache->lock);
+	cache->handles++;
+	pthread_mutex_unlock(&cache->lock);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_eeprom_cache_detach(tcv_t *tcv)
+{
+	tcv_eeprom_cache_t *cache;
+
+	if (!tcv || !tcv->created)
+		return TCV_ERR_INVALID_ARG;
+
+	tcv_io_lock(tcv);
+	cache = tcv->eeprom_cache;
+	tcv->eeprom_cache = NULL;
+	tcv_io_unlock(tcv);
+
+	if (!cache)
+		return TCV_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&cache->lock);
+	cache->handles--;
+	pthread_mutex_unlock(&cache->lock);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_eeprom_cache_get_stats(tcv_eeprom_cache_t *cache,
+                               tcv_eeprom_cache_stats_t *stats)
+{
+	if (!cache || !stats)
+		return TCV_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&cache->lock);
+	*stats = cache->stats;
+	pthread_mutex_unlock(&cache->lock);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_eeprom_cache_load(tcv_t *tcv, uint8_t *image, size_t len)
+{
+	struct cache_header hdr;
+	char path[PATH_MAX];
+	ssize_t n;
+	int fd;
+
+	if (!tcv->eeprom_cache ||
+	    cache_path(tcv->eeprom_cache, tcv->index, false, path, sizeof(path)) < 0)
+		return TCV_ERR_FEATURE_NOT_AVAILABLE;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return TCV_ERR_FEATURE_NOT_AVAILABLE;
+
+	n = read(fd, &hdr, sizeof(hdr));
+	if (n == (ssize_t) sizeof(hdr) && hdr.magic == CACHE_MAGIC && hdr.len == len)
+		n = read(fd, image, len);
+	else
+		n = -1;
+	close(fd);
+
+	if (n != (ssize_t) len || cache_hash(image, len) != hdr.hash)
+		return TCV_ERR_GENERIC;
+
+	return 0;
+}
+
+/******************************************************************************/
+
+void tcv_eeprom_cache_store(tcv_t *tcv, const uint8_t *image, size_t len)
+{
+	tcv_eeprom_cache_t *cache = tcv->eeprom_cache;
+	struct cache_header hdr;
+	char tmp[PATH_MAX], path[PATH_MAX];
+	bool ok;
+	int fd;
+
+	if (!cache ||
+	    cache_path(cache, tcv->index, true, tmp, sizeof(tmp)) < 0 ||
+	    cache_path(cache, tcv->index, false, path, sizeof(path)) < 0)
+		return;
+
+	hdr.magic = CACHE_MAGIC;
+	hdr.len = len;
+	hdr.hash = cache_hash(image, len);
+
+	/* readers see either the old or the new image, never a partial one */
+	fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return;
+
+	ok = write(fd, &hdr, sizeof(hdr)) == (ssize_t) sizeof(hdr) &&
+	     write(fd, image, len) == (ssize_t) len;
+	if (close(fd) || !ok || rename(tmp, path)) {
+		unlink(tmp);
+		return;
+	}
+
+	pthread_mutex_lock(&cache->lock);
+	cache->stats.stores++;
+	pthread_mutex_unlock(&cache->lock);
+}
+
+/******************************************************************************/
+
+void tcv_eeprom_cache_drop(tcv_t *tcv)
+{
+	char path[PATH_MAX];
+
+	if (!tcv->eeprom_cache ||
+	    cache_path(tcv->eeprom_cache, tcv->index, false, path, sizeof(path)) < 0)
+		return;
+
+	unlink(path);
+}
+
+/******************************************************************************/
+
+void tcv_eeprom_cache_account(tcv_t *tcv, bool hit)
+{
+	tcv_eeprom_cache_t *cache = tcv->eeprom_cache;
+
+	if (!cache)
+		return;
+
+	pthread_mutex_lock(&cache->lock);
+	if (hit)
+		cache->stats.hits++;
+	else
+		cache->stats.misses++;
+	pthread_mutex_unlock(&cache->lock);
+}
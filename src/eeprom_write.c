@@ -0,0 +1,304 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * EEPROM write engine, see libtcv/eeprom_write.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "libtcv/eeprom_write.h"
+#include "libtcv/tcv_internal.h"
+
+/** Register space of one device */
+#define DEVICE_SIZE			256
+/** Pause between ACK polls, the bus stays usable during the write cycle */
+#define ACK_POLL_US			200
+
+/** Deferred data of one device */
+struct tcv_write_pending {
+	struct tcv_write_pending *next;
+	uint8_t devaddr;
+	uint8_t data[DEVICE_SIZE];
+	uint8_t dirty[DEVICE_SIZE / 8];	//! bitmap of the bytes to be written
+};
+
+/******************************************************************************/
+
+static uint64_t now_ms(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Wait for the end of the write cycle, the device NACKs until then
+ * \return 0 if ok, TCV_ERR_TIMEOUT otherwise
+ */
+static int write_cycle_wait(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr)
+{
+	const struct timespec pause = { 0, ACK_POLL_US * 1000 };
+	uint64_t deadline;
+	uint8_t scratch;
+
+	if (!tcv->wcfg.ack_timeout_ms)
+		return 0;
+
+	deadline = now_ms() + tcv->wcfg.ack_timeout_ms;
+	while (tcv->read(tcv->ctx, devaddr, regaddr, &scratch, 1) < 0) {
+		if (now_ms() > deadline)
+			return TCV_ERR_TIMEOUT;
+		nanosleep(&pause, NULL);
+	}
+
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Read a written page back
+ * \return 0 if it matches, error code otherwise
+ */
+static int write_verify(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr,
+                        const uint8_t *data, size_t len)
+{
+	uint8_t scratch[DEVICE_SIZE];
+	int ret;
+
+	ret = tcv->read(tcv->ctx, devaddr, regaddr, scratch, len);
+	if (ret < 0)
+		return ret;
+
+	return memcmp(scratch, data, len) ? TCV_ERR_VERIFY : 0;
+}
+
+/******************************************************************************/
+
+int tcv_xfer_write_eeprom(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr,
+                          const uint8_t *data, size_t len)
+{
+	const size_t page = tcv->wcfg.page_size;
+	size_t chunk;
+	int ret, total = 0;
+
+	if (!page)
+		return tcv_xfer_write(tcv, devaddr, regaddr, data, len);
+
+	ret = tcv_bus_enter(tcv);
+	if (ret < 0)
+		return ret;
+
+	while (len) {
+		/* up to the end of the page, a write beyond wraps around in it */
+		chunk = page - (regaddr & (page - 1));
+		if (chunk > len)
+			chunk = len;
+		if (chunk > tcv->xfer_max)
+			chunk = tcv->xfer_max;
+
+		ret = tcv->write(tcv->ctx, devaddr, regaddr, data, chunk);
+		if (ret < 0)
+			break;
+		total += ret;
+
+		ret = write_cycle_wait(tcv, devaddr, regaddr);
+		if (ret < 0)
+			break;
+
+		if (tcv->wcfg.verify) {
+			ret = write_verify(tcv, devaddr, regaddr, data, chunk);
+			if (ret < 0)
+				break;
+		}
+
+		regaddr += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	tcv_bus_leave(tcv, ret);
+	return ret < 0 ? ret : total;
+}
+
+/******************************************************************************/
+
+void tcv_write_pending_free(tcv_t *tcv)
+{
+	struct tcv_write_pending *p;
+
+	while ((p = tcv->pending)) {
+		tcv->pending = p->next;
+		free(p);
+	}
+}
+
+/******************************************************************************/
+
+int tcv_set_write_config(tcv_t *tcv, const tcv_write_config_t *config)
+{
+	if (!tcv || !tcv->created || !config)
+		return TCV_ERR_INVALID_ARG;
+
+	if (config->page_size & (config->page_size - 1) ||
+	    config->page_size > DEVICE_SIZE)
+		return TCV_ERR_INVALID_ARG;
+
+	/* reading back during the write cycle fails, wait for its end first */
+	if (config->page_size && config->verify && !config->ack_timeout_ms)
+		return TCV_ERR_INVALID_ARG;
+
+	tcv_io_lock(tcv);
+	tcv->wcfg = *config;
+	tcv_io_unlock(tcv);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_write_deferred(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr,
+                       const uint8_t *data, size_t len)
+{
+	struct tcv_write_pending *p;
+	size_t i;
+
+	if (!tcv || !tcv->created || !data || regaddr + len > DEVICE_SIZE)
+		return TCV_ERR_INVALID_ARG;
+
+	tcv_io_lock(tcv);
+	for (p = tcv->pending; p; p = p->next)
+		if (p->devaddr == devaddr)
+			break;
+
+	if (!p) {
+		p = calloc(1, sizeof(struct tcv_write_pending));
+		if (!p) {
+			tcv_io_unlock(tcv);
+			return TCV_ERR_GENERIC;
+		}
+		p->devaddr = devaddr;
+		p->next = tcv->pending;
+		tcv->pending = p;
+	}
+
+	memcpy(&p->data[regaddr], data, len);
+	for (i = regaddr; i < regaddr + len; i++)
+		p->dirty[i / 8] |= 1 << (i % 8);
+
+	tcv_io_unlock(tcv);
+	return 0;
+}
+
+/******************************************************************************/
+
+static bool pending_dirty(const struct tcv_write_pending *p, size_t i)
+{
+	return p->dirty[i / 8] & (1 << (i % 8));
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Mark bytes written
+ * \param p deferred data of a device
+ * \param begin first byte
+ * \param end byte after the last one
+ */
+static void pending_clean(struct tcv_write_pending *p, size_t begin, size_t end)
+{
+	size_t i;
+
+	for (i = begin; i < end; i++)
+		p->dirty[i / 8] &= ~(1 << (i % 8));
+}
+
+/******************************************************************************/
+
+static bool pending_empty(const struct tcv_write_pending *p)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(p->dirty); i++)
+		if (p->dirty[i])
+			return false;
+	return true;
+}
+
+/******************************************************************************/
+
+int tcv_flush(tcv_t *tcv)
+{
+	struct tcv_write_pending *p, **pp;
+	size_t begin, end;
+	int ret = 0, err;
+
+	if (!tcv || !tcv->created)
+		return TCV_ERR_INVALID_ARG;
+
+	tcv_io_lock(tcv);
+	if (!tcv->initialized) {
+		tcv_io_unlock(tcv);
+		return TCV_ERR_NOT_INITIALIZED;
+	}
+
+	for (pp = &tcv->pending; (p = *pp);) {
+		for (begin = 0; begin < DEVICE_SIZE; begin = end) {
+			if (!pending_dirty(p, begin)) {
+				end = begin + 1;
+				continue;
+			}
+			for (end = begin + 1; end < DEVICE_SIZE && pending_dirty(p, end); end++)
+				;
+
+			err = tcv->fun->raw_write(tcv, p->devaddr, begin,
+			                          &p->data[begin], end - begin);
+			if (err < 0 && !ret)
+				ret = err;
+			/* failed runs are retried by the next flush unless they can
+			 * never be written */
+			if (err >= 0 || err == TCV_ERR_INVALID_ARG)
+				pending_clean(p, begin, end);
+		}
+
+		if (pending_empty(p)) {
+			*pp = p->next;
+			free(p);
+		} else {
+			pp = &p->next;
+		}
+	}
+
+	tcv_io_unlock(tcv);
+	return ret;
+}
@@ -0,0 +1,217 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Shared A0h image store, see libtcv/image_store.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "libtcv/image_store.h"
+#include "libtcv/tcv_internal.h"
+
+#define STORE_BUCKETS		256
+
+struct image_entry {
+	struct image_entry *next;
+	uint32_t hash;
+	size_t refs;
+	uint8_t image[TCV_IMAGE_SIZE];
+};
+
+struct tcv_image_store {
+	pthread_mutex_t lock;	//! protects everything below
+	size_t handles;			//! attached handles
+	struct image_entry *buckets[STORE_BUCKETS];
+	tcv_image_store_stats_t stats;
+};
+
+/******************************************************************************/
+
+static uint32_t image_hash(const uint8_t *image)
+{
+	uint32_t hash = 2166136261u;
+	size_t i;
+
+	for (i = 0; i < TCV_IMAGE_SIZE; i++) {
+		hash ^= image[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/******************************************************************************/
+
+tcv_image_store_t *tcv_image_store_create(void)
+{
+	tcv_image_store_t *store;
+
+	store = calloc(1, sizeof(tcv_image_store_t));
+	if (!store)
+		return NULL;
+
+	if (pthread_mutex_init(&store->lock, NULL)) {
+		free(store);
+		return NULL;
+	}
+
+	return store;
+}
+
+/******************************************************************************/
+
+int tcv_image_store_destroy(tcv_image_store_t *store)
+{
+	if (!store)
+		return TCV_ERR_INVALID_ARG;
+
+	/* entries go away with their last reference */
+	pthread_mutex_lock(&store->lock);
+	if (store->handles || store->stats.references) {
+		pthread_mutex_unlock(&store->lock);
+		return TCV_ERR_BUSY;
+	}
+	pthread_mutex_unlock(&store->lock);
+
+	pthread_mutex_destroy(&store->lock);
+	free(store);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_image_store_attach(tcv_image_store_t *store, tcv_t *tcv)
+{
+	if (!store || !tcv || !tcv->created)
+		return TCV_ERR_INVALID_ARG;
+
+	tcv_io_lock(tcv);
+	if (tcv->image_store) {
+		tcv_io_unlock(tcv);
+		return TCV_ERR_INVALID_ARG;
+	}
+	tcv->image_store = store;
+	tcv_io_unlock(tcv);
+
+	pthread_mutex_lock(&store->lock);
+	store->handles++;
+	pthread_mutex_unlock(&store->lock);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_image_store_detach(tcv_t *tcv)
+{
+	tcv_image_store_t *store;
+
+	if (!tcv || !tcv->created)
+		return TCV_ERR_INVALID_ARG;
+
+	tcv_io_lock(tcv);
+	store = tcv->image_store;
+	tcv->image_store = NULL;
+	tcv_io_unlock(tcv);
+
+	if (!store)
+		return TCV_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&store->lock);
+	store->handles--;
+	pthread_mutex_unlock(&store->lock);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_image_store_get_stats(tcv_image_store_t *store,
+                              tcv_image_store_stats_t *stats)
+{
+	if (!store || !stats)
+		return TCV_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&store->lock);
+	*stats = store->stats;
+	pthread_mutex_unlock(&store->lock);
+	return 0;
+}
+
+/******************************************************************************/
+
+const uint8_t *tcv_image_intern(struct tcv_image_store *store, const uint8_t *image)
+{
+	const uint32_t hash = image_hash(image);
+	struct image_entry **bucket = &store->buckets[hash % STORE_BUCKETS];
+	struct image_entry *e;
+
+	pthread_mutex_lock(&store->lock);
+	for (e = *bucket; e; e = e->next)
+		if (e->hash == hash && !memcmp(e->image, image, TCV_IMAGE_SIZE))
+			break;
+
+	if (!e) {
+		e = malloc(sizeof(struct image_entry));
+		if (!e) {
+			pthread_mutex_unlock(&store->lock);
+			return NULL;
+		}
+		e->hash = hash;
+		e->refs = 0;
+		memcpy(e->image, image, TCV_IMAGE_SIZE);
+		e->next = *bucket;
+		*bucket = e;
+		store->stats.images++;
+	}
+
+	e->refs++;
+	store->stats.references++;
+	pthread_mutex_unlock(&store->lock);
+	return e->image;
+}
+
+/******************************************************************************/
+
+void tcv_image_release(struct tcv_image_store *store, const uint8_t *image)
+{
+	struct image_entry *e, **link;
+
+	e = (struct image_entry *) (image - offsetof(struct image_entry, image));
+
+	pthread_mutex_lock(&store->lock);
+	store->stats.references--;
+	if (--e->refs == 0) {
+		for (link = &store->buckets[e->hash % STORE_BUCKETS]; *link != e;
+		     link = &(*link)->next)
+			;
+		*link = e->next;
+		free(e);
+		store->stats.images--;
+	}
+	pthread_mutex_unlock(&store->lock);
+}
@@ -0,0 +1,218 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Parallel initialization, see libtcv/parallel.h
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "libtcv/parallel.h"
+#include "libtcv/tcv_internal.h"
+
+/** Handle index with the bus it is serialized on */
+struct bus_key {
+	uintptr_t bus;	//! attached bus, the handle itself if there is none
+	bool serial;	//! attached to a bus
+	size_t index;	//! position in the handles
+};
+
+/** State of one tcv_init_many() call, shared by its workers */
+struct init_job {
+	tcv_t **handles;
+	size_t *order;					//! handle indices, grouped by bus
+	struct tcv_bus_group *groups;	//! largest group first
+	size_t ngroups;
+	atomic_size_t next;			//! next group to take
+	atomic_int initialized;		//! handles initialized successfully
+	const tcv_parallel_opts_t *opts;
+};
+
+/******************************************************************************/
+
+/**
+ * \brief Bus a handle is serialized on
+ * \param key (out) key of the bus
+ * \param tcv handle, may be NULL
+ */
+static void bus_key_of(struct bus_key *key, tcv_t *tcv)
+{
+	struct tcv_bus *bus = NULL;
+
+	/* invalid handles are turned away by the API, keep them alone */
+	if (tcv && tcv->created) {
+		tcv_io_lock(tcv);
+		bus = tcv->bus;
+		tcv_io_unlock(tcv);
+	}
+
+	key->bus = bus ? (uintptr_t) bus : (uintptr_t) tcv;
+	key->serial = bus != NULL;
+}
+
+/******************************************************************************/
+
+static int bus_key_cmp(const void *a, const void *b)
+{
+	const struct bus_key *ka = a, *kb = b;
+
+	if (ka->bus != kb->bus)
+		return ka->bus < kb->bus ? -1 : 1;
+	/* keep the order of the caller within a bus */
+	return ka->index < kb->index ? -1 : ka->index > kb->index;
+}
+
+/******************************************************************************/
+
+static int bus_group_cmp(const void *a, const void *b)
+{
+	const struct tcv_bus_group *ga = a, *gb = b;
+
+	if (ga->count != gb->count)
+		return ga->count > gb->count ? -1 : 1;
+	return ga->first < gb->first ? -1 : ga->first > gb->first;
+}
+
+/******************************************************************************/
+
+int tcv_group_by_bus(tcv_t **handles, size_t n, size_t *order,
+                     struct tcv_bus_group *groups)
+{
+	struct bus_key *keys;
+	size_t i, ngroups = 0;
+
+	keys = malloc(n * sizeof(*keys));
+	if (!keys)
+		return TCV_ERR_GENERIC;
+
+	for (i = 0; i < n; i++) {
+		bus_key_of(&keys[i], handles[i]);
+		keys[i].index = i;
+	}
+	qsort(keys, n, sizeof(*keys), bus_key_cmp);
+
+	for (i = 0; i < n; i++) {
+		order[i] = keys[i].index;
+		if (!i || keys[i].bus != keys[i - 1].bus) {
+			groups[ngroups].first = i;
+			groups[ngroups].count = 0;
+			groups[ngroups].serial = keys[i].serial;
+			ngroups++;
+		}
+		groups[ngroups - 1].count++;
+	}
+	free(keys);
+
+	/* the longest buses first keep the last one from running alone at the end */
+	qsort(groups, ngroups, sizeof(*groups), bus_group_cmp);
+	return ngroups;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Worker: take groups until none is left
+ * \param arg struct init_job
+ * \return NULL
+ */
+static void *init_worker(void *arg)
+{
+	struct init_job *job = arg;
+	const tcv_parallel_opts_t *opts = job->opts;
+	const struct tcv_bus_group *group;
+	size_t g, i, idx;
+	int ret;
+
+	while ((g = atomic_fetch_add(&job->next, 1)) < job->ngroups) {
+		group = &job->groups[g];
+		for (i = 0; i < group->count; i++) {
+			idx = job->order[group->first + i];
+			ret = tcv_init(job->handles[idx]);
+			if (!ret)
+				atomic_fetch_add(&job->initialized, 1);
+			if (opts->results)
+				opts->results[idx] = ret;
+			if (opts->done)
+				opts->done(job->handles[idx], ret, opts->arg);
+		}
+	}
+	return NULL;
+}
+
+/******************************************************************************/
+
+int tcv_init_many(tcv_t **handles, size_t n, const tcv_parallel_opts_t *opts)
+{
+	static const tcv_parallel_opts_t defaults = { 0 };
+	pthread_t threads[TCV_PARALLEL_MAX_THREADS - 1];
+	struct init_job job;
+	size_t want, started, i;
+	int ret;
+
+	if (!handles && n)
+		return TCV_ERR_INVALID_ARG;
+	if (!n)
+		return 0;
+	if (!opts)
+		opts = &defaults;
+
+	job.handles = handles;
+	job.opts = opts;
+	atomic_init(&job.next, 0);
+	atomic_init(&job.initialized, 0);
+	job.order = malloc(n * sizeof(*job.order));
+	job.groups = malloc(n * sizeof(*job.groups));
+	ret = job.order && job.groups ?
+		tcv_group_by_bus(handles, n, job.order, job.groups) : TCV_ERR_GENERIC;
+	if (ret < 0) {
+		free(job.order);
+		free(job.groups);
+		return ret;
+	}
+	job.ngroups = ret;
+
+	want = opts->threads ? opts->threads : TCV_PARALLEL_DEFAULT_THREADS;
+	if (want > TCV_PARALLEL_MAX_THREADS)
+		want = TCV_PARALLEL_MAX_THREADS;
+	/* a bus never keeps more than one worker busy */
+	if (want > job.ngroups)
+		want = job.ngroups;
+
+	/* the caller is a worker as well */
+	for (started = 0; started + 1 < want; started++)
+		if (pthread_create(&threads[started], NULL, init_worker, &job))
+			break;
+
+	init_worker(&job);
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+
+	free(job.order);
+	free(job.groups);
+	return atomic_load(&job.initialized);
+}
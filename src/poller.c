@@ -0,0 +1,559 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Digital diagnostics poll engine, see libtcv/poller.h
+ *
+ * Lock order: poller lock, then worker locks. Polls run without any of them.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "libtcv/poller.h"
+#include "libtcv/tcv_internal.h"
+
+struct poll_worker;
+
+/** Handles polled in a fixed rotation */
+struct poll_queue {
+	struct poll_worker *owner;	//! worker whose lock protects the queue
+	size_t *tasks;				//! handle indices
+	size_t count;				//! number of tasks
+	size_t pos;					//! next task
+	size_t pending;				//! tasks left in the current cycle
+	uint64_t gen;				//! cycle the pending tasks belong to
+	bool serial;				//! tasks share a bus, run one at a time
+	bool busy;					//! a task of a serial queue is running
+};
+
+/** Worker thread and the queues it owns */
+struct poll_worker {
+	struct tcv_poller *poller;
+	pthread_t thread;
+	pthread_mutex_t lock;		//! protects the queues
+	struct poll_queue **queues;	//! own queues
+	size_t nqueues;
+	size_t load;				//! tasks of the own queues
+};
+
+/** Task taken from a queue */
+struct poll_task {
+	struct poll_queue *queue;
+	size_t index;	//! handle index
+	uint64_t gen;	//! cycle of the task
+	bool stolen;	//! taken from another worker
+};
+
+struct tcv_poller {
+	tcv_t **handles;			//! copy of the handles
+	size_t n;
+	size_t *tasks;				//! storage of all queues
+	struct poll_queue *queues;
+	size_t nqueues;
+	struct poll_queue **slots;	//! storage of the worker queue lists
+	struct poll_worker *workers;
+	unsigned int nworkers;
+	tcv_poll_cb_t cb;
+	void *arg;
+	uint64_t interval_ns;
+
+	atomic_bool stop;		//! set under lock, workers also check it between polls
+	pthread_mutex_t lock;	//! protects everything below
+	pthread_cond_t wake;	//! signalled when events changes
+	uint64_t events;		//! cycle starts and serial queues released with work left
+	uint64_t gen;			//! current cycle, 0 before the first one
+	uint64_t cycle_start;	//! CLOCK_MONOTONIC ns of the current cycle
+	uint64_t next_cycle;	//! CLOCK_MONOTONIC ns the next cycle is due
+	size_t outstanding;		//! tasks of the current cycle not done yet
+	tcv_poll_stats_t stats;
+};
+
+/******************************************************************************/
+
+/**
+ * \brief CLOCK_MONOTONIC in nanoseconds
+ */
+static uint64_t poll_now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Start a cycle, every queue gets all of its tasks again
+ *
+ * Queues keep their position, tasks a slow bus did not reach come first.
+ * \param p poller, locked
+ * \param now current time
+ */
+static void poll_start_cycle(struct tcv_poller *p, uint64_t now)
+{
+	struct poll_worker *w;
+	unsigned int i;
+	size_t q;
+
+	if (p->gen && p->outstanding)
+		p->stats.overruns++;
+
+	p->gen++;
+	p->stats.cycles++;
+	p->cycle_start = now;
+	p->outstanding = p->n;
+	/* keep the schedule, cycles missed entirely are not made up */
+	p->next_cycle += p->interval_ns;
+	if (p->next_cycle <= now)
+		p->next_cycle = now + p->interval_ns;
+
+	for (i = 0; i < p->nworkers; i++) {
+		w = &p->workers[i];
+		pthread_mutex_lock(&w->lock);
+		for (q = 0; q < w->nqueues; q++) {
+			w->queues[q]->pending = w->queues[q]->count;
+			w->queues[q]->gen = p->gen;
+		}
+		pthread_mutex_unlock(&w->lock);
+	}
+
+	p->events++;
+	pthread_cond_broadcast(&p->wake);
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Take a task of a worker's queues
+ * \param w worker owning the queues, not locked
+ * \param task (out) task taken
+ * \return true if a task was taken
+ */
+static bool poll_take_from(struct poll_worker *w, struct poll_task *task)
+{
+	struct poll_queue *queue;
+	bool found = false;
+	size_t q;
+
+	pthread_mutex_lock(&w->lock);
+	for (q = 0; q < w->nqueues && !found; q++) {
+		queue = w->queues[q];
+		if (!queue->pending || (queue->serial && queue->busy))
+			continue;
+
+		task->queue = queue;
+		task->index = queue->tasks[queue->pos];
+		task->gen = queue->gen;
+		queue->pos = (queue->pos + 1) % queue->count;
+		queue->pending--;
+		queue->busy = queue->serial;
+		found = true;
+	}
+	pthread_mutex_unlock(&w->lock);
+	return found;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Take a task, from the own queues first, then from the others
+ * \param w worker
+ * \param task (out) task taken
+ * \return true if a task was taken
+ */
+static bool poll_take(struct poll_worker *w, struct poll_task *task)
+{
+	struct tcv_poller *p = w->poller;
+	unsigned int id = w - p->workers;
+	unsigned int i;
+
+	for (i = 0; i < p->nworkers; i++) {
+		if (poll_take_from(&p->workers[(id + i) % p->nworkers], task)) {
+			task->stolen = i != 0;
+			return true;
+		}
+	}
+	return false;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Poll the handle of a task and account for it
+ * \param p poller, not locked
+ * \param task task taken
+ */
+static void poll_run(struct tcv_poller *p, const struct poll_task *task)
+{
+	struct poll_queue *queue = task->queue;
+	tcv_t *tcv = p->handles[task->index];
+	tcv_dd_snapshot_t snapshot;
+	bool more;
+	uint64_t took;
+	int ret;
+
+	ret = tcv_get_dd_snapshot(tcv, &snapshot);
+	if (p->cb)
+		p->cb(tcv, ret, ret < 0 ? NULL : &snapshot, p->arg);
+
+	pthread_mutex_lock(&queue->owner->lock);
+	queue->busy = false;
+	more = queue->serial && queue->pending;
+	pthread_mutex_unlock(&queue->owner->lock);
+
+	pthread_mutex_lock(&p->lock);
+	if (ret < 0)
+		p->stats.errors++;
+	else
+		p->stats.snapshots++;
+	if (task->stolen)
+		p->stats.steals++;
+
+	if (task->gen == p->gen && !--p->outstanding) {
+		took = poll_now_ns() - p->cycle_start;
+		p->stats.completed++;
+		p->stats.last_cycle_ns = took;
+		if (took > p->stats.max_cycle_ns)
+			p->stats.max_cycle_ns = took;
+	}
+
+	/* the bus is free for idle workers again */
+	if (more) {
+		p->events++;
+		pthread_cond_broadcast(&p->wake);
+	}
+	pthread_mutex_unlock(&p->lock);
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Worker thread: poll while there is work, start due cycles
+ * \param arg struct poll_worker
+ * \return NULL
+ */
+static void *poll_worker_run(void *arg)
+{
+	struct poll_worker *w = arg;
+	struct tcv_poller *p = w->poller;
+	struct poll_task task;
+	struct timespec until;
+	uint64_t seen, now;
+
+	pthread_mutex_lock(&p->lock);
+	while (!p->stop) {
+		seen = p->events;
+		pthread_mutex_unlock(&p->lock);
+
+		while (!atomic_load(&p->stop) && poll_take(w, &task))
+			poll_run(p, &task);
+
+		pthread_mutex_lock(&p->lock);
+		/* work may have shown up while looking for it */
+		if (p->stop || p->events != seen)
+			continue;
+
+		now = poll_now_ns();
+		if (now >= p->next_cycle) {
+			poll_start_cycle(p, now);
+			continue;
+		}
+
+		until.tv_sec = p->next_cycle / 1000000000ULL;
+		until.tv_nsec = p->next_cycle % 1000000000ULL;
+		pthread_cond_timedwait(&p->wake, &p->lock, &until);
+	}
+	pthread_mutex_unlock(&p->lock);
+	return NULL;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Build the queues: one per bus, handles without bus spread over one
+ *        queue per worker
+ * \param p poller with handles and nworkers set
+ * \return 0 if ok, error code otherwise
+ */
+static int poll_build_queues(struct tcv_poller *p)
+{
+	struct tcv_bus_group *groups;
+	size_t *order, singles = 0, pos = 0, g, k, q, i;
+	int ngroups;
+
+	order = malloc(p->n * sizeof(*order));
+	groups = malloc(p->n * sizeof(*groups));
+	ngroups = order && groups ?
+		tcv_group_by_bus(p->handles, p->n, order, groups) : TCV_ERR_GENERIC;
+	if (ngroups < 0)
+		goto out;
+
+	for (g = 0; g < (size_t) ngroups; g++)
+		if (!groups[g].serial)
+			singles++;
+
+	/* a worker more than there are buses and independent handles is idle */
+	if (p->nworkers > (size_t) ngroups)
+		p->nworkers = ngroups;
+
+	p->nqueues = ngroups - singles;
+	p->nqueues += singles < p->nworkers ? singles : p->nworkers;
+	p->tasks = malloc(p->n * sizeof(*p->tasks));
+	p->queues = calloc(p->nqueues, sizeof(*p->queues));
+	if (!p->tasks || !p->queues) {
+		ngroups = TCV_ERR_GENERIC;
+		goto out;
+	}
+
+	/* groups come largest first, the bus queues too */
+	k = 0;
+	for (g = 0; g < (size_t) ngroups; g++) {
+		if (!groups[g].serial)
+			continue;
+		p->queues[k].tasks = &p->tasks[pos];
+		p->queues[k].serial = true;
+		for (i = 0; i < groups[g].count; i++)
+			p->tasks[pos++] = order[groups[g].first + i];
+		p->queues[k].count = groups[g].count;
+		k++;
+	}
+
+	/* independent handles round robin over the remaining queues */
+	for (q = k; q < p->nqueues; q++) {
+		p->queues[q].tasks = &p->tasks[pos];
+		i = 0;
+		for (g = 0; g < (size_t) ngroups; g++) {
+			if (groups[g].serial)
+				continue;
+			if (i++ % (p->nqueues - k) == q - k)
+				p->tasks[pos++] = order[groups[g].first];
+		}
+		p->queues[q].count = &p->tasks[pos] - p->queues[q].tasks;
+	}
+	ngroups = 0;
+out:
+	free(order);
+	free(groups);
+	return ngroups;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Hand the queues to the workers, each to the least loaded one
+ * \param p poller with queues built
+ * \return 0 if ok, error code otherwise
+ */
+static int poll_assign_queues(struct tcv_poller *p)
+{
+	struct poll_worker *w;
+	unsigned int i, least;
+	size_t q, pos = 0;
+
+	p->slots = malloc(p->nqueues * sizeof(*p->slots));
+	if (!p->slots)
+		return TCV_ERR_GENERIC;
+
+	/* queues come largest first */
+	for (q = 0; q < p->nqueues; q++) {
+		least = 0;
+		for (i = 1; i < p->nworkers; i++)
+			if (p->workers[i].load < p->workers[least].load)
+				least = i;
+		p->queues[q].owner = &p->workers[least];
+		p->workers[least].load += p->queues[q].count;
+		p->workers[least].nqueues++;
+	}
+
+	for (i = 0; i < p->nworkers; i++) {
+		w = &p->workers[i];
+		w->queues = &p->slots[pos];
+		pos += w->nqueues;
+		w->nqueues = 0;
+	}
+	for (q = 0; q < p->nqueues; q++) {
+		w = p->queues[q].owner;
+		w->queues[w->nqueues++] = &p->queues[q];
+	}
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Free a poller whose workers are not running
+ * \param p poller
+ * \param locks worker locks initialized
+ */
+static void poll_free(struct tcv_poller *p, unsigned int locks)
+{
+	unsigned int i;
+
+	for (i = 0; i < locks; i++)
+		pthread_mutex_destroy(&p->workers[i].lock);
+	free(p->workers);
+	free(p->slots);
+	free(p->queues);
+	free(p->tasks);
+	free(p->handles);
+	free(p);
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Stop and join the first workers
+ * \param p poller
+ * \param started number of running workers
+ */
+static void poll_stop(struct tcv_poller *p, unsigned int started)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&p->lock);
+	atomic_store(&p->stop, true);
+	pthread_cond_broadcast(&p->wake);
+	pthread_mutex_unlock(&p->lock);
+
+	for (i = 0; i < started; i++)
+		pthread_join(p->workers[i].thread, NULL);
+
+	pthread_cond_destroy(&p->wake);
+	pthread_mutex_destroy(&p->lock);
+}
+
+/******************************************************************************/
+
+tcv_poller_t *tcv_poller_create(tcv_t **handles, size_t n,
+                                const tcv_poll_opts_t *opts)
+{
+	struct tcv_poller *p;
+	pthread_condattr_t attr;
+	unsigned int i;
+
+	if (!handles || !n || !opts || !opts->interval_ms)
+		return NULL;
+
+	p = calloc(1, sizeof(*p));
+	if (!p)
+		return NULL;
+
+	p->handles = malloc(n * sizeof(*p->handles));
+	if (!p->handles) {
+		poll_free(p, 0);
+		return NULL;
+	}
+	for (i = 0; i < n; i++)
+		p->handles[i] = handles[i];
+	p->n = n;
+	p->cb = opts->cb;
+	p->arg = opts->arg;
+	p->interval_ns = (uint64_t) opts->interval_ms * 1000000ULL;
+	p->nworkers = opts->threads ? opts->threads : TCV_POLL_DEFAULT_THREADS;
+	if (p->nworkers > TCV_POLL_MAX_THREADS)
+		p->nworkers = TCV_POLL_MAX_THREADS;
+
+	if (poll_build_queues(p) < 0) {
+		poll_free(p, 0);
+		return NULL;
+	}
+
+	p->workers = calloc(p->nworkers, sizeof(*p->workers));
+	if (!p->workers || poll_assign_queues(p) < 0) {
+		poll_free(p, 0);
+		return NULL;
+	}
+
+	for (i = 0; i < p->nworkers; i++) {
+		p->workers[i].poller = p;
+		if (pthread_mutex_init(&p->workers[i].lock, NULL)) {
+			poll_free(p, i);
+			return NULL;
+		}
+	}
+
+	/* cycles are scheduled on the monotonic clock */
+	if (pthread_condattr_init(&attr)) {
+		poll_free(p, p->nworkers);
+		return NULL;
+	}
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	if (pthread_cond_init(&p->wake, &attr)) {
+		pthread_condattr_destroy(&attr);
+		poll_free(p, p->nworkers);
+		return NULL;
+	}
+	pthread_condattr_destroy(&attr);
+
+	if (pthread_mutex_init(&p->lock, NULL)) {
+		pthread_cond_destroy(&p->wake);
+		poll_free(p, p->nworkers);
+		return NULL;
+	}
+
+	/* the first cycle is due right away */
+	p->next_cycle = poll_now_ns();
+
+	for (i = 0; i < p->nworkers; i++) {
+		if (pthread_create(&p->workers[i].thread, NULL, poll_worker_run,
+		                   &p->workers[i])) {
+			poll_stop(p, i);
+			poll_free(p, p->nworkers);
+			return NULL;
+		}
+	}
+	return p;
+}
+
+/******************************************************************************/
+
+int tcv_poller_destroy(tcv_poller_t *poller)
+{
+	if (!poller)
+		return TCV_ERR_INVALID_ARG;
+
+	poll_stop(poller, poller->nworkers);
+	poll_free(poller, poller->nworkers);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_poller_get_stats(tcv_poller_t *poller, tcv_poll_stats_t *stats)
+{
+	if (!poller || !stats)
+		return TCV_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&poller->lock);
+	*stats = poller->stats;
+	pthread_mutex_unlock(&poller->lock);
+	return 0;
+}
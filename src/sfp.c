@@ -42,6 +42,36 @@
 
 
 /******************************************************************************/
+/**
+ * \brief External calibration constants of one quantity
+ */
+typedef struct {
+	int16_t slope;	//! 8.8 fixed point gain
+	int16_t offset;	//! absolute value correction
+} sfp_linear_calib_t;
+
+/**
+ * \brief Slope/offset calibrated quantities, in A2h register order (76-95)
+ */
+enum {
+	DD_LINEAR_TX_CUR,
+	DD_LINEAR_TX_PWR,
+	DD_LINEAR_TEMP,
+	DD_LINEAR_VCC,
+	DD_LINEAR_COUNT,
+};
+
+/**
+ * \brief Static data of an SFP, read by the static getters without lock
+ */
+typedef struct {
+	struct tcv_static hdr;	//! Publication, see tcv_static_publish()
+	const uint8_t *a0;	//! Internal device 0xA0 (Basic info), see sfp_a0_field()
+	uint8_t *own;	//! a0 while it is not shared, freed with the static data
+	struct tcv_image_store *store;	//! Store a0 is shared in, if any
+	uint8_t a0_delta[29];	//! Per module A0h fields: CC_BASE, 68-95
+} sfp_static_t;
+
 /**
  * \brief	SFP structure.
  *
@@ -49,11 +79,45 @@
  */
 typedef struct {
 	uint8_t type;	//! Transceiver type
-	uint8_t a0[256];	//! Internal device 0xA0 (Basic info)
+	sfp_static_t *st;	//! Static data, published once read
+	uint8_t *a0_own;	//! Private image of st being loaded, NULL once shared
 	uint8_t user_writable_eeprom[120];	//! Internal user writable eeprom
-	uint8_t ac[256];	//! Internal device 0xAc (Internal PHY)
+	bool user_eeprom_valid;	//! user_writable_eeprom holds A2h 128-247
+	const struct sfp_dd_ops *dd;	//! Digital diagnostics matching byte 92
+	bool calib_loaded;	//! External calibration constants below are valid
+	sfp_linear_calib_t linear_calib[DD_LINEAR_COUNT];	//! A2h 76-95, host order
+	float rx_pwr_calib[5];	//! A2h 56-75, Rx_PWR(0)...Rx_PWR(4), host order
+	size_t a0_loaded;	//! a0 bytes read so far, see tcv_set_lazy_init()
+	int dd_page;	//! Last page written to A2h byte 127, -1 if unknown
+	bool dd_cache_valid;	//! dd_cache holds bytes 96-105
+	uint64_t dd_cache_time;	//! CLOCK_MONOTONIC ns of the dd_cache read
+	uint8_t dd_cache[10];	//! A2h 96-105 measured values, see tcv_set_dd_cache()
+	tcv_dd_cache_stats_t dd_cache_stats;	//! Hits and misses of dd_cache
+	bool ra_open;	//! A read-ahead window is open, see tcv_set_read_ahead()
+	bool ra_filled;	//! ra_buf holds A2h 96-111 read at ra_start
+	uint64_t ra_start;	//! CLOCK_MONOTONIC ns the open window started
+	uint16_t ra_used;	//! Bytes of 96-111 requested in the open window
+	uint8_t ra_buf[16];	//! A2h 96-111 of the last region read
+	uint32_t ra_demand;	//! Average words requested per window, 1/16 units
+	uint64_t ra_cost[2];	//! Average word and region read time in ns, 0 if unknown
+	uint64_t ra_windows;	//! Windows opened since init
+	uint64_t ra_measured[2];	//! ra_windows at the last word and region read
+	tcv_read_ahead_stats_t ra_stats;	//! Read-ahead counters
 } sfp_data_t;
 
+/**
+ * \brief Digital diagnostics implementation, chosen once per module at init
+ */
+struct sfp_dd_ops {
+	int (*get_temp)(tcv_t *, int16_t *);
+	/* slope/offset calibrated quantity (DD_LINEAR_*) at A/D register val_addr */
+	int (*get_value)(tcv_t *, int quantity, uint8_t val_addr, int16_t *);
+	int (*get_rx_pwr)(tcv_t *, uint16_t *);
+	/* snapshot: checked before reading, raw values converted after */
+	int (*prepare_snapshot)(tcv_t *);
+	void (*decode_snapshot)(const sfp_data_t *, tcv_dd_snapshot_t *);
+};
+
 /**
  * \brief Transceiver Digital Diagnostics Type
  *
@@ -255,57 +319,396 @@ const uint8_t  EEPROM_DEVICE_ADDR = 0x50;
 #define DD_RX_PWR_AD_REG								(104)
 #define DD_RX_PWR_AD_SIZE 								(2)
 
+/** Calibration constants, 56-95 */
+#define DD_CAL_REG										(56)
+#define DD_CAL_SIZE										(40)
+
+/** Measured values, temperature to RX-Power, 96-105 */
+#define DD_VALUES_REG									(96)
+#define DD_VALUES_SIZE									(10)
+
+/* Status region fetched by the read-ahead */
+#define DD_AHEAD_REG									(96)
+#define DD_AHEAD_SIZE									(16)
+/* Bus transaction overhead in byte times assumed until measured:
+ * start + address, register, restart + address, stop */
+#define DD_AHEAD_XFER_BYTES								(4)
+/* Windows after which the policy not chosen is measured again */
+#define DD_AHEAD_PROBE									(64)
+
+/** A0h image size, the MSA defined fields end with CC_EXT */
+#define SFP_A0_SIZE										(256)
+#define SFP_A0_MSA_SIZE									(96)
+
+/** User writable EEPROM, 128-247 */
+#define USER_EEPROM_REG									(128)
+
+/** Page select for the upper half 128-255 */
+#define DD_PAGE_SELECT_REG								(127)
+
+
+/******************************************************************************/
+
+static en_calibration_type sfp_dd_type(tcv_t* tcv);
+static const struct sfp_dd_ops *sfp_dd_ops_for(en_calibration_type calib);
+static int sfp_load_calibration(tcv_t* tcv);
+static void ra_close(sfp_data_t *sfp_data);
+
+/**
+ * \brief Location of an A0h field: the per module fields are kept apart from
+ *        a possibly shared image
+ * \param hdr static data the caller acquired or owns, never reloaded here
+ * \param reg A0h register, fields never span both parts
+ * \return field content
+ */
+static const uint8_t *sfp_a0_field(const struct tcv_static *hdr, size_t reg)
+{
+	const sfp_static_t *st = (const sfp_static_t *) hdr;
+
+	if (reg == BASIC_INFO_REG_CC_BASE)
+		return &st->a0_delta[0];
+	if (reg >= BASIC_INFO_REG_VENDOR_SN && reg <= BASIC_INFO_REG_CC_EXT)
+		return &st->a0_delta[1 + reg - BASIC_INFO_REG_VENDOR_SN];
+
+	return &st->a0[reg];
+}
+
+/******************************************************************************/
+
+static uint8_t sfp_a0_byte(const struct tcv_static *st, size_t reg)
+{
+	return *sfp_a0_field(st, reg);
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Reassemble the A0h image as read from the module
+ * \param st static data of the handle
+ * \param a0 (out) SFP_A0_SIZE bytes
+ */
+static void sfp_a0_compose(const sfp_static_t *st, uint8_t *a0)
+{
+	memcpy(a0, st->a0, SFP_A0_SIZE);
+	a0[BASIC_INFO_REG_CC_BASE] = st->a0_delta[0];
+	memcpy(&a0[BASIC_INFO_REG_VENDOR_SN], &st->a0_delta[1],
+	       sizeof(st->a0_delta) - 1);
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Free static data, called once no getter can use it anymore
+ * \param hdr static data of the handle
+ */
+static void sfp_static_free(struct tcv_static *hdr)
+{
+	sfp_static_t *st = (sfp_static_t *) hdr;
+
+	if (st->store)
+		tcv_image_release(st->store, st->a0);
+	free(st->own);
+	free(st);
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Static data with a private image to read A0h into
+ * \return static data, NULL if out of memory
+ */
+static sfp_static_t *sfp_static_new(void)
+{
+	sfp_static_t *st;
+
+	st = malloc(sizeof(*st));
+	if (!st)
+		return NULL;
+
+	st->own = malloc(SFP_A0_SIZE);
+	if (!st->own) {
+		free(st);
+		return NULL;
+	}
+	st->hdr.fun = &sfp_funcs;
+	st->hdr.free = sfp_static_free;
+	st->hdr.retired = NULL;
+	st->a0 = st->own;
+	st->store = NULL;
+	return st;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Copy the per module fields out of a private image just read
+ * \param st static data, not published yet
+ */
+static void sfp_a0_split(sfp_static_t *st)
+{
+	st->a0_delta[0] = st->own[BASIC_INFO_REG_CC_BASE];
+	memcpy(&st->a0_delta[1], &st->own[BASIC_INFO_REG_VENDOR_SN],
+	       sizeof(st->a0_delta) - 1);
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Static data referring to the copy of a complete private image in the
+ *        attached store. The per module fields stay in a0_delta and are
+ *        cleared in the shared copy.
+ * \param tcv transceiver handle
+ * \param st static data with a private image
+ * \return new static data, NULL if there is no store or out of memory
+ */
+static sfp_static_t *sfp_a0_share(tcv_t *tcv, const sfp_static_t *st)
+{
+	uint8_t image[SFP_A0_SIZE];
+	sfp_static_t *shared;
+
+	if (!tcv->image_store || !st->own)
+		return NULL;
+
+	shared = malloc(sizeof(*shared));
+	if (!shared)
+		return NULL;
+
+	memcpy(image, st->own, sizeof(image));
+	image[BASIC_INFO_REG_CC_BASE] = 0;
+	memset(&image[BASIC_INFO_REG_VENDOR_SN], 0, sizeof(st->a0_delta) - 1);
+
+	shared->a0 = tcv_image_intern(tcv->image_store, image);
+	if (!shared->a0) {
+		free(shared);
+		return NULL;
+	}
+	shared->hdr = st->hdr;
+	shared->own = NULL;
+	shared->store = tcv->image_store;
+	memcpy(shared->a0_delta, st->a0_delta, sizeof(shared->a0_delta));
+	return shared;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Share the image once it is complete. Published static data is
+ *        replaced, the private image stays valid until the next init.
+ * \param tcv transceiver handle
+ * \param sfp_data sfp data of the handle
+ */
+static void sfp_a0_complete(tcv_t *tcv, sfp_data_t *sfp_data)
+{
+	sfp_static_t *shared;
+
+	shared = sfp_a0_share(tcv, sfp_data->st);
+	if (!shared)
+		return;
+
+	if (tcv_static_get(tcv) == &sfp_data->st->hdr)
+		tcv_static_publish(tcv, &shared->hdr);
+	else
+		sfp_static_free(&sfp_data->st->hdr);
+
+	sfp_data->st = shared;
+	sfp_data->a0_own = NULL;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Check if an A0h image belongs to the plugged module. Serial number
+ *        and date code tell modules apart, the checksums cover the rest of
+ *        the base and extended ID fields.
+ * \param tcv transceiver handle
+ * \param a0 A0h image
+ * \param identifier also read the identifier, false if the caller knows it
+ *        is an SFP
+ * \return 1 if it matches, 0 if not, error code < 0 if reading failed
+ */
+static int sfp_a0_matches(tcv_t *tcv, const uint8_t *a0, bool identifier)
+{
+	uint8_t id = TCV_TYPE_SFP, cc_base;
+	uint8_t ident[BASIC_INFO_REG_CC_EXT + 1 - BASIC_INFO_REG_VENDOR_SN];
+	const tcv_i2c_segment_t slice[] = {
+		{ EEPROM_DEVICE_ADDR, BASIC_INFO_REG_CC_BASE, &cc_base, sizeof(cc_base) },
+		{ EEPROM_DEVICE_ADDR, BASIC_INFO_REG_VENDOR_SN, ident, sizeof(ident) },
+		{ EEPROM_DEVICE_ADDR, BASIC_INFO_REG_IDENTIFIER, &id, sizeof(id) },
+	};
+	int ret;
+
+	ret = tcv_readv(tcv, slice, sizeof(slice) / sizeof(slice[0]) - !identifier);
+	if (ret < 0)
+		return ret;
+
+	return a0[BASIC_INFO_REG_IDENTIFIER] == id &&
+	       a0[BASIC_INFO_REG_CC_BASE] == cc_base &&
+	       !memcmp(&a0[BASIC_INFO_REG_VENDOR_SN], ident, sizeof(ident));
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Reuse the stored A0h image if it belongs to the plugged module
+ * \param tcv transceiver handle
+ * \param a0 (out) A0h image
+ * \return 1 if reused, 0 if there is none or it does not match, error code
+ *         < 0 if reading the module failed
+ */
+static int sfp_load_cached_a0(tcv_t *tcv, uint8_t *a0)
+{
+	if (tcv_eeprom_cache_load(tcv, a0, SFP_A0_SIZE) < 0)
+		return 0;
+
+	/* Identifier was read by tcv_init() */
+	return sfp_a0_matches(tcv, a0, false);
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Make sure A0h is loaded up to the given byte
+ * \param tcv transceiver handle
+ * \param sfp_data sfp data of the handle
+ * \param end first byte not needed
+ * \return 0 for success, error code < 0 otherwise
+ */
+static int sfp_load_a0(tcv_t *tcv, sfp_data_t *sfp_data, size_t end)
+{
+	size_t start = sfp_data->a0_loaded;
+	int ret;
+
+	if (start >= end)
+		return 0;
+
+	ret = tcv_xfer_read(tcv, EEPROM_DEVICE_ADDR, start,
+	                    &sfp_data->a0_own[start], end - start);
+	if (ret < 0)
+		return ret;
+
+	sfp_data->a0_loaded = end;
+	/* the per module fields are part of the first read, at init */
+	if (!start)
+		sfp_a0_split(sfp_data->st);
+
+	if (end == SFP_A0_SIZE) {
+		tcv_eeprom_cache_store(tcv, sfp_data->a0_own, SFP_A0_SIZE);
+		sfp_a0_complete(tcv, sfp_data);
+	}
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Read A0h, from the persistent cache if one is attached and valid.
+ *        Lazy handles read the MSA fields 0-95 only.
+ * \param tcv transceiver handle
+ * \param sfp_data (out) a0 and a0_loaded
+ * \return 0 for success, error code < 0 otherwise
+ */
+static int sfp_read_a0(tcv_t *tcv, sfp_data_t *sfp_data)
+{
+	int ret;
+
+	sfp_data->a0_loaded = 0;
+	ret = sfp_load_cached_a0(tcv, sfp_data->a0_own);
+	if (ret < 0)
+		return ret;
+	tcv_eeprom_cache_account(tcv, ret);
+	if (ret) {
+		sfp_data->a0_loaded = SFP_A0_SIZE;
+		sfp_a0_split(sfp_data->st);
+		sfp_a0_complete(tcv, sfp_data);
+		return 0;
+	}
+
+	return sfp_load_a0(tcv, sfp_data, tcv->lazy_init ? SFP_A0_MSA_SIZE : SFP_A0_SIZE);
+}
 
 /******************************************************************************/
+
 int sfp_init(tcv_t* tcv){
 	int ret;
 	sfp_data_t * sfp_data;
+	en_calibration_type calib;
 
 	sfp_data = malloc(sizeof(sfp_data_t));
 	if(!sfp_data){
 		return TCV_ERR_GENERIC;
 	}
-	ret = tcv->read(tcv->index, EEPROM_DEVICE_ADDR, 0, sfp_data->a0, sizeof(sfp_data->a0));
+	sfp_data->st = sfp_static_new();
+	if(!sfp_data->st){
+		free(sfp_data);
+		return TCV_ERR_GENERIC;
+	}
+	sfp_data->a0_own = sfp_data->st->own;
+	ret = sfp_read_a0(tcv, sfp_data);
 	if(ret < 0 ){
 		/*
 		 * Make sure we free after read-error
 		 * smart pointers would be really nice...
 		 */
+		sfp_static_free(&sfp_data->st->hdr);
 		free(sfp_data);
 		return ret;
 	}
 	sfp_data->type  = TCV_TYPE_SFP;
+	sfp_data->calib_loaded = false;
+	sfp_data->dd_page = -1;
+	sfp_data->user_eeprom_valid = false;
+	sfp_data->dd_cache_valid = false;
+	sfp_data->dd_cache_stats.hits = 0;
+	sfp_data->dd_cache_stats.misses = 0;
+	sfp_data->ra_open = false;
+	sfp_data->ra_filled = false;
+	sfp_data->ra_demand = 16;
+	sfp_data->ra_cost[0] = 0;
+	sfp_data->ra_cost[1] = 0;
+	sfp_data->ra_windows = 0;
+	sfp_data->ra_measured[0] = 0;
+	sfp_data->ra_measured[1] = 0;
+	memset(&sfp_data->ra_stats, 0, sizeof(sfp_data->ra_stats));
+	tcv_state_wrlock(tcv);
 	tcv->data = sfp_data;
 	tcv->fun = &sfp_funcs;
 	tcv->initialized = true;
+	/* static getters from here on */
+	tcv_static_publish(tcv, &sfp_data->st->hdr);
+	tcv_state_unlock(tcv);
+
+	/* Decode the calibration mode once, readings dispatch straight to the
+	 * matching implementation */
+	calib = sfp_dd_type(tcv);
+	sfp_data->dd = sfp_dd_ops_for(calib);
+
+	/* External calibration constants are static, read them once. On failure
+	 * they are loaded again on first use */
+	if (calib == DD_CALIB_EXTERNAL)
+		sfp_load_calibration(tcv);
+
 	return 0;
 }
 
 /******************************************************************************/
 
-int sfp_get_identifier(tcv_t *tcv)
+static int sfp_static_get_identifier(const struct tcv_static *st)
 {
-	return ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_IDENTIFIER];
+	return sfp_a0_byte(st, BASIC_INFO_REG_IDENTIFIER);
 }
 
 /******************************************************************************/
 
-int sfp_get_ext_identifier(tcv_t *tcv)
+static int sfp_static_get_ext_identifier(const struct tcv_static *st)
 {
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
-	return ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_EXT_IDENTIFIER];
+	return sfp_a0_byte(st, BASIC_INFO_REG_EXT_IDENTIFIER);
 }
 
 /******************************************************************************/
 
-int sfp_get_connector(tcv_t *tcv)
+static int sfp_static_get_connector(const struct tcv_static *st)
 {
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
-	return ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_CONNECTOR];
+	return sfp_a0_byte(st, BASIC_INFO_REG_CONNECTOR);
 }
 
 /******************************************************************************/
@@ -325,12 +728,10 @@ int sfp_get_connector(tcv_t *tcv)
 #define SFP_10G_ETH_COMPLIANCE_REG	BASIC_INFO_REG_ELETRONIC_COMPATIBILITIE_1 + 0
 #define SFP_10G_ETH_COMPLIANCE_MASK	0xF0
 
-int sfp_get_10g_compliance_codes(tcv_t *tcv, tcv_10g_eth_compliance_codes_t *codes)
+static int sfp_static_get_10g_compliance_codes(const struct tcv_static *st,
+                                               tcv_10g_eth_compliance_codes_t *codes)
 {
-	if (tcv == NULL || codes == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
-	uint8_t raw = ((sfp_data_t*)tcv->data)->a0[SFP_10G_ETH_COMPLIANCE_REG];
+	uint8_t raw = sfp_a0_byte(st, SFP_10G_ETH_COMPLIANCE_REG);
 	/* Fill bitmap */
 	codes->bmp = ( raw & SFP_10G_ETH_COMPLIANCE_MASK) >> 4;
 
@@ -353,15 +754,13 @@ int sfp_get_10g_compliance_codes(tcv_t *tcv, tcv_10g_eth_compliance_codes_t *cod
 #define INFINIBAND_COMPLIANCE_REG	BASIC_INFO_REG_ELETRONIC_COMPATIBILITIE_1 + 0
 #define INFINIBAND_MASK 0x0F
 
-int sfp_get_infiniband_compliance_codes(tcv_t *tcv, tcv_infiniband_compliance_codes_t *codes)
+static int sfp_static_get_infiniband_compliance_codes(const struct tcv_static *st,
+                                                      tcv_infiniband_compliance_codes_t *codes)
 {
-	if (tcv == NULL || codes == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Clear bitmap */
 	codes->bmp = 0;
 
-	codes->bmp = ((sfp_data_t*)tcv->data)->a0[INFINIBAND_COMPLIANCE_REG] & INFINIBAND_MASK;
+	codes->bmp = sfp_a0_byte(st, INFINIBAND_COMPLIANCE_REG) & INFINIBAND_MASK;
 
 	return 0;
 }
@@ -380,15 +779,13 @@ int sfp_get_infiniband_compliance_codes(tcv_t *tcv, tcv_infiniband_compliance_co
 #define ESCON_COMPLIANCE_REG	BASIC_INFO_REG_ELETRONIC_COMPATIBILITIE_1 + 1
 #define ESCON_MASK 				0xC0
 
-int sfp_get_escon_compliance_codes(tcv_t *tcv, tcv_escon_compliance_codes_t *codes)
+static int sfp_static_get_escon_compliance_codes(const struct tcv_static *st,
+                                                 tcv_escon_compliance_codes_t *codes)
 {
-	if (tcv == NULL || codes == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Clear bitmap */
 	codes->bmp = 0;
 
-	codes->bmp = (((sfp_data_t*)tcv->data)->a0[ESCON_COMPLIANCE_REG] & ESCON_MASK) >> 6;
+	codes->bmp = (sfp_a0_byte(st, ESCON_COMPLIANCE_REG) & ESCON_MASK) >> 6;
 
 	return 0;
 }
@@ -430,24 +827,22 @@ int sfp_get_escon_compliance_codes(tcv_t *tcv, tcv_escon_compliance_codes_t *cod
 #define SONET_COMPLIANCE_REG_1	BASIC_INFO_REG_ELETRONIC_COMPATIBILITIE_1 + 1
 #define SONET_COMPLIANCE_REG_2	BASIC_INFO_REG_ELETRONIC_COMPATIBILITIE_1 + 2
 
-int sfp_get_sonet_compliance_codes(tcv_t *tcv, tcv_sonet_compliance_codes_t *codes)
+static int sfp_static_get_sonet_compliance_codes(const struct tcv_static *st,
+                                                 tcv_sonet_compliance_codes_t *codes)
 {
-	if (tcv == NULL || codes == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Clear bitmap */
 	codes->bmp = 0;
 
-	codes->bits.oc_192_sr = !! (((sfp_data_t*)tcv->data)->a0[SONET_COMPLIANCE_REG_1] & SONET_OC192_SR);
-	codes->bits.oc_48_lr = !! (((sfp_data_t*)tcv->data)->a0[SONET_COMPLIANCE_REG_1] & SONET_OC48_LR);
-	codes->bits.oc_48_ir = !! (((sfp_data_t*)tcv->data)->a0[SONET_COMPLIANCE_REG_1] & SONET_OC48_IR);
-	codes->bits.oc_48_sr = !! (((sfp_data_t*)tcv->data)->a0[SONET_COMPLIANCE_REG_1] & SONET_OC48_SR);
-	codes->bits.oc_12_sm_lr = !! (((sfp_data_t*)tcv->data)->a0[SONET_COMPLIANCE_REG_2] & SONET_OC12_SM_LR);
-	codes->bits.oc_12_sm_ir = !! (((sfp_data_t*)tcv->data)->a0[SONET_COMPLIANCE_REG_2] & SONET_OC12_SM_IR);
-	codes->bits.oc_12_sr = !! (((sfp_data_t*)tcv->data)->a0[SONET_COMPLIANCE_REG_2] & SONET_OC12_SR);
-	codes->bits.oc_3_sm_lr = !! (((sfp_data_t*)tcv->data)->a0[SONET_COMPLIANCE_REG_2] & SONET_OC3_SM_LR);
-	codes->bits.oc_3_sm_ir = !! (((sfp_data_t*)tcv->data)->a0[SONET_COMPLIANCE_REG_2] & SONET_OC3_SM_IR);
-	codes->bits.oc_3_sr = !! (((sfp_data_t*)tcv->data)->a0[SONET_COMPLIANCE_REG_2] & SONET_OC3_SR);
+	codes->bits.oc_192_sr = !! (sfp_a0_byte(st, SONET_COMPLIANCE_REG_1) & SONET_OC192_SR);
+	codes->bits.oc_48_lr = !! (sfp_a0_byte(st, SONET_COMPLIANCE_REG_1) & SONET_OC48_LR);
+	codes->bits.oc_48_ir = !! (sfp_a0_byte(st, SONET_COMPLIANCE_REG_1) & SONET_OC48_IR);
+	codes->bits.oc_48_sr = !! (sfp_a0_byte(st, SONET_COMPLIANCE_REG_1) & SONET_OC48_SR);
+	codes->bits.oc_12_sm_lr = !! (sfp_a0_byte(st, SONET_COMPLIANCE_REG_2) & SONET_OC12_SM_LR);
+	codes->bits.oc_12_sm_ir = !! (sfp_a0_byte(st, SONET_COMPLIANCE_REG_2) & SONET_OC12_SM_IR);
+	codes->bits.oc_12_sr = !! (sfp_a0_byte(st, SONET_COMPLIANCE_REG_2) & SONET_OC12_SR);
+	codes->bits.oc_3_sm_lr = !! (sfp_a0_byte(st, SONET_COMPLIANCE_REG_2) & SONET_OC3_SM_LR);
+	codes->bits.oc_3_sm_ir = !! (sfp_a0_byte(st, SONET_COMPLIANCE_REG_2) & SONET_OC3_SM_IR);
+	codes->bits.oc_3_sr = !! (sfp_a0_byte(st, SONET_COMPLIANCE_REG_2) & SONET_OC3_SR);
 
 	return 0;
 }
@@ -471,26 +866,24 @@ int sfp_get_sonet_compliance_codes(tcv_t *tcv, tcv_sonet_compliance_codes_t *cod
 #define SONET_REACH_SPECIFIER_1	(1 << 4)
 #define SONET_REACH_SPECIFIER_2	(1 << 3)
 
-int sfp_get_sonet_compliances(tcv_t *tcv, tcv_sonet_compliances_t *compliances)
+static int sfp_static_get_sonet_compliances(const struct tcv_static *st,
+                                            tcv_sonet_compliances_t *compliances)
 {
 	tcv_sonet_compliance_codes_t codes;
 	bool spec_bit_1, spec_bit_2;
 	int ret;
 
-	if (tcv == NULL || compliances == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Clear bitmap */
 	compliances->bmp = 0;
 
 	/* Get set compliance codes */
-	ret = tcv_get_sonet_compliance_codes(tcv, &codes);
+	ret = sfp_static_get_sonet_compliance_codes(st, &codes);
 	if (ret < 0)
 		return ret;
 
 	/* Get the specifiers bit */
-	spec_bit_1 = !! (((sfp_data_t*)tcv->data)->a0[SONET_COMPLIANCE_REG_1] & SONET_REACH_SPECIFIER_1);
-	spec_bit_2 = !! (((sfp_data_t*)tcv->data)->a0[SONET_COMPLIANCE_REG_1] & SONET_REACH_SPECIFIER_2);
+	spec_bit_1 = !! (sfp_a0_byte(st, SONET_COMPLIANCE_REG_1) & SONET_REACH_SPECIFIER_1);
+	spec_bit_2 = !! (sfp_a0_byte(st, SONET_COMPLIANCE_REG_1) & SONET_REACH_SPECIFIER_2);
 
 	/* Verifie short reach */
 	if (codes.bits.oc_192_sr || codes.bits.oc_48_sr || codes.bits.oc_12_sr || codes.bits.oc_3_sr) {
@@ -540,13 +933,11 @@ int sfp_get_sonet_compliances(tcv_t *tcv, tcv_sonet_compliances_t *compliances)
 
 #define ETH_COMPLIANCE_REG_1	BASIC_INFO_REG_ELETRONIC_COMPATIBILITIE_1 + 3
 
-int sfp_get_eth_compliance_codes(tcv_t *tcv, tcv_eth_compliance_codes_t *codes)
+static int sfp_static_get_eth_compliance_codes(const struct tcv_static *st,
+                                               tcv_eth_compliance_codes_t *codes)
 {
-	if (tcv == NULL || codes == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Fill bitmap */
-	codes->bmp = ((sfp_data_t*)tcv->data)->a0[ETH_COMPLIANCE_REG_1];
+	codes->bmp = sfp_a0_byte(st, ETH_COMPLIANCE_REG_1);
 
 	return 0;
 }
@@ -568,16 +959,14 @@ int sfp_get_eth_compliance_codes(tcv_t *tcv, tcv_eth_compliance_codes_t *codes)
 #define LINK_LENGTH_REG		BASIC_INFO_REG_ELETRONIC_COMPATIBILITIE_1 + 4
 #define LINK_LENGTH_MASK	0xF8
 
-int sfp_get_fibre_channel_link_length(tcv_t *tcv, tcv_fibre_channel_link_length_t *lengths)
+static int sfp_static_get_fibre_channel_link_length(const struct tcv_static *st,
+                                                    tcv_fibre_channel_link_length_t *lengths)
 {
-	if (tcv == NULL || lengths == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Clear bitmap */
 	lengths->bmp = 0;
 
 	/* Fill bitmap */
-	lengths->bmp = (((sfp_data_t*)tcv->data)->a0[LINK_LENGTH_REG] & LINK_LENGTH_MASK) >> 3;
+	lengths->bmp = (sfp_a0_byte(st, LINK_LENGTH_REG) & LINK_LENGTH_MASK) >> 3;
 
 	return 0;
 }
@@ -603,17 +992,15 @@ int sfp_get_fibre_channel_link_length(tcv_t *tcv, tcv_fibre_channel_link_length_
 #define FIBRE_CHANNEL_TECH_REG_2	BASIC_INFO_REG_ELETRONIC_COMPATIBILITIE_1 + 5
 #define FIBRE_CHANNEL_TECH_MASK_2	0xF0
 
-int sfp_get_fibre_channel_technology(tcv_t *tcv, tcv_fibre_channel_technology_t *technology)
+static int sfp_static_get_fibre_channel_technology(const struct tcv_static *st,
+                                                   tcv_fibre_channel_technology_t *technology)
 {
-	if (tcv == NULL || technology == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Clear bitmap */
 	technology->bmp = 0;
 
 	/* Fill bitmap */
-	technology->bmp |= (((sfp_data_t*)tcv->data)->a0[FIBRE_CHANNEL_TECH_REG_1] & FIBRE_CHANNEL_TECH_MASK_1) << 4;
-	technology->bmp |= (((sfp_data_t*)tcv->data)->a0[FIBRE_CHANNEL_TECH_REG_2] & FIBRE_CHANNEL_TECH_MASK_2) >> 4;
+	technology->bmp |= (sfp_a0_byte(st, FIBRE_CHANNEL_TECH_REG_1) & FIBRE_CHANNEL_TECH_MASK_1) << 4;
+	technology->bmp |= (sfp_a0_byte(st, FIBRE_CHANNEL_TECH_REG_2) & FIBRE_CHANNEL_TECH_MASK_2) >> 4;
 
 	return 0;
 }
@@ -632,16 +1019,14 @@ int sfp_get_fibre_channel_technology(tcv_t *tcv, tcv_fibre_channel_technology_t
 #define SFP_PLUS_TECH_REG	BASIC_INFO_REG_ELETRONIC_COMPATIBILITIE_1 + 5
 #define SFP_PLUS_TECH_MASK	0x0C
 
-int sfp_get_sfp_plus_cable_technology(tcv_t *tcv, sfp_plus_cable_technology_t *technology)
+static int sfp_static_get_sfp_plus_cable_technology(const struct tcv_static *st,
+                                                    sfp_plus_cable_technology_t *technology)
 {
-	if (tcv == NULL || technology == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Clear bitmap */
 	technology->bmp = 0;
 
 	/* Fill bitmap */
-	technology->bmp = (((sfp_data_t*)tcv->data)->a0[SFP_PLUS_TECH_REG] & SFP_PLUS_TECH_MASK) >> 2;
+	technology->bmp = (sfp_a0_byte(st, SFP_PLUS_TECH_REG) & SFP_PLUS_TECH_MASK) >> 2;
 
 	return 0;
 }
@@ -666,17 +1051,15 @@ int sfp_get_sfp_plus_cable_technology(tcv_t *tcv, sfp_plus_cable_technology_t *t
 #define MEDIA_MASK_1	0xFC
 #define MEDIA_MASK_2	0x01
 
-int sfp_get_fibre_channel_media(tcv_t *tcv, tcv_fibre_channel_media_t *media)
+static int sfp_static_get_fibre_channel_media(const struct tcv_static *st,
+                                              tcv_fibre_channel_media_t *media)
 {
-	if (tcv == NULL || media == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Clear bitmap */
 	media->bmp = 0;
 
 	/* Fill bitmap */
-	media->bmp |= (((sfp_data_t*)tcv->data)->a0[MEDIA_REG] & MEDIA_MASK_1) >> 1;
-	media->bmp |= ((sfp_data_t*)tcv->data)->a0[MEDIA_REG] & MEDIA_MASK_2;
+	media->bmp |= (sfp_a0_byte(st, MEDIA_REG) & MEDIA_MASK_1) >> 1;
+	media->bmp |= sfp_a0_byte(st, MEDIA_REG) & MEDIA_MASK_2;
 	return 0;
 }
 
@@ -700,71 +1083,57 @@ int sfp_get_fibre_channel_media(tcv_t *tcv, tcv_fibre_channel_media_t *media)
 #define FIBRE_CHANNEL_SPEED_MASK_1	0xFC
 #define FIBRE_CHANNEL_SPEED_MASK_2	0x01
 
-int sfp_get_fibre_channel_speed(tcv_t *tcv, fibre_channel_speed_t *speed)
+static int sfp_static_get_fibre_channel_speed(const struct tcv_static *st,
+                                              fibre_channel_speed_t *speed)
 {
-	if (tcv == NULL || speed == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Clear bitmap */
 	speed->bmp = 0;
 
 	/* Fill bitmap */
-	speed->bmp |= (((sfp_data_t*)tcv->data)->a0[MEDIA_REG] & MEDIA_MASK_1) >> 1;
-	speed->bmp |= ((sfp_data_t*)tcv->data)->a0[MEDIA_REG] & MEDIA_MASK_2;
+	speed->bmp |= (sfp_a0_byte(st, MEDIA_REG) & MEDIA_MASK_1) >> 1;
+	speed->bmp |= sfp_a0_byte(st, MEDIA_REG) & MEDIA_MASK_2;
 
 	return 0;
 }
 
 /******************************************************************************/
 
-int sfp_get_encoding(tcv_t *tcv)
+static int sfp_static_get_encoding(const struct tcv_static *st)
 {
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
-	return ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_ENCODING];
+	return sfp_a0_byte(st, BASIC_INFO_REG_ENCODING);
 }
 
 /******************************************************************************/
 
-int sfp_get_nominal_bit_rate(tcv_t *tcv)
+static int sfp_static_get_nominal_bit_rate(const struct tcv_static *st)
 {
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
-	if (((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_NOMINAL_BIT_RATE] != 0xFF)
+	if (sfp_a0_byte(st, BASIC_INFO_REG_NOMINAL_BIT_RATE) != 0xFF)
 		/* In register the bit rate is in units of 100MBytes */
-		return ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_NOMINAL_BIT_RATE] * 100;
+		return sfp_a0_byte(st, BASIC_INFO_REG_NOMINAL_BIT_RATE) * 100;
 
 	/* To 0xFF value, the bit rate is at BASIC_INFO_REG_BIT_RATE_MAX, in units of 250MBytes */
-	return ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_BIT_RATE_MAX] * 250;
+	return sfp_a0_byte(st, BASIC_INFO_REG_BIT_RATE_MAX) * 250;
 }
 
 /******************************************************************************/
 
-int sfp_get_rate_identifier(tcv_t *tcv)
+static int sfp_static_get_rate_identifier(const struct tcv_static *st)
 {
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
-	return ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_RATE_IDENTIFIER];
+	return sfp_a0_byte(st, BASIC_INFO_REG_RATE_IDENTIFIER);
 }
 
 /******************************************************************************/
 
-int sfp_get_sm_length(tcv_t *tcv)
+static int sfp_static_get_sm_length(const struct tcv_static *st)
 {
 	unsigned char length;
 
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Normalize length to meters */
-	length = ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_LENGTH_SMF_KM] * 1000;
+	length = sfp_a0_byte(st, BASIC_INFO_REG_LENGTH_SMF_KM) * 1000;
 
 	/* If Km length is 0, try to read from meters unit register */
 	if (length == 0)
-		length = ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_LENGTH_SMF_100M] * 100;
+		length = sfp_a0_byte(st, BASIC_INFO_REG_LENGTH_SMF_100M) * 100;
 
 
 	return length == 0 ? TCV_ERR_SM_LENGTH_NOT_DEFINED : length;
@@ -772,38 +1141,32 @@ int sfp_get_sm_length(tcv_t *tcv)
 
 /******************************************************************************/
 
-int sfp_get_om2_length(tcv_t *tcv)
+static int sfp_static_get_om2_length(const struct tcv_static *st)
 {
 	unsigned char length;
 
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Normalize length to meters */
-	length = ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_LENGTH_OM2_10M] * 10;
+	length = sfp_a0_byte(st, BASIC_INFO_REG_LENGTH_OM2_10M) * 10;
 
 	return length == 0 ? TCV_ERR_OM2_LENGTH_NOT_DEFINED : length;
 }
 
 /******************************************************************************/
 
-int sfp_get_om1_length(tcv_t *tcv)
+static int sfp_static_get_om1_length(const struct tcv_static *st)
 {
 	unsigned char length;
 
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Normalize length to meters */
-	length = ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_LENGTH_OM1_10M] * 10;
+	length = sfp_a0_byte(st, BASIC_INFO_REG_LENGTH_OM1_10M) * 10;
 
 	return length == 0 ? TCV_ERR_OM1_LENGTH_NOT_DEFINED : length;
 }
 
 /******************************************************************************/
-static bool sfp_is_optical(tcv_t *tcv)
+static bool sfp_is_optical(const struct tcv_static *st)
 {
-	int conntype = tcv_get_connector(tcv);
+	int conntype = sfp_static_get_connector(st);
 	if (conntype < 0)
 		return false;
 
@@ -836,68 +1199,57 @@ static bool sfp_is_optical(tcv_t *tcv)
 	}
 }
 
-int sfp_get_om4_length_copper_length(tcv_t *tcv)
+static int sfp_static_get_om4_length_copper_length(const struct tcv_static *st)
 {
 	unsigned char length;
 
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Normalize length to meters. Optical link is measured in units of 10 meters
 	 * and copper link is measured in units of 1 meter. */
-	if (sfp_is_optical(tcv))
-		length = ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_LENGTH_OM4_10M_COPPER_1M] * 10;
+	if (sfp_is_optical(st))
+		length = sfp_a0_byte(st, BASIC_INFO_REG_LENGTH_OM4_10M_COPPER_1M) * 10;
 	else
-		length = ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_LENGTH_OM4_10M_COPPER_1M];
+		length = sfp_a0_byte(st, BASIC_INFO_REG_LENGTH_OM4_10M_COPPER_1M);
 
 	return length == 0 ? TCV_ERR_OM4_LENGTH_NOT_DEFINED : length;
 }
 
 /******************************************************************************/
 
-int sfp_get_om3_length(tcv_t *tcv)
+static int sfp_static_get_om3_length(const struct tcv_static *st)
 {
 	unsigned char length;
 
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Normalize length to meters */
-	length = ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_LENGTH_OM3_10M] * 10;
+	length = sfp_a0_byte(st, BASIC_INFO_REG_LENGTH_OM3_10M) * 10;
 
 	return length == 0 ? TCV_ERR_OM3_LENGTH_NOT_DEFINED : length;
 }
 
 /******************************************************************************/
 
-int sfp_get_vendor_name(tcv_t *tcv, char vendor_name[BASIC_INFO_REG_VENDOR_NAME_SIZE + 1])
+static int sfp_static_get_vendor_name(const struct tcv_static *st,
+                                      char vendor_name[BASIC_INFO_REG_VENDOR_NAME_SIZE + 1])
 {
-	if (tcv == NULL || vendor_name == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Indicates end of string */
 	vendor_name[BASIC_INFO_REG_VENDOR_NAME_SIZE] = '\0';
 
-	memcpy(vendor_name, &((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_VENDOR_NAME], BASIC_INFO_REG_VENDOR_NAME_SIZE);
+	memcpy(vendor_name, sfp_a0_field(st, BASIC_INFO_REG_VENDOR_NAME), BASIC_INFO_REG_VENDOR_NAME_SIZE);
 
 	return 0;
 }
 
 /******************************************************************************/
 
-int sfp_get_vendor_oui(tcv_t *tcv)
+static int sfp_static_get_vendor_oui(const struct tcv_static *st)
 {
 	uint32_t oui = 0;
 	int i;
 
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Concatenate the 3 bytes in just one variable */
 	for (i = 0; i < BASIC_INFO_REG_VENDOR_OUI_SIZE_SIZE; i++){
 		/* bytes are stored in eeprom in big endian order */
 		oui = (oui<< 8);
-		oui |= ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_VENDOR_OUI+i];
+		oui |= sfp_a0_byte(st, BASIC_INFO_REG_VENDOR_OUI+i);
 	}
 
 	return oui;
@@ -905,46 +1257,39 @@ int sfp_get_vendor_oui(tcv_t *tcv)
 
 /******************************************************************************/
 
-int sfp_get_vendor_part_number(tcv_t *tcv, char pn[BASIC_INFO_REG_VENDOR_PN_SIZE + 1])
+static int sfp_static_get_vendor_part_number(const struct tcv_static *st,
+                                             char pn[BASIC_INFO_REG_VENDOR_PN_SIZE + 1])
 {
-	if (tcv == NULL || pn == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Indicates end of string */
 	pn[BASIC_INFO_REG_VENDOR_PN_SIZE] = '\0';
 
-	memcpy(pn, &((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_VENDOR_PN], BASIC_INFO_REG_VENDOR_PN_SIZE);
+	memcpy(pn, sfp_a0_field(st, BASIC_INFO_REG_VENDOR_PN), BASIC_INFO_REG_VENDOR_PN_SIZE);
 
 	return 0;
 }
 
 /******************************************************************************/
 
-int sfp_get_vendor_revision(tcv_t *tcv, char rev[BASIC_INFO_REG_VENDOR_REV_SIZE + 1])
+static int sfp_static_get_vendor_revision(const struct tcv_static *st,
+                                          char rev[BASIC_INFO_REG_VENDOR_REV_SIZE + 1])
 {
-	if (tcv == NULL || rev == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Indicates end of string */
 	rev[BASIC_INFO_REG_VENDOR_REV_SIZE] = '\0';
 
-	memcpy(rev, &((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_VENDOR_REV], BASIC_INFO_REG_VENDOR_REV_SIZE);
+	memcpy(rev, sfp_a0_field(st, BASIC_INFO_REG_VENDOR_REV), BASIC_INFO_REG_VENDOR_REV_SIZE);
 
 	return 0;
 }
 
 /******************************************************************************/
 
-int sfp_get_wavelength(tcv_t *tcv)
+static int sfp_static_get_wavelength(const struct tcv_static *st)
 {
 	unsigned int length = 0;
 	int ret;
 	sfp_plus_cable_technology_t tech;
 
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
-	ret = tcv_get_sfp_plus_cable_technology(tcv, &tech);
+	ret = sfp_static_get_sfp_plus_cable_technology(st, &tech);
 	if (ret < 0)
 		return ret;
 
@@ -954,8 +1299,8 @@ int sfp_get_wavelength(tcv_t *tcv)
 
 	/* The first address is the high part of the 16 bit wavelength and the next
 	 * address is the low part */
-	length |= ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_WAVELENGTH] << 8;
-	length |= ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_WAVELENGTH + 1];
+	length |= sfp_a0_byte(st, BASIC_INFO_REG_WAVELENGTH) << 8;
+	length |= sfp_a0_byte(st, BASIC_INFO_REG_WAVELENGTH + 1);
 
 	return length;
 }
@@ -977,15 +1322,13 @@ int sfp_get_wavelength(tcv_t *tcv)
 #define FC_PI_4_APENDIX_H_COMPLIANT		(1 << 1)
 #define SFF_8431_APENDIX_E_COMPLIANT	(1 << 0)
 
-int sfp_get_passive_cable_compliance(tcv_t *tcv, passive_cable_compliance_t *compliance)
+static int sfp_static_get_passive_cable_compliance(const struct tcv_static *st,
+                                                   passive_cable_compliance_t *compliance)
 {
 	int ret;
 	sfp_plus_cable_technology_t tech;
 
-	if (tcv == NULL || compliance == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
-	ret = tcv_get_sfp_plus_cable_technology(tcv, &tech);
+	ret = sfp_static_get_sfp_plus_cable_technology(st, &tech);
 	if (ret < 0)
 		return ret;
 
@@ -997,10 +1340,10 @@ int sfp_get_passive_cable_compliance(tcv_t *tcv, passive_cable_compliance_t *com
 	compliance->bmp = 0;
 
 	compliance->bits.fc_pi_4_apndx_h_compliant =
-		!! (((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_WAVELENGTH] & FC_PI_4_APENDIX_H_COMPLIANT);
+		!! (sfp_a0_byte(st, BASIC_INFO_REG_WAVELENGTH) & FC_PI_4_APENDIX_H_COMPLIANT);
 
 	compliance->bits.sff_8431_apndx_e_compliant =
-		!! (((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_WAVELENGTH] & SFF_8431_APENDIX_E_COMPLIANT);
+		!! (sfp_a0_byte(st, BASIC_INFO_REG_WAVELENGTH) & SFF_8431_APENDIX_E_COMPLIANT);
 
 	return 0;
 }
@@ -1023,15 +1366,13 @@ int sfp_get_passive_cable_compliance(tcv_t *tcv, passive_cable_compliance_t *com
 #define FC_PI_4_LIMITING_COMPLIANT	(1 << 3)
 #define SFF_8431_LIMITING_COMPLIANT	(1 << 2)
 
-int sfp_get_active_cable_compliance(tcv_t *tcv, active_cable_compliance_t *compliance)
+static int sfp_static_get_active_cable_compliance(const struct tcv_static *st,
+                                                  active_cable_compliance_t *compliance)
 {
 	int ret;
 	sfp_plus_cable_technology_t tech;
 
-	if (tcv == NULL || compliance == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
-	ret = tcv_get_sfp_plus_cable_technology(tcv, &tech);
+	ret = sfp_static_get_sfp_plus_cable_technology(st, &tech);
 	if (ret < 0)
 		return ret;
 
@@ -1043,28 +1384,25 @@ int sfp_get_active_cable_compliance(tcv_t *tcv, active_cable_compliance_t *compl
 	compliance->bmp = 0;
 
 	compliance->bits.fc_pi_4_limiting_compliant =
-		!! (((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_WAVELENGTH] & FC_PI_4_LIMITING_COMPLIANT);
+		!! (sfp_a0_byte(st, BASIC_INFO_REG_WAVELENGTH) & FC_PI_4_LIMITING_COMPLIANT);
 
 	compliance->bits.sff_8431_limiting_compliant =
-		!! (((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_WAVELENGTH] & SFF_8431_LIMITING_COMPLIANT);
+		!! (sfp_a0_byte(st, BASIC_INFO_REG_WAVELENGTH) & SFF_8431_LIMITING_COMPLIANT);
 
 	compliance->bits.fc_pi_4_apndx_h_compliant =
-		!! (((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_WAVELENGTH] & FC_PI_4_APENDIX_H_COMPLIANT);
+		!! (sfp_a0_byte(st, BASIC_INFO_REG_WAVELENGTH) & FC_PI_4_APENDIX_H_COMPLIANT);
 
 	compliance->bits.sff_8431_apndx_e_compliant =
-		!! (((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_WAVELENGTH] & SFF_8431_APENDIX_E_COMPLIANT);
+		!! (sfp_a0_byte(st, BASIC_INFO_REG_WAVELENGTH) & SFF_8431_APENDIX_E_COMPLIANT);
 
 	return 0;
 }
 
 /******************************************************************************/
 
-int sfp_get_cc_base(tcv_t *tcv)
+static int sfp_static_get_cc_base(const struct tcv_static *st)
 {
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
-	return ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_CC_BASE];
+	return sfp_a0_byte(st, BASIC_INFO_REG_CC_BASE);
 }
 
 /******************************************************************************/
@@ -1072,18 +1410,15 @@ int sfp_get_cc_base(tcv_t *tcv)
 #define FIRST_CC_BASE_ADDR	0x00
 #define LAST_CC_BASE_ADDR	0x3E
 
-int sfp_calculate_cc_base(tcv_t *tcv)
+static int sfp_static_calculate_cc_base(const struct tcv_static *st)
 {
 	int i;
 	int sum = 0;
 
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* The CC Base is the low order 8 bits of the sum of the contents of all
 	 * bytes from 0x00 to 0x62 */
 	for (i = FIRST_CC_BASE_ADDR; i <= LAST_CC_BASE_ADDR; i++)
-		sum += ((sfp_data_t*)tcv->data)->a0[i];
+		sum += sfp_a0_byte(st, i);
 
 	/* Return low order 8 bits only */
 	return (sum & 0xff);
@@ -1118,66 +1453,56 @@ int sfp_calculate_cc_base(tcv_t *tcv)
 #define OPTION_SIG_DETECT		(1 << 2) /* BASIC_INFO_REG_OPTIONS + 1 */
 #define OPTION_LOS				(1 << 1) /* BASIC_INFO_REG_OPTIONS + 1 */
 
-int sfp_get_implemented_options(tcv_t *tcv, tcv_implemented_options_t *options)
+static int sfp_static_get_implemented_options(const struct tcv_static *st,
+                                              tcv_implemented_options_t *options)
 {
-	if (tcv == NULL || options == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Clear options */
 	options->bmp = 0;
 
 	/* Information stored in BASIC_INFO_REG_OPTIONS */
-	options->bits.cooled_laser_transmitted = ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_OPTIONS];
-	options->bits.power_lever_2 = ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_OPTIONS];
-	options->bits.linear_receiver_out = ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_OPTIONS];
+	options->bits.cooled_laser_transmitted = sfp_a0_byte(st, BASIC_INFO_REG_OPTIONS);
+	options->bits.power_lever_2 = sfp_a0_byte(st, BASIC_INFO_REG_OPTIONS);
+	options->bits.linear_receiver_out = sfp_a0_byte(st, BASIC_INFO_REG_OPTIONS);
 
 	/* Information stored in BASIC_INFO_REG_OPTIONS + 1 */
-	options->bits.rate_select = ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_OPTIONS + 1];
-	options->bits.tx_disable = ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_OPTIONS + 1];
-	options->bits.tx_fault = ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_OPTIONS + 1];
-	options->bits.signal_detect = ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_OPTIONS + 1];
-	options->bits.los = ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_OPTIONS + 1];
+	options->bits.rate_select = sfp_a0_byte(st, BASIC_INFO_REG_OPTIONS + 1);
+	options->bits.tx_disable = sfp_a0_byte(st, BASIC_INFO_REG_OPTIONS + 1);
+	options->bits.tx_fault = sfp_a0_byte(st, BASIC_INFO_REG_OPTIONS + 1);
+	options->bits.signal_detect = sfp_a0_byte(st, BASIC_INFO_REG_OPTIONS + 1);
+	options->bits.los = sfp_a0_byte(st, BASIC_INFO_REG_OPTIONS + 1);
 
 	return 0;
 }
 
 /******************************************************************************/
 
-int sfp_get_max_bit_rate(tcv_t *tcv)
+static int sfp_static_get_max_bit_rate(const struct tcv_static *st)
 {
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* If nominal rate is set to 0xFF, BASIC_INFO_REG_BIT_RATE_MAX register has
 	 * the nominal bit rate information and BASIC_INFO_REG_BIT_RATE_MIN has the
 	 * max and min bit rate (in this case max and min BR are symmetrical. */
-	if (((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_NOMINAL_BIT_RATE] == 0xFF)
-		return ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_BIT_RATE_MIN];
+	if (sfp_a0_byte(st, BASIC_INFO_REG_NOMINAL_BIT_RATE) == 0xFF)
+		return sfp_a0_byte(st, BASIC_INFO_REG_BIT_RATE_MIN);
 
-	return ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_BIT_RATE_MAX];
+	return sfp_a0_byte(st, BASIC_INFO_REG_BIT_RATE_MAX);
 }
 
 /******************************************************************************/
 
-int sfp_get_min_bit_rate(tcv_t *tcv)
+static int sfp_static_get_min_bit_rate(const struct tcv_static *st)
 {
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
-	return ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_BIT_RATE_MIN];
+	return sfp_a0_byte(st, BASIC_INFO_REG_BIT_RATE_MIN);
 }
 
 /******************************************************************************/
 
-int sfp_get_vendor_sn(tcv_t *tcv, char vendor_sn[TCV_VENDOR_SN_SIZE + 1])
+static int sfp_static_get_vendor_sn(const struct tcv_static *st,
+                                    char vendor_sn[TCV_VENDOR_SN_SIZE + 1])
 {
-	if (tcv == NULL || vendor_sn == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Indicates end of string */
 	vendor_sn[TCV_VENDOR_SN_SIZE] = '\0';
 
-	memcpy(vendor_sn, &((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_VENDOR_SN], TCV_VENDOR_SN_SIZE);
+	memcpy(vendor_sn, sfp_a0_field(st, BASIC_INFO_REG_VENDOR_SN), TCV_VENDOR_SN_SIZE);
 
 	return 0;
 }
@@ -1204,33 +1529,31 @@ int sfp_get_vendor_sn(tcv_t *tcv, char vendor_sn[TCV_VENDOR_SN_SIZE + 1])
 #define DATE_CODE_LOT		BASIC_INFO_REG_VENDOR_DATE_CODE + 6
 #define DATE_CODE_LOT_SIZE	2
 
-int sfp_get_vendor_date_code(tcv_t *tcv, tcv_date_code_t *date_code)
+static int sfp_static_get_vendor_date_code(const struct tcv_static *st,
+                                           tcv_date_code_t *date_code)
 {
 	char tmp[3];
 
-	if (tcv == NULL || date_code == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* Initialize tmp char with \0 */
 	tmp[2] = '\0';
 
 	/* Get year */
-	tmp[0] = ((sfp_data_t*)tcv->data)->a0[DATE_CODE_YEAR_1];
-	tmp[1] = ((sfp_data_t*)tcv->data)->a0[DATE_CODE_YEAR_2];
+	tmp[0] = sfp_a0_byte(st, DATE_CODE_YEAR_1);
+	tmp[1] = sfp_a0_byte(st, DATE_CODE_YEAR_2);
 	date_code->year = (uint16_t) atoi(tmp);
 
 	/* Get month */
-	tmp[0] = ((sfp_data_t*)tcv->data)->a0[DATE_CODE_MONTH_1];
-	tmp[1] = ((sfp_data_t*)tcv->data)->a0[DATE_CODE_MONTH_2];
+	tmp[0] = sfp_a0_byte(st, DATE_CODE_MONTH_1);
+	tmp[1] = sfp_a0_byte(st, DATE_CODE_MONTH_2);
 	date_code->month = (uint8_t)atoi(tmp);
 
 	/* Get day */
-	tmp[0] = ((sfp_data_t*)tcv->data)->a0[DATE_CODE_DAY_1];
-	tmp[1] = ((sfp_data_t*)tcv->data)->a0[DATE_CODE_DAY_2];
+	tmp[0] = sfp_a0_byte(st, DATE_CODE_DAY_1);
+	tmp[1] = sfp_a0_byte(st, DATE_CODE_DAY_2);
 	date_code->day =(uint8_t) atoi(tmp);
 
 	/* Get lot code */
-	memcpy(date_code->vendor_lot_code, &((sfp_data_t*)tcv->data)->a0[DATE_CODE_LOT], DATE_CODE_LOT_SIZE);
+	memcpy(date_code->vendor_lot_code, sfp_a0_field(st, DATE_CODE_LOT), DATE_CODE_LOT_SIZE);
 
 	return 0;
 }
@@ -1253,12 +1576,10 @@ int sfp_get_vendor_date_code(tcv_t *tcv, tcv_date_code_t *date_code)
 
 #define DIAG_TYPE_MASK 0x7C
 
-int sfp_get_diagnostic_type(tcv_t *tcv, tcv_diagnostic_type_t *diag_type)
+static int sfp_static_get_diagnostic_type(const struct tcv_static *st,
+                                          tcv_diagnostic_type_t *diag_type)
 {
-	if (tcv == NULL || diag_type == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
-	diag_type->bmp = (((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_DIAG_MONITORING_TYPE] & DIAG_TYPE_MASK) >> 2;
+	diag_type->bmp = (sfp_a0_byte(st, BASIC_INFO_REG_DIAG_MONITORING_TYPE) & DIAG_TYPE_MASK) >> 2;
 
 	return 0;
 }
@@ -1282,24 +1603,19 @@ int sfp_get_diagnostic_type(tcv_t *tcv, tcv_diagnostic_type_t *diag_type)
 
 #define ENHANCED_OPTIONS_MASK 0xFE
 
-int sfp_get_enhance_options(tcv_t *tcv, tcv_enhanced_options_type_t *options)
+static int sfp_static_get_enhance_options(const struct tcv_static *st,
+                                          tcv_enhanced_options_type_t *options)
 {
-	if (tcv == NULL || options == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
-	options->bmp = (((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_ENHANCED_OPTIONS] & ENHANCED_OPTIONS_MASK) >> 1;
+	options->bmp = (sfp_a0_byte(st, BASIC_INFO_REG_ENHANCED_OPTIONS) & ENHANCED_OPTIONS_MASK) >> 1;
 
 	return 0;
 }
 
 /******************************************************************************/
 
-int sfp_get_cc_ext(tcv_t *tcv)
+static int sfp_static_get_cc_ext(const struct tcv_static *st)
 {
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
-	return ((sfp_data_t*)tcv->data)->a0[BASIC_INFO_REG_CC_EXT];
+	return sfp_a0_byte(st, BASIC_INFO_REG_CC_EXT);
 }
 
 /******************************************************************************/
@@ -1307,342 +1623,1690 @@ int sfp_get_cc_ext(tcv_t *tcv)
 #define FIRST_CC_EXT_ADDR	0x40
 #define LAST_CC_EXT_ADDR	0x5E
 
-int sfp_calculate_cc_ext(tcv_t *tcv)
+static int sfp_static_calculate_cc_ext(const struct tcv_static *st)
 {
 	int i;
 	int sum = 0;
 
-	if (tcv == NULL || tcv->data == NULL)
-		return TCV_ERR_INVALID_ARG;
-
 	/* The CC Base is the low order 8 bits of the sum of the contents of all
 	 * bytes from 0x00 to 0x62 */
 	for (i = FIRST_CC_EXT_ADDR; i <= LAST_CC_EXT_ADDR; i++)
-		sum += ((sfp_data_t*)tcv->data)->a0[i];
+		sum += sfp_a0_byte(st, i);
 
 	/* Return low order 8 bits only */
 	return (sum & 0xff);
 }
 
-
 /******************************************************************************/
+/*
+ * The public getters acquire the static data once and pass it down, a
+ * concurrent tcv_init() can replace it between two calls but not within one.
+ */
 
-const uint8_t* sfp_get_vendor_rom(tcv_t *tcv)
+int sfp_get_identifier(tcv_t *tcv)
 {
-	const size_t VENDOR_ROM_OFFSET = 96;
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
 
-	if (tcv == NULL || tcv->data == NULL)
-		return NULL;
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
 
-	return &((sfp_data_t*) tcv->data)->a0[VENDOR_ROM_OFFSET];
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_identifier(st);
+	tcv_static_release(tcv, slot);
+	return ret;
 }
 
 /******************************************************************************/
 
-static size_t sfp_get_vendor_rom_size(tcv_t *tcv)
+int sfp_get_ext_identifier(tcv_t *tcv)
 {
-	if (tcv == NULL || tcv->data == NULL)
-		return 0;
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
 
-	return 32;
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_ext_identifier(st);
+	tcv_static_release(tcv, slot);
+	return ret;
 }
 
 /******************************************************************************/
 
-const uint8_t* sfp_get_user_writable_eeprom(tcv_t *tcv)
+int sfp_get_connector(tcv_t *tcv)
 {
-	const uint8_t USER_WRITABLE_EEPROM_OFFSET = 128;
-	int ret;
-	sfp_data_t *sfp_data;
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
 
-	if (tcv == NULL || tcv->data == NULL)
-		return 0;
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
 
-	sfp_data = (sfp_data_t *) tcv->data;
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_connector(st);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
 
-	/* Read the whole user_writable_eeprom_size area from digital diagnostics
-	 * into sfp_data->user_writable_eeprom */
-	ret = tcv->read(tcv->index, DD_DEVICE_ADDRESS, USER_WRITABLE_EEPROM_OFFSET,
-			sfp_data->user_writable_eeprom,
-			sizeof(sfp_data->user_writable_eeprom));
+/******************************************************************************/
 
-	if (ret < 0)
-		return NULL;
+int sfp_get_10g_compliance_codes(tcv_t *tcv, tcv_10g_eth_compliance_codes_t *codes)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
 
-	return sfp_data->user_writable_eeprom;
+	if (tcv == NULL || codes == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_10g_compliance_codes(st, codes);
+	tcv_static_release(tcv, slot);
+	return ret;
 }
 
 /******************************************************************************/
 
-/**
- * \brief	Inform the size of user writable eeprom area of page a2
- * \param	tcv Pointer to transceiver structure
- * \return	size of writable eeprom area of page a2
- */
-static size_t sfp_get_user_writable_eeprom_size(tcv_t *tcv)
+int sfp_get_infiniband_compliance_codes(tcv_t *tcv, tcv_infiniband_compliance_codes_t *codes)
 {
-	sfp_data_t *sfp_data;
-
-	if (tcv == NULL || tcv->data == NULL)
-		return 0;
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
 
-	sfp_data = (sfp_data_t *) tcv->data;
+	if (tcv == NULL || codes == NULL)
+		return TCV_ERR_INVALID_ARG;
 
-	return sizeof(sfp_data->user_writable_eeprom);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_infiniband_compliance_codes(st, codes);
+	tcv_static_release(tcv, slot);
+	return ret;
 }
 
 /******************************************************************************/
 
-static const uint8_t* sfp_get_8079_rom(tcv_t *tcv)
+int sfp_get_escon_compliance_codes(tcv_t *tcv, tcv_escon_compliance_codes_t *codes)
 {
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
 
-	const size_t SFF_8079_ROM_OFFSET = 128;
-
-	if (tcv == NULL || tcv->data == NULL)
-		return NULL;
+	if (tcv == NULL || codes == NULL)
+		return TCV_ERR_INVALID_ARG;
 
-	return &((sfp_data_t*) tcv->data)->a0[SFF_8079_ROM_OFFSET];
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_escon_compliance_codes(st, codes);
+	tcv_static_release(tcv, slot);
+	return ret;
 }
 
 /******************************************************************************/
-static int sfp_read(tcv_t* tcv, uint8_t devaddr, uint8_t regaddr, uint8_t* data, size_t len)
+
+int sfp_get_sonet_compliance_codes(tcv_t *tcv, tcv_sonet_compliance_codes_t *codes)
 {
-	const size_t EEPROM_SIZE = 256;
-	size_t nbytes = (regaddr+len > EEPROM_SIZE) ? EEPROM_SIZE-regaddr : len;
-	return tcv->read(tcv->index, devaddr, regaddr, data, nbytes);
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL || codes == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_sonet_compliance_codes(st, codes);
+	tcv_static_release(tcv, slot);
+	return ret;
 }
 
 /******************************************************************************/
-static int sfp_write(tcv_t* tcv, uint8_t devaddr, uint8_t regaddr, const uint8_t* data, size_t len)
+
+int sfp_get_sonet_compliances(tcv_t *tcv, tcv_sonet_compliances_t *compliances)
 {
-	const size_t EEPROM_SIZE = 256;
-	size_t nbytes = (regaddr+len > EEPROM_SIZE) ? EEPROM_SIZE-regaddr : len;
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
 
-	/* Do not write in MSA specified EEPROM registers of device AC (standardized registers) */
-	if (devaddr == EEPROM_DEVICE_ADDR && regaddr < BASIC_INFO_REG_VENDORS_SPECIFIC)
+	if (tcv == NULL || compliances == NULL)
 		return TCV_ERR_INVALID_ARG;
 
-	return tcv->write(tcv->index, devaddr, regaddr, data, nbytes);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_sonet_compliances(st, compliances);
+	tcv_static_release(tcv, slot);
+	return ret;
 }
 
-
 /******************************************************************************/
 
-/**
- * \brief Check SFF-8472 compliant Digital Diagnostics type
- * \param tcv transceiver handle
- * \return type of diagnostics
- */
-static en_calibration_type sfp_dd_type(tcv_t* tcv){
-	tcv_diagnostic_type_t diag;
-	/* Check if DD available */
-	if (sfp_get_diagnostic_type(tcv, &diag) != 0)
-		return DD_UNAVAILABLE;
-
-	if (diag.bits.dd_implemented == 0)
-		return DD_UNAVAILABLE;
-
-	/* Get values - internally calibrated  */
-	if (diag.bits.internally_calibrated)
-		return DD_CALIB_INTERNAL;
+int sfp_get_eth_compliance_codes(tcv_t *tcv, tcv_eth_compliance_codes_t *codes)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
 
-	/* Get values - extenally calibrated  */
-	if (diag.bits.externally_calibrated)
-		return DD_CALIB_EXTERNAL;
+	if (tcv == NULL || codes == NULL)
+		return TCV_ERR_INVALID_ARG;
 
-	return DD_CALIB_UNKNOWN;
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_eth_compliance_codes(st, codes);
+	tcv_static_release(tcv, slot);
+	return ret;
 }
 
 /******************************************************************************/
 
-
-/**
- * \brief Convert array of 2 bytes to signed integer according to SFF-8472 Table 3.13
- * \param scratch byte[0]=MSB w/sign bit
- * \return signed int
- */
-static int16_t char2_to_short(uint8_t scratch[2])
+int sfp_get_fibre_channel_link_length(tcv_t *tcv, tcv_fibre_channel_link_length_t *lengths)
 {
-	int16_t val = (scratch[0] << 8) + scratch[1];
-	return val;
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL || lengths == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_fibre_channel_link_length(st, lengths);
+	tcv_static_release(tcv, slot);
+	return ret;
 }
 
 /******************************************************************************/
 
+int sfp_get_fibre_channel_technology(tcv_t *tcv, tcv_fibre_channel_technology_t *technology)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
 
-/**
- * \brief Get  externally calibrated temperature
- *
- * 		result = slope*val/256 + offset
- * @param tcv 	transceiver
- * @param temp  (out) signed 16-bit integer representing a 8.8 fixedpoint
- * @return status 0 success (TCV_ERR_GENERIC) in case of ERROR
- */
-static int get_temp_calib_f8(tcv_t* tcv, int16_t* temp){
-
-	uint8_t scratch[2];
-	int ad_val;
-	int slope;
-	int offset;
+	if (tcv == NULL || technology == NULL)
+		return TCV_ERR_INVALID_ARG;
 
-	if (tcv->read(tcv->index, DD_DEVICE_ADDRESS, DD_TEMP_SLOPE_REG, scratch, sizeof(scratch)) < 0)
-		return TCV_ERR_GENERIC;
-	slope = char2_to_short(scratch);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_fibre_channel_technology(st, technology);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
 
-	if (tcv->read(tcv->index, DD_DEVICE_ADDRESS, DD_TEMP_OFFSET_REG, scratch, sizeof(scratch)) < 0)
-		return TCV_ERR_GENERIC;
-	offset=char2_to_short(scratch);
+/******************************************************************************/
 
-	if (tcv->read(tcv->index, DD_DEVICE_ADDRESS, DD_TEMP_AD_REG, scratch, sizeof(scratch)) < 0)
-		return TCV_ERR_GENERIC;
+int sfp_get_sfp_plus_cable_technology(tcv_t *tcv, sfp_plus_cable_technology_t *technology)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
 
-	ad_val = char2_to_short(scratch);
+	if (tcv == NULL || technology == NULL)
+		return TCV_ERR_INVALID_ARG;
 
-	*temp = ((ad_val * slope)>>8)+offset;
-	return 0;
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_sfp_plus_cable_technology(st, technology);
+	tcv_static_release(tcv, slot);
+	return ret;
 }
 
 /******************************************************************************/
 
+int sfp_get_fibre_channel_media(tcv_t *tcv, tcv_fibre_channel_media_t *media)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
 
-/**
- * \brief Direct access to Analogue/Digital converter value as unsigned short
- *
- * Used for VCC, TX-Power, TX-Bias in internally calibrated transceivers.
- * \param tcv 	transceiver
- * \param val_addr offset for digital diagnostics value
- * \param val (out) value read 16-bit integer
- * \return 0 for success, error code < 0 otherwise
- */
-static int get_short_ad_val(tcv_t* tcv, uint8_t val_addr, int16_t* val){
-	uint8_t scratch[2];
-
-	if (tcv->read(tcv->index, DD_DEVICE_ADDRESS, val_addr, scratch, sizeof(scratch)) < 0)
-		return TCV_ERR_GENERIC;
+	if (tcv == NULL || media == NULL)
+		return TCV_ERR_INVALID_ARG;
 
-	*val =  char2_to_short(scratch);
-	return 0;
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_fibre_channel_media(st, media);
+	tcv_static_release(tcv, slot);
+	return ret;
 }
 
 /******************************************************************************/
 
-
-/**
- * \brief Calculate a digital diagnostics value as unsigned short integer
- *
- * 		result = slope*val/256 + offset
- * \param tcv 	transceiver
- * \param offset_addr register address for offset
- * \param slope_addr  register address for gain
- * \param val_addr    register address for measurement
- * \param val - (out) processed value
- * \return 0 for success or error_code < 0
- */
-static int get_polynomial_value(tcv_t* tcv, uint8_t offset_addr, uint8_t slope_addr, uint8_t val_addr, int16_t* val)
+int sfp_get_fibre_channel_speed(tcv_t *tcv, fibre_channel_speed_t *speed)
 {
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
 
-	uint8_t scratch[2];
-	int ad_val;
-	int slope;
-	int16_t offset;
+	if (tcv == NULL || speed == NULL)
+		return TCV_ERR_INVALID_ARG;
 
-	if (tcv->read(tcv->index, DD_DEVICE_ADDRESS, slope_addr, scratch, sizeof(scratch)) < 0)
-		return TCV_ERR_GENERIC;
-	slope = char2_to_short(scratch);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_fibre_channel_speed(st, speed);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
 
-	if (tcv->read(tcv->index, DD_DEVICE_ADDRESS, offset_addr, scratch, sizeof(scratch)) < 0)
-		return TCV_ERR_GENERIC;
-	offset = char2_to_short(scratch);
+/******************************************************************************/
 
-	if (tcv->read(tcv->index, DD_DEVICE_ADDRESS, val_addr, scratch, sizeof(scratch)) < 0)
-		return TCV_ERR_GENERIC;
+int sfp_get_encoding(tcv_t *tcv)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
 
-	ad_val = char2_to_short(scratch);
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
 
-	/* slope is 8.8 fixed point --> divide by 256 */
-	*val =  (int16_t)((ad_val * slope)/256 + offset);
-	return 0;
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_encoding(st);
+	tcv_static_release(tcv, slot);
+	return ret;
 }
 
-
 /******************************************************************************/
 
-/**
- * \brief Access and process digital diagnostics
- *
- * \param tcv transceiver handle
- * \param offset_addr - register offset for absolute value correction
- * \param slope_addr - register offset for calibration factor
- * \param val_addr -  register offset for ad value
- * \param val - (out) processed value
- * \return 0 for success or error_code < 0
- */
-static int get_dd_value(tcv_t* tcv, uint8_t offset_addr, uint8_t slope_addr, uint8_t val_addr, int16_t* val)
+int sfp_get_nominal_bit_rate(tcv_t *tcv)
 {
-	tcv_diagnostic_type_t diag;
-	en_calibration_type calib;
-	int ret = TCV_ERR_GENERIC;
-
-	if (sfp_get_diagnostic_type(tcv, &diag) != 0)
-		return TCV_ERR_GENERIC;
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
 
-	calib = sfp_dd_type(tcv);
-	switch (calib) {
-		case DD_UNAVAILABLE:
-			ret = TCV_ERR_DIAGNOSTICS_INFO_NOT_PRESENT;
-			break;
-		case DD_CALIB_INTERNAL:
-			/* Get values - internally calibrated  */
-			ret = get_short_ad_val(tcv, val_addr, val);
-			break;
-		case DD_CALIB_EXTERNAL:
-			/* Get values - extenally calibrated  */
-			ret = get_polynomial_value(tcv, offset_addr, slope_addr, val_addr, val);
-			break;
-		default:
-			/* Neither internally nor externally calibrated */
-			ret = TCV_ERR_GENERIC;
-	}
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
 
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_nominal_bit_rate(st);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
-
 /******************************************************************************/
 
-/**
- * \brief Read temperature of transceiver
- * \param tcv transceiver handle
- * \param temp (out) 8.8 Fixed point signed temperature value
+int sfp_get_rate_identifier(tcv_t *tcv)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_rate_identifier(st);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_sm_length(tcv_t *tcv)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_sm_length(st);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_om2_length(tcv_t *tcv)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_om2_length(st);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_om1_length(tcv_t *tcv)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_om1_length(st);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_om4_length_copper_length(tcv_t *tcv)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_om4_length_copper_length(st);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_om3_length(tcv_t *tcv)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_om3_length(st);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_vendor_name(tcv_t *tcv, char vendor_name[BASIC_INFO_REG_VENDOR_NAME_SIZE + 1])
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL || vendor_name == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_vendor_name(st, vendor_name);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_vendor_oui(tcv_t *tcv)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_vendor_oui(st);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_vendor_part_number(tcv_t *tcv, char pn[BASIC_INFO_REG_VENDOR_PN_SIZE + 1])
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL || pn == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_vendor_part_number(st, pn);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_vendor_revision(tcv_t *tcv, char rev[BASIC_INFO_REG_VENDOR_REV_SIZE + 1])
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL || rev == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_vendor_revision(st, rev);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_wavelength(tcv_t *tcv)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_wavelength(st);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_passive_cable_compliance(tcv_t *tcv, passive_cable_compliance_t *compliance)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL || compliance == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_passive_cable_compliance(st, compliance);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_active_cable_compliance(tcv_t *tcv, active_cable_compliance_t *compliance)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL || compliance == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_active_cable_compliance(st, compliance);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_cc_base(tcv_t *tcv)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_cc_base(st);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_calculate_cc_base(tcv_t *tcv)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_calculate_cc_base(st);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_implemented_options(tcv_t *tcv, tcv_implemented_options_t *options)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL || options == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_implemented_options(st, options);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_max_bit_rate(tcv_t *tcv)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_max_bit_rate(st);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_min_bit_rate(tcv_t *tcv)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_min_bit_rate(st);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_vendor_sn(tcv_t *tcv, char vendor_sn[TCV_VENDOR_SN_SIZE + 1])
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL || vendor_sn == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_vendor_sn(st, vendor_sn);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_vendor_date_code(tcv_t *tcv, tcv_date_code_t *date_code)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL || date_code == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_vendor_date_code(st, date_code);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_diagnostic_type(tcv_t *tcv, tcv_diagnostic_type_t *diag_type)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL || diag_type == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_diagnostic_type(st, diag_type);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_enhance_options(tcv_t *tcv, tcv_enhanced_options_type_t *options)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL || options == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_enhance_options(st, options);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_get_cc_ext(tcv_t *tcv)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_get_cc_ext(st);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+int sfp_calculate_cc_ext(tcv_t *tcv)
+{
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_INVALID_ARG;
+
+	if (tcv == NULL)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st && st->fun == &sfp_funcs)
+		ret = sfp_static_calculate_cc_ext(st);
+	tcv_static_release(tcv, slot);
+	return ret;
+}
+
+/******************************************************************************/
+
+const uint8_t* sfp_get_vendor_rom(tcv_t *tcv)
+{
+	const size_t VENDOR_ROM_OFFSET = 96;
+
+	if (tcv == NULL || tcv->data == NULL)
+		return NULL;
+
+	if (sfp_load_a0(tcv, tcv->data, VENDOR_ROM_OFFSET + 32) < 0)
+		return NULL;
+
+	return sfp_a0_field(&((sfp_data_t *) tcv->data)->st->hdr, VENDOR_ROM_OFFSET);
+}
+
+/******************************************************************************/
+
+static size_t sfp_get_vendor_rom_size(tcv_t *tcv)
+{
+	if (tcv == NULL || tcv->data == NULL)
+		return 0;
+
+	return 32;
+}
+
+/******************************************************************************/
+
+const uint8_t* sfp_get_user_writable_eeprom(tcv_t *tcv)
+{
+	int ret;
+	sfp_data_t *sfp_data;
+
+	if (tcv == NULL || tcv->data == NULL)
+		return 0;
+
+	sfp_data = (sfp_data_t *) tcv->data;
+	if (sfp_data->user_eeprom_valid)
+		return sfp_data->user_writable_eeprom;
+
+	/* Read the whole user_writable_eeprom_size area from digital diagnostics
+	 * into sfp_data->user_writable_eeprom, sfp_write() keeps it up to date */
+	ret = tcv_xfer_read(tcv, DD_DEVICE_ADDRESS, USER_EEPROM_REG,
+			sfp_data->user_writable_eeprom,
+			sizeof(sfp_data->user_writable_eeprom));
+
+	if (ret < 0)
+		return NULL;
+
+	sfp_data->user_eeprom_valid = true;
+	return sfp_data->user_writable_eeprom;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief	Inform the size of user writable eeprom area of page a2
+ * \param	tcv Pointer to transceiver structure
+ * \return	size of writable eeprom area of page a2
+ */
+static size_t sfp_get_user_writable_eeprom_size(tcv_t *tcv)
+{
+	sfp_data_t *sfp_data;
+
+	if (tcv == NULL || tcv->data == NULL)
+		return 0;
+
+	sfp_data = (sfp_data_t *) tcv->data;
+
+	return sizeof(sfp_data->user_writable_eeprom);
+}
+
+/******************************************************************************/
+
+static const uint8_t* sfp_get_8079_rom(tcv_t *tcv)
+{
+
+	const size_t SFF_8079_ROM_OFFSET = 128;
+
+	if (tcv == NULL || tcv->data == NULL)
+		return NULL;
+
+	if (sfp_load_a0(tcv, tcv->data, SFP_A0_SIZE) < 0)
+		return NULL;
+
+	return sfp_a0_field(&((sfp_data_t *) tcv->data)->st->hdr,
+	                    SFF_8079_ROM_OFFSET);
+}
+
+/******************************************************************************/
+static int sfp_read(tcv_t* tcv, uint8_t devaddr, uint8_t regaddr, uint8_t* data, size_t len)
+{
+	const size_t EEPROM_SIZE = 256;
+	size_t nbytes = (regaddr+len > EEPROM_SIZE) ? EEPROM_SIZE-regaddr : len;
+	return tcv_xfer_read(tcv, devaddr, regaddr, data, nbytes);
+}
+
+/******************************************************************************/
+/**
+ * \brief Record a change of the A2h page select register
+ * \param sfp_data sfp data of the handle
+ * \param page selected page, -1 if unknown
+ */
+static void sfp_page_changed(sfp_data_t *sfp_data, int page)
+{
+	sfp_data->dd_page = page;
+	/* the user EEPROM copy was read through the previous page */
+	sfp_data->user_eeprom_valid = false;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Write through to the user EEPROM copy
+ * \param sfp_data sfp data of the handle
+ * \param regaddr first A2h register written
+ * \param data data written
+ * \param len number of bytes
+ * \param status result of the write, the copy is dropped on error
+ */
+static void sfp_user_eeprom_written(sfp_data_t *sfp_data, uint8_t regaddr,
+                                    const uint8_t *data, size_t len, int status)
+{
+	size_t begin, end;
+
+	if (!sfp_data->user_eeprom_valid ||
+	    regaddr >= USER_EEPROM_REG + sizeof(sfp_data->user_writable_eeprom) ||
+	    regaddr + len <= USER_EEPROM_REG)
+		return;
+
+	/* unknown how much the module took */
+	if (status < 0) {
+		sfp_data->user_eeprom_valid = false;
+		return;
+	}
+
+	begin = regaddr > USER_EEPROM_REG ? regaddr : USER_EEPROM_REG;
+	end = regaddr + len;
+	if (end > USER_EEPROM_REG + sizeof(sfp_data->user_writable_eeprom))
+		end = USER_EEPROM_REG + sizeof(sfp_data->user_writable_eeprom);
+
+	memcpy(&sfp_data->user_writable_eeprom[begin - USER_EEPROM_REG],
+	       &data[begin - regaddr], end - begin);
+}
+
+/******************************************************************************/
+static int sfp_write(tcv_t* tcv, uint8_t devaddr, uint8_t regaddr, const uint8_t* data, size_t len)
+{
+	const size_t EEPROM_SIZE = 256;
+	size_t nbytes = (regaddr+len > EEPROM_SIZE) ? EEPROM_SIZE-regaddr : len;
+	int ret;
+
+	/* Do not write in MSA specified EEPROM registers of device AC (standardized registers) */
+	if (devaddr == EEPROM_DEVICE_ADDR && regaddr < BASIC_INFO_REG_VENDORS_SPECIFIC)
+		return TCV_ERR_INVALID_ARG;
+
+	/* Measured values may change with control writes */
+	if (devaddr == DD_DEVICE_ADDRESS) {
+		((sfp_data_t *) tcv->data)->dd_cache_valid = false;
+		ra_close(tcv->data);
+	}
+
+	/* Stored image would no longer match the vendor specific bytes */
+	if (devaddr == EEPROM_DEVICE_ADDR)
+		tcv_eeprom_cache_drop(tcv);
+
+	/* Page selected behind our back */
+	if (devaddr == DD_DEVICE_ADDRESS && regaddr <= DD_PAGE_SELECT_REG &&
+	    regaddr + nbytes > DD_PAGE_SELECT_REG)
+		sfp_page_changed(tcv->data, -1);
+
+	ret = tcv_xfer_write_eeprom(tcv, devaddr, regaddr, data, nbytes);
+	if (devaddr == DD_DEVICE_ADDRESS)
+		sfp_user_eeprom_written(tcv->data, regaddr, data, nbytes, ret);
+
+	return ret;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Make sure A2h bytes 128-255 show the given page
+ * \param tcv transceiver handle
+ * \param page page to select
+ * \return 0 for success, error code < 0 otherwise
+ */
+static int sfp_select_page(tcv_t* tcv, uint8_t page)
+{
+	sfp_data_t *sfp_data = (sfp_data_t *) tcv->data;
+	int ret;
+
+	if (sfp_data->dd_page == page)
+		return 0;
+
+	ret = tcv_xfer_write(tcv, DD_DEVICE_ADDRESS, DD_PAGE_SELECT_REG, &page, 1);
+	if (ret < 0) {
+		/* unknown whether the module took it */
+		sfp_page_changed(sfp_data, -1);
+		return ret;
+	}
+
+	sfp_page_changed(sfp_data, page);
+	return 0;
+}
+
+/******************************************************************************/
+static int sfp_read_paged(tcv_t* tcv, uint8_t page, uint8_t regaddr, uint8_t* data, size_t len)
+{
+	int ret;
+
+	if (regaddr + len > 256)
+		return TCV_ERR_INVALID_ARG;
+
+	/* Lower half is not paged */
+	if (regaddr + len > DD_PAGE_SELECT_REG + 1) {
+		ret = sfp_select_page(tcv, page);
+		if (ret < 0)
+			return ret;
+	}
+
+	ret = tcv_xfer_read(tcv, DD_DEVICE_ADDRESS, regaddr, data, len);
+	if (ret < 0)
+		sfp_page_changed(tcv->data, -1);
+
+	return ret;
+}
+
+/******************************************************************************/
+static int sfp_write_paged(tcv_t* tcv, uint8_t page, uint8_t regaddr, const uint8_t* data, size_t len)
+{
+	int ret;
+
+	if (regaddr + len > 256)
+		return TCV_ERR_INVALID_ARG;
+
+	/* The select register belongs to the paging itself */
+	if (regaddr <= DD_PAGE_SELECT_REG && regaddr + len > DD_PAGE_SELECT_REG)
+		return TCV_ERR_INVALID_ARG;
+
+	if (regaddr > DD_PAGE_SELECT_REG) {
+		ret = sfp_select_page(tcv, page);
+		if (ret < 0)
+			return ret;
+	}
+
+	/* written through some page, not necessarily the user EEPROM's */
+	if (regaddr + len > USER_EEPROM_REG)
+		((sfp_data_t *) tcv->data)->user_eeprom_valid = false;
+
+	ret = tcv_xfer_write_eeprom(tcv, DD_DEVICE_ADDRESS, regaddr, data, len);
+	if (ret < 0)
+		sfp_page_changed(tcv->data, -1);
+
+	return ret;
+}
+
+
+/******************************************************************************/
+
+/**
+ * \brief Check SFF-8472 compliant Digital Diagnostics type
+ * \param tcv transceiver handle
+ * \return type of diagnostics
+ */
+static en_calibration_type sfp_dd_type(tcv_t* tcv){
+	tcv_diagnostic_type_t diag;
+	/* Check if DD available */
+	if (sfp_static_get_diagnostic_type(&((sfp_data_t *) tcv->data)->st->hdr,
+	                                   &diag) != 0)
+		return DD_UNAVAILABLE;
+
+	if (diag.bits.dd_implemented == 0)
+		return DD_UNAVAILABLE;
+
+	/* Get values - internally calibrated  */
+	if (diag.bits.internally_calibrated)
+		return DD_CALIB_INTERNAL;
+
+	/* Get values - extenally calibrated  */
+	if (diag.bits.externally_calibrated)
+		return DD_CALIB_EXTERNAL;
+
+	return DD_CALIB_UNKNOWN;
+}
+
+/******************************************************************************/
+
+
+/**
+ * \brief Convert array of 2 bytes to signed integer according to SFF-8472 Table 3.13
+ * \param scratch byte[0]=MSB w/sign bit
+ * \return signed int
+ */
+static int16_t char2_to_short(const uint8_t scratch[2])
+{
+	int16_t val = (scratch[0] << 8) + scratch[1];
+	return val;
+}
+
+/******************************************************************************/
+
+/**
+ *  \brief Converts to a float from a big-endian 4-byte source buffer.
+ *  	   taken from ethtool
+ *  \param source bytes form digital diagnostic (MSA defines BE)
+ *  \return IEE754 float
+ */
+static float befloattoh(const uint32_t source)
+{
+	union {
+		uint32_t src;
+		float dst;
+	} converter;
+
+	converter.src = ntohl(source);
+	return converter.dst;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Read and parse the external calibration constants (A2h 56-95)
+ *
+ * The constants are static, they are cached in sfp_data_t as host-endian
+ * values so every externally calibrated reading is a single A/D read.
+ * \param tcv transceiver handle
+ * \return 0 for success, error code < 0 otherwise
+ */
+static int sfp_load_calibration(tcv_t* tcv)
+{
+	sfp_data_t *sfp_data = (sfp_data_t *) tcv->data;
+	uint8_t cal[DD_CAL_SIZE];
+	uint32_t factor;
+	int i;
+
+	sfp_data->calib_loaded = false;
+
+	if (tcv_xfer_read(tcv, DD_DEVICE_ADDRESS, DD_CAL_REG, cal, sizeof(cal)) < 0)
+		return TCV_ERR_GENERIC;
+
+	/* Rx_PWR(4) is stored first, at DD_RX_PWR_CAL */
+	for (i = 0; i < 5; i++) {
+		memcpy(&factor, &cal[DD_RX_PWR_CAL - DD_CAL_REG + (4 - i) * 4], sizeof(factor));
+		sfp_data->rx_pwr_calib[i] = befloattoh(factor);
+	}
+
+	/* slope/offset pairs follow from DD_TX_CUR_SLOPE_REG on */
+	for (i = 0; i < DD_LINEAR_COUNT; i++) {
+		const uint8_t *pair = &cal[DD_TX_CUR_SLOPE_REG - DD_CAL_REG + i * 4];
+		sfp_data->linear_calib[i].slope = char2_to_short(&pair[0]);
+		sfp_data->linear_calib[i].offset = char2_to_short(&pair[2]);
+	}
+
+	sfp_data->calib_loaded = true;
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Make sure the external calibration constants are cached
+ * \param tcv transceiver handle
+ * \return 0 for success, error code < 0 otherwise
+ */
+static int sfp_calibration_ok(tcv_t* tcv)
+{
+	if (((sfp_data_t *) tcv->data)->calib_loaded)
+		return 0;
+
+	return sfp_load_calibration(tcv);
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Check if the module is still the one read at sfp_init()
+ * \param tcv transceiver handle
+ * \return 0 if unchanged, 1 if it has to be initialized again, error code < 0
+ *         otherwise
+ */
+static int sfp_revalidate(tcv_t *tcv)
+{
+	uint8_t a0[SFP_A0_SIZE];
+	int ret;
+
+	sfp_a0_compose(((sfp_data_t *) tcv->data)->st, a0);
+	ret = sfp_a0_matches(tcv, a0, true);
+	if (ret < 0)
+		return ret;
+
+	/* The stored image is the old module's as well */
+	if (!ret)
+		tcv_eeprom_cache_drop(tcv);
+
+	return !ret;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Re-read constants cached at sfp_init()
+ * \param tcv transceiver handle
+ * \return 0 for success, error code < 0 otherwise
+ */
+static int sfp_refresh(tcv_t* tcv)
+{
+	((sfp_data_t *) tcv->data)->dd_cache_valid = false;
+	((sfp_data_t *) tcv->data)->user_eeprom_valid = false;
+	ra_close(tcv->data);
+
+	if (((sfp_data_t *) tcv->data)->dd != sfp_dd_ops_for(DD_CALIB_EXTERNAL))
+		return 0;
+
+	return sfp_load_calibration(tcv);
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Externally calibrated temperature from its A/D value
+ *
+ * 		result = slope*val/256 + offset
+ * \param sfp_data sfp with cached calibration
+ * \param ad_val temperature A/D value
+ * \return signed 16-bit integer representing a 8.8 fixedpoint
+ */
+static int16_t calc_temp_calib_f8(const sfp_data_t *sfp_data, int ad_val)
+{
+	const sfp_linear_calib_t *cal = &sfp_data->linear_calib[DD_LINEAR_TEMP];
+
+	return ((ad_val * cal->slope)>>8) + cal->offset;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Apply slope/offset calibration on an A/D value
+ *
+ * 		result = slope*val/256 + offset
+ * \param sfp_data sfp with cached calibration
+ * \param quantity one of DD_LINEAR_*
+ * \param ad_val A/D value
+ * \return processed value
+ */
+static int16_t calc_polynomial_value(const sfp_data_t *sfp_data, int quantity, int ad_val)
+{
+	const sfp_linear_calib_t *cal = &sfp_data->linear_calib[quantity];
+
+	/* slope is 8.8 fixed point --> divide by 256 */
+	return (int16_t)((ad_val * cal->slope)/256 + cal->offset);
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Evaluate the externally calibrated RX power polynomial
+ * \param sfp_data sfp with cached calibration
+ * \param rxpwr A/D value in host order
+ * \return RX power (0.1 uW)
+ */
+static uint16_t calc_rx_pwr_external(const sfp_data_t *sfp_data, uint16_t rxpwr)
+{
+	/* really, in the standard its a float! */
+	float pwrs[5];
+	float val = 0;
+	int i;
+
+	pwrs[0] = 1.0f;  //rxpwr^0
+	pwrs[1] = rxpwr; //rxpwr^1
+	pwrs[2] = pwrs[1] * rxpwr; //rxpwr^2
+	pwrs[3] = pwrs[2] * rxpwr; //rxpwr^3
+	pwrs[4] = pwrs[3] * rxpwr; //rxpwr^4
+
+	for (i = 0; i < 5; i++)
+		val += sfp_data->rx_pwr_calib[i] * pwrs[i]; // multiply accumulate
+
+	/* adjust to 16-Bit representation */
+	return (uint16_t) val;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Keep bytes 96-105 for the getters if the cache is enabled
+ * \param tcv transceiver handle
+ * \param raw DD_VALUES_SIZE bytes read from DD_VALUES_REG
+ * \param when time of the read
+ */
+static void dd_cache_store(tcv_t *tcv, const uint8_t *raw, uint64_t when)
+{
+	sfp_data_t *sfp_data = (sfp_data_t *) tcv->data;
+
+	if (!tcv->dd_max_age_ns)
+		return;
+
+	memcpy(sfp_data->dd_cache, raw, DD_VALUES_SIZE);
+	sfp_data->dd_cache_time = when;
+	sfp_data->dd_cache_valid = true;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Measured values 96-105, from the cache while younger than the
+ *        configured maximum age, from the module otherwise
+ * \param tcv transceiver handle
+ * \param raw (out) DD_VALUES_SIZE bytes
+ * \param when (out) time of the read, may be NULL
+ * \return 0 for success, error code < 0 otherwise
+ */
+static int read_dd_values(tcv_t *tcv, uint8_t *raw, uint64_t *when)
+{
+	sfp_data_t *sfp_data = (sfp_data_t *) tcv->data;
+	uint64_t now = tcv_clock_ns();
+
+	if (tcv->dd_max_age_ns) {
+		if (sfp_data->dd_cache_valid &&
+		    now - sfp_data->dd_cache_time <= tcv->dd_max_age_ns) {
+			tcv_state_wrlock(tcv);
+			sfp_data->dd_cache_stats.hits++;
+			tcv_state_unlock(tcv);
+			memcpy(raw, sfp_data->dd_cache, DD_VALUES_SIZE);
+			if (when)
+				*when = sfp_data->dd_cache_time;
+			return 0;
+		}
+		tcv_state_wrlock(tcv);
+		sfp_data->dd_cache_stats.misses++;
+		tcv_state_unlock(tcv);
+	}
+
+	if (tcv_xfer_read(tcv, DD_DEVICE_ADDRESS, DD_VALUES_REG, raw, DD_VALUES_SIZE) < 0)
+		return TCV_ERR_GENERIC;
+
+	now = tcv_clock_ns();
+	dd_cache_store(tcv, raw, now);
+	if (when)
+		*when = now;
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Close the open read-ahead window, its words requested go into the
+ *        demand average
+ * \param sfp_data sfp
+ */
+static void ra_close(sfp_data_t *sfp_data)
+{
+	unsigned int bytes = 0;
+	uint16_t used;
+
+	if (!sfp_data->ra_open)
+		return;
+
+	for (used = sfp_data->ra_used; used; used &= used - 1)
+		bytes++;
+
+	sfp_data->ra_demand = (3 * sfp_data->ra_demand + 16 * ((bytes + 1) / 2)) / 4;
+	sfp_data->ra_open = false;
+	sfp_data->ra_filled = false;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Decide whether a new window reads the region or the word only
+ *
+ * The region is read when it costs less than the word reads it replaces.
+ * Costs not measured yet are derived from the other one, or from
+ * DD_AHEAD_XFER_BYTES if neither is known.
+ * \param tcv transceiver handle
+ * \param sfp_data sfp
+ * \return true to read the region
+ */
+static bool ra_decide(tcv_t *tcv, sfp_data_t *sfp_data)
+{
+	const uint64_t word_bytes = DD_AHEAD_XFER_BYTES + 2;
+	const uint64_t region_bytes = DD_AHEAD_XFER_BYTES + DD_AHEAD_SIZE;
+	uint64_t word = sfp_data->ra_cost[0];
+	uint64_t region = sfp_data->ra_cost[1];
+	bool fill;
+
+	if (tcv->read_ahead == TCV_READ_AHEAD_ON)
+		return true;
+
+	if (!word && !region) {
+		word = word_bytes;
+		region = region_bytes;
+	} else if (!word) {
+		word = region * word_bytes / region_bytes;
+	} else if (!region) {
+		region = word * region_bytes / word_bytes;
+	}
+
+	/* ra_demand is in 1/16 words */
+	fill = region * 16 < sfp_data->ra_demand * word;
+
+	/* Measure the other choice as well, bus conditions change */
+	if (!sfp_data->ra_cost[!fill] ||
+	    sfp_data->ra_windows - sfp_data->ra_measured[!fill] >= DD_AHEAD_PROBE)
+		fill = !fill;
+
+	return fill;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Read one A/D value, with read-ahead of the status region if enabled
+ * \param tcv transceiver handle
+ * \param val_addr register address of the value
+ * \param scratch (out) raw value
  * \return 0 for success, error code < 0 otherwise
  */
-static int sfp_get_temp(tcv_t *tcv, int16_t* temp)
+static int read_ad_word(tcv_t *tcv, uint8_t val_addr, uint8_t scratch[2])
 {
-	int16_t val=0;
-	int err = 0;
+	sfp_data_t *sfp_data = (sfp_data_t *) tcv->data;
+	tcv_read_ahead_stats_t *stats = &sfp_data->ra_stats;
+	uint16_t mask;
+	uint64_t start, end;
+	bool fill;
+	int kind;
+
+	if (tcv->read_ahead == TCV_READ_AHEAD_OFF || val_addr < DD_AHEAD_REG ||
+	    val_addr + 2 > DD_AHEAD_REG + DD_AHEAD_SIZE) {
+		if (tcv_xfer_read(tcv, DD_DEVICE_ADDRESS, val_addr, scratch, 2) < 0)
+			return TCV_ERR_GENERIC;
+		return 0;
+	}
 
-	en_calibration_type calib;
+	mask = (uint16_t) (3u << (val_addr - DD_AHEAD_REG));
+	start = tcv_clock_ns();
+
+	if (sfp_data->ra_open && !(sfp_data->ra_used & mask) &&
+	    start - sfp_data->ra_start <= tcv->read_ahead_window_ns) {
+		sfp_data->ra_used |= mask;
+		if (sfp_data->ra_filled) {
+			memcpy(scratch, &sfp_data->ra_buf[val_addr - DD_AHEAD_REG], 2);
+			tcv_state_wrlock(tcv);
+			stats->hits++;
+			stats->bytes_saved += 2;
+			tcv_state_unlock(tcv);
+			return 0;
+		}
+		fill = false;
+	} else {
+		ra_close(sfp_data);
+		fill = ra_decide(tcv, sfp_data);
+		sfp_data->ra_open = true;
+		sfp_data->ra_start = start;
+		sfp_data->ra_used = mask;
+		sfp_data->ra_windows++;
+	}
 
-	calib = sfp_dd_type(tcv);
+	if (fill) {
+		if (tcv_xfer_read(tcv, DD_DEVICE_ADDRESS, DD_AHEAD_REG,
+		                  sfp_data->ra_buf, DD_AHEAD_SIZE) < 0) {
+			sfp_data->ra_open = false;
+			return TCV_ERR_GENERIC;
+		}
+		memcpy(scratch, &sfp_data->ra_buf[val_addr - DD_AHEAD_REG], 2);
+		sfp_data->ra_filled = true;
+	} else {
+		if (tcv_xfer_read(tcv, DD_DEVICE_ADDRESS, val_addr, scratch, 2) < 0)
+			return TCV_ERR_GENERIC;
+	}
+
+	end = tcv_clock_ns();
+	if (fill)
+		dd_cache_store(tcv, sfp_data->ra_buf, end);
+
+	/* counters and costs are read by tcv_get_read_ahead_stats() */
+	kind = fill ? 1 : 0;
+	tcv_state_wrlock(tcv);
+	if (fill) {
+		stats->fills++;
+		stats->bytes_read += DD_AHEAD_SIZE;
+	} else {
+		stats->word_reads++;
+		stats->bytes_read += 2;
+	}
+	sfp_data->ra_cost[kind] = sfp_data->ra_cost[kind] ?
+		(3 * sfp_data->ra_cost[kind] + (end - start)) / 4 : end - start;
+	if (!sfp_data->ra_cost[kind])
+		sfp_data->ra_cost[kind] = 1;
+	tcv_state_unlock(tcv);
+	sfp_data->ra_measured[kind] = sfp_data->ra_windows;
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Direct access to Analogue/Digital converter value as unsigned short
+ *
+ * Used for VCC, TX-Power, TX-Bias in internally calibrated transceivers.
+ * \param tcv 	transceiver
+ * \param val_addr offset for digital diagnostics value
+ * \param val (out) value read 16-bit integer
+ * \return 0 for success, error code < 0 otherwise
+ */
+static int get_short_ad_val(tcv_t* tcv, uint8_t val_addr, int16_t* val){
+	uint8_t scratch[2];
+	uint8_t values[DD_VALUES_SIZE];
+
+	/* With cache all values come from one block read */
+	if (tcv->dd_max_age_ns && val_addr >= DD_VALUES_REG &&
+	    val_addr + sizeof(scratch) <= DD_VALUES_REG + DD_VALUES_SIZE) {
+		if (read_dd_values(tcv, values, NULL) < 0)
+			return TCV_ERR_GENERIC;
+
+		*val = char2_to_short(&values[val_addr - DD_VALUES_REG]);
+		return 0;
+	}
+
+	if (read_ad_word(tcv, val_addr, scratch) < 0)
+		return TCV_ERR_GENERIC;
+
+	*val =  char2_to_short(scratch);
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Unpack the raw A/D values of bytes 96-105
+ * \param raw DD_VALUES_SIZE bytes read from DD_VALUES_REG
+ * \param when time of the read
+ * \param snapshot (out) uncalibrated values
+ */
+static void unpack_raw_snapshot(const uint8_t *raw, uint64_t when,
+                                tcv_dd_snapshot_t *snapshot)
+{
+	snapshot->timestamp = when;
+
+	snapshot->temp = char2_to_short(&raw[DD_TEMP_AD_REG - DD_VALUES_REG]);
+	snapshot->vcc = char2_to_short(&raw[DD_VCC_AD_REG - DD_VALUES_REG]);
+	snapshot->tx_cur = char2_to_short(&raw[DD_TX_CUR_AD_REG - DD_VALUES_REG]);
+	snapshot->tx_pwr = char2_to_short(&raw[DD_TX_PWR_AD_REG - DD_VALUES_REG]);
+	snapshot->rx_pwr = char2_to_short(&raw[DD_RX_PWR_AD_REG - DD_VALUES_REG]);
+}
+
+/******************************************************************************/
+/* Internally calibrated modules: A/D registers contain the values */
+
+static int dd_ready(tcv_t *tcv)
+{
+	return 0;
+}
+
+static int dd_internal_get_temp(tcv_t *tcv, int16_t *temp)
+{
+	return get_short_ad_val(tcv, DD_TEMP_AD_REG, temp);
+}
+
+static int dd_internal_get_value(tcv_t *tcv, int quantity, uint8_t val_addr, int16_t *val)
+{
+	return get_short_ad_val(tcv, val_addr, val);
+}
+
+static int dd_internal_get_rx_pwr(tcv_t *tcv, uint16_t *pwr)
+{
+	return get_short_ad_val(tcv, DD_RX_PWR_AD_REG, (int16_t*) pwr);
+}
+
+static const struct sfp_dd_ops dd_internal_ops = {
+	.get_temp = dd_internal_get_temp,
+	.get_value = dd_internal_get_value,
+	.get_rx_pwr = dd_internal_get_rx_pwr,
+	.prepare_snapshot = dd_ready,
+	.decode_snapshot = NULL,
+};
+
+/******************************************************************************/
+/* Externally calibrated modules: A/D value processed with cached constants */
+
+/**
+ * \brief Get  externally calibrated temperature
+ *
+ * 		result = slope*val/256 + offset
+ * @param tcv 	transceiver
+ * @param temp  (out) signed 16-bit integer representing a 8.8 fixedpoint
+ * @return status 0 success (TCV_ERR_GENERIC) in case of ERROR
+ */
+static int dd_external_get_temp(tcv_t *tcv, int16_t *temp)
+{
+	int16_t ad_val;
+
+	if (sfp_calibration_ok(tcv) < 0)
+		return TCV_ERR_GENERIC;
+
+	if (get_short_ad_val(tcv, DD_TEMP_AD_REG, &ad_val) < 0)
+		return TCV_ERR_GENERIC;
+
+	*temp = calc_temp_calib_f8((sfp_data_t *) tcv->data, ad_val);
+	return 0;
+}
+
+/**
+ * \brief Calculate a digital diagnostics value as unsigned short integer
+ *
+ * 		result = slope*val/256 + offset
+ * \param tcv 	transceiver
+ * \param quantity   one of DD_LINEAR_*, selects the cached slope and offset
+ * \param val_addr    register address for measurement
+ * \param val - (out) processed value
+ * \return 0 for success or error_code < 0
+ */
+static int dd_external_get_value(tcv_t *tcv, int quantity, uint8_t val_addr, int16_t *val)
+{
+	int16_t ad_val;
+
+	if (sfp_calibration_ok(tcv) < 0)
+		return TCV_ERR_GENERIC;
+
+	if (get_short_ad_val(tcv, val_addr, &ad_val) < 0)
+		return TCV_ERR_GENERIC;
+
+	*val = calc_polynomial_value((sfp_data_t *) tcv->data, quantity, ad_val);
+	return 0;
+}
+
+static int dd_external_get_rx_pwr(tcv_t *tcv, uint16_t *pwr)
+{
+	int16_t rxpwr;
+
+	if (sfp_calibration_ok(tcv) < 0)
+		return TCV_ERR_GENERIC;
+
+	if (get_short_ad_val(tcv, DD_RX_PWR_AD_REG, &rxpwr) < 0)
+		return TCV_ERR_GENERIC;
+
+	*pwr = calc_rx_pwr_external((sfp_data_t *) tcv->data, (uint16_t) rxpwr);
+	return 0;
+}
+
+static void dd_external_decode_snapshot(const sfp_data_t *sfp_data,
+                                        tcv_dd_snapshot_t *snapshot)
+{
+	snapshot->temp = calc_temp_calib_f8(sfp_data, snapshot->temp);
+	snapshot->vcc = calc_polynomial_value(sfp_data, DD_LINEAR_VCC, (int16_t) snapshot->vcc);
+	snapshot->tx_cur = calc_polynomial_value(sfp_data, DD_LINEAR_TX_CUR, (int16_t) snapshot->tx_cur);
+	snapshot->tx_pwr = calc_polynomial_value(sfp_data, DD_LINEAR_TX_PWR, (int16_t) snapshot->tx_pwr);
+	snapshot->rx_pwr = calc_rx_pwr_external(sfp_data, snapshot->rx_pwr);
+}
+
+static const struct sfp_dd_ops dd_external_ops = {
+	.get_temp = dd_external_get_temp,
+	.get_value = dd_external_get_value,
+	.get_rx_pwr = dd_external_get_rx_pwr,
+	.prepare_snapshot = sfp_calibration_ok,
+	.decode_snapshot = dd_external_decode_snapshot,
+};
+
+/******************************************************************************/
+/* No digital diagnostics, or neither internally nor externally calibrated */
+
+static int dd_none_get_temp(tcv_t *tcv, int16_t *temp)
+{
+	return TCV_ERR_DIAGNOSTICS_INFO_NOT_PRESENT;
+}
+
+static int dd_none_get_value(tcv_t *tcv, int quantity, uint8_t val_addr, int16_t *val)
+{
+	return TCV_ERR_DIAGNOSTICS_INFO_NOT_PRESENT;
+}
+
+static int dd_none_get_rx_pwr(tcv_t *tcv, uint16_t *pwr)
+{
+	return TCV_ERR_DIAGNOSTICS_INFO_NOT_PRESENT;
+}
 
+static int dd_none_prepare_snapshot(tcv_t *tcv)
+{
+	return TCV_ERR_DIAGNOSTICS_INFO_NOT_PRESENT;
+}
+
+static const struct sfp_dd_ops dd_none_ops = {
+	.get_temp = dd_none_get_temp,
+	.get_value = dd_none_get_value,
+	.get_rx_pwr = dd_none_get_rx_pwr,
+	.prepare_snapshot = dd_none_prepare_snapshot,
+	.decode_snapshot = NULL,
+};
+
+static int dd_unknown_get_temp(tcv_t *tcv, int16_t *temp)
+{
+	return TCV_ERR_GENERIC;
+}
+
+static int dd_unknown_get_value(tcv_t *tcv, int quantity, uint8_t val_addr, int16_t *val)
+{
+	return TCV_ERR_GENERIC;
+}
+
+static int dd_unknown_get_rx_pwr(tcv_t *tcv, uint16_t *pwr)
+{
+	return TCV_ERR_GENERIC;
+}
+
+static int dd_unknown_prepare_snapshot(tcv_t *tcv)
+{
+	return TCV_ERR_GENERIC;
+}
+
+static const struct sfp_dd_ops dd_unknown_ops = {
+	.get_temp = dd_unknown_get_temp,
+	.get_value = dd_unknown_get_value,
+	.get_rx_pwr = dd_unknown_get_rx_pwr,
+	.prepare_snapshot = dd_unknown_prepare_snapshot,
+	.decode_snapshot = NULL,
+};
+
+/******************************************************************************/
+
+/**
+ * \brief Select the digital diagnostics implementation matching the module
+ * \param calib calibration mode decoded from A0h byte 92
+ * \return dd operations
+ */
+static const struct sfp_dd_ops *sfp_dd_ops_for(en_calibration_type calib)
+{
 	switch (calib) {
 		case DD_UNAVAILABLE:
-			err = TCV_ERR_DIAGNOSTICS_INFO_NOT_PRESENT;
-			break;
+			return &dd_none_ops;
 		case DD_CALIB_INTERNAL:
-			err = get_short_ad_val(tcv, DD_TEMP_AD_REG, &val);
-			break;
+			return &dd_internal_ops;
 		case DD_CALIB_EXTERNAL:
-			err = get_temp_calib_f8(tcv, &val);
-			break;
+			return &dd_external_ops;
 		default:
-			err = TCV_ERR_GENERIC;
+			return &dd_unknown_ops;
 	}
-	if (err < 0)
-		return err;
+}
 
-	*temp = (int16_t) val;
-	return 0;
+/******************************************************************************/
+
+/**
+ * \brief Read temperature of transceiver
+ * \param tcv transceiver handle
+ * \param temp (out) 8.8 Fixed point signed temperature value
+ * \return 0 for success, error code < 0 otherwise
+ */
+static int sfp_get_temp(tcv_t *tcv, int16_t* temp)
+{
+	return ((sfp_data_t *) tcv->data)->dd->get_temp(tcv, temp);
 }
 
 /******************************************************************************/
@@ -1655,7 +3319,8 @@ static int sfp_get_temp(tcv_t *tcv, int16_t* temp)
  */
 static int sfp_get_voltage(tcv_t *tcv, uint16_t* vcc)
 {
-	return get_dd_value(tcv, DD_VCC_OFFSET_REG, DD_VCC_SLOPE_REG, DD_VCC_AD_REG, (int16_t*)vcc);
+	return ((sfp_data_t *) tcv->data)->dd->get_value(tcv, DD_LINEAR_VCC,
+	                                                 DD_VCC_AD_REG, (int16_t*) vcc);
 }
 /******************************************************************************/
 
@@ -1667,7 +3332,8 @@ static int sfp_get_voltage(tcv_t *tcv, uint16_t* vcc)
  */
 static int sfp_get_tx_pwr(tcv_t *tcv, uint16_t* pwr)
 {
-	return get_dd_value(tcv, DD_TX_PWR_OFFSET_REG, DD_TX_PWR_SLOPE_REG, DD_TX_PWR_AD_REG, (int16_t*)pwr);
+	return ((sfp_data_t *) tcv->data)->dd->get_value(tcv, DD_LINEAR_TX_PWR,
+	                                                 DD_TX_PWR_AD_REG, (int16_t*) pwr);
 }
 
 /******************************************************************************/
@@ -1680,85 +3346,148 @@ static int sfp_get_tx_pwr(tcv_t *tcv, uint16_t* pwr)
  */
 static int sfp_get_tx_cur(tcv_t *tcv, uint16_t* cur)
 {
-	return get_dd_value(tcv, DD_TX_CUR_OFFSET_REG, DD_TX_CUR_SLOPE_REG, DD_TX_CUR_AD_REG, (int16_t*) cur);
+	return ((sfp_data_t *) tcv->data)->dd->get_value(tcv, DD_LINEAR_TX_CUR,
+	                                                 DD_TX_CUR_AD_REG, (int16_t*) cur);
+}
+
+/******************************************************************************/
+static int sfp_get_rx_pwr(tcv_t *tcv, uint16_t* pwr)
+{
+	return ((sfp_data_t *) tcv->data)->dd->get_rx_pwr(tcv, pwr);
 }
+
 /******************************************************************************/
 
 /**
- *  \brief Converts to a float from a big-endian 4-byte source buffer.
- *  	   taken from ethtool
- *  \param source bytes form digital diagnostic (MSA defines BE)
- *  \return IEE754 float
+ * \brief Check digital diagnostics can be read and name the region holding
+ *        the measured values, used for synchronous and queued snapshots
+ * \param tcv transceiver handle
+ * \param region (out) devaddr, regaddr and len of the values, data untouched
+ * \return 0 for success, error code < 0 otherwise
  */
-static float befloattoh(const uint32_t source)
+static int sfp_prepare_dd_snapshot(tcv_t *tcv, tcv_i2c_segment_t *region)
 {
-	union {
-		uint32_t src;
-		float dst;
-	} converter;
+	int ret;
 
-	converter.src = ntohl(source);
-	return converter.dst;
+	ret = ((sfp_data_t *) tcv->data)->dd->prepare_snapshot(tcv);
+	if (ret < 0)
+		return ret;
+
+	region->devaddr = DD_DEVICE_ADDRESS;
+	region->regaddr = DD_VALUES_REG;
+	region->len = DD_VALUES_SIZE;
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Convert values read in the given time
+ */
+static void decode_dd_values(tcv_t *tcv, const uint8_t *raw, uint64_t when,
+                             tcv_dd_snapshot_t *snapshot)
+{
+	const sfp_data_t *sfp_data = (sfp_data_t *) tcv->data;
+
+	unpack_raw_snapshot(raw, when, snapshot);
+	if (sfp_data->dd->decode_snapshot)
+		sfp_data->dd->decode_snapshot(sfp_data, snapshot);
 }
 
+/******************************************************************************/
+
+/**
+ * \brief Convert the region named by sfp_prepare_dd_snapshot(), just read
+ * \param tcv transceiver handle
+ * \param raw bytes read
+ * \param snapshot (out) calibrated values, timestamp set to now
+ * \return 0 for success, error code < 0 otherwise
+ */
+static int sfp_decode_dd_snapshot(tcv_t *tcv, const uint8_t *raw,
+                                  tcv_dd_snapshot_t *snapshot)
+{
+	uint64_t now = tcv_clock_ns();
+
+	/* queued snapshots feed the getters as well */
+	dd_cache_store(tcv, raw, now);
+	decode_dd_values(tcv, raw, now, snapshot);
+	return 0;
+}
 
 /******************************************************************************/
-static int sfp_get_rx_pwr(tcv_t *tcv, uint16_t* pwr)
+
+/**
+ * \brief Read all digital diagnostics values in a single burst
+ *
+ * Only bytes 96-105 are read, external calibration uses the cached constants.
+ * \param tcv transceiver handle
+ * \param snapshot (out) calibrated values and time of the read
+ * \return 0 for success, error code < 0 otherwise
+ */
+static int sfp_get_dd_snapshot(tcv_t *tcv, tcv_dd_snapshot_t *snapshot)
 {
-	/* really, in the standard its a float! */
-	uint32_t factors[5];
-	float pwrs[5];
-	uint16_t rxpwr;
-	float val = 0;
-	int i;
-	en_calibration_type calib;
+	uint8_t raw[DD_VALUES_SIZE];
+	tcv_i2c_segment_t region;
+	uint64_t when;
+	int ret;
 
-	calib = sfp_dd_type(tcv);
+	ret = sfp_prepare_dd_snapshot(tcv, &region);
+	if (ret < 0)
+		return ret;
 
-	switch (calib) {
-		case DD_UNAVAILABLE:
-			return TCV_ERR_DIAGNOSTICS_INFO_NOT_PRESENT;
-		case DD_CALIB_INTERNAL:
-			/**
-			 * Internally calibrated value
-			 * AD register contains value
-			 */
-			return get_short_ad_val(tcv, DD_RX_PWR_AD_REG, (int16_t*)pwr);
-			break;
+	if (read_dd_values(tcv, raw, &when) < 0)
+		return TCV_ERR_GENERIC;
 
-		case DD_CALIB_EXTERNAL:
-			/**
-			 * Externally Calibrated value
-			 */
-			if (tcv->read(tcv->index, DD_DEVICE_ADDRESS, DD_RX_PWR_CAL, (uint8_t*) factors,
-					sizeof(factors)) < 0)
-				return TCV_ERR_GENERIC;
-
-			if (tcv->read(tcv->index, DD_DEVICE_ADDRESS, DD_RX_PWR_AD_REG, (uint8_t*) &rxpwr,
-					sizeof(rxpwr)) < 0)
-				return TCV_ERR_GENERIC;
-
-			rxpwr = ntohs(rxpwr);
-			pwrs[0] = 1.0f;  //rxpwr^0
-			pwrs[1] = rxpwr; //rxpwr^1
-			pwrs[2] = pwrs[1] * rxpwr; //rxpwr^2
-			pwrs[3] = pwrs[2] * rxpwr; //rxpwr^3
-			pwrs[4] = pwrs[3] * rxpwr; //rxpwr^4
-
-			for (i = 0; i < 5; i++) {
-				// Calibration factors are in reverse order in array
-				float fact = befloattoh(factors[4 - i]);
-				val += fact * pwrs[i]; // multiply accumulate
-			}
-
-			/* adjust to 16-Bit representation */
-			*pwr = (uint16_t) val;
-			return 0;
+	decode_dd_values(tcv, raw, when, snapshot);
+	return 0;
+}
 
-		default:
-			/* Neither internally nor externally calibrated */
-			return TCV_ERR_GENERIC;
+/******************************************************************************/
+static int sfp_get_a0_image(tcv_t *tcv, uint8_t *a0, size_t len)
+{
+	uint8_t image[SFP_A0_SIZE];
+	int ret;
+
+	if (len > SFP_A0_SIZE)
+		return TCV_ERR_INVALID_ARG;
+
+	ret = sfp_load_a0(tcv, tcv->data, SFP_A0_SIZE);
+	if (ret < 0)
+		return ret;
+
+	sfp_a0_compose(((sfp_data_t *) tcv->data)->st, image);
+	memcpy(a0, image, len);
+	return 0;
+}
+
+/******************************************************************************/
+static int sfp_get_dd_cache_stats(tcv_t *tcv, tcv_dd_cache_stats_t *stats)
+{
+	*stats = ((sfp_data_t *) tcv->data)->dd_cache_stats;
+	return 0;
+}
+
+/******************************************************************************/
+
+static int sfp_get_read_ahead_stats(tcv_t *tcv, tcv_read_ahead_stats_t *stats)
+{
+	const sfp_data_t *sfp_data = (sfp_data_t *) tcv->data;
+	uint64_t word = sfp_data->ra_cost[0];
+	uint64_t region = sfp_data->ra_cost[1];
+
+	*stats = sfp_data->ra_stats;
+	stats->xfer_ns = 0;
+	stats->byte_ns = 0;
+
+	/* cost = xfer + n * byte through both averages */
+	if (word && region) {
+		uint64_t per_byte = region > word ?
+			(region - word) / (DD_AHEAD_SIZE - 2) : 0;
+
+		stats->byte_ns = (uint32_t) per_byte;
+		stats->xfer_ns = (uint32_t) (word > 2 * per_byte ? word - 2 * per_byte : 0);
 	}
+	return 0;
 }
 /******************************************************************************/
 
@@ -1767,45 +3496,45 @@ static int sfp_get_rx_pwr(tcv_t *tcv, uint16_t* pwr)
  * Member functions for sfp modules
  */
 const struct tcv_functions sfp_funcs = {
-	.get_identifier = sfp_get_identifier,
-	.get_ext_identifier = sfp_get_ext_identifier,
-	.get_connector = sfp_get_connector,
-	.get_vendor_name = sfp_get_vendor_name,
-	.get_vendor_oui = sfp_get_vendor_oui,
-	.get_vendor_revision = sfp_get_vendor_revision,
-	.get_vendor_part_number = sfp_get_vendor_part_number,
-	.get_vendor_serial_number = sfp_get_vendor_sn,
-	.get_vendor_date_code = sfp_get_vendor_date_code,
-	.get_10g_compliance_codes = sfp_get_10g_compliance_codes,
-	.get_infiniband_compliance_codes = sfp_get_infiniband_compliance_codes,
-	.get_escon_compliance_codes = sfp_get_escon_compliance_codes,
-	.get_sonet_compliance_codes = sfp_get_sonet_compliance_codes,
-	.get_eth_compliance_codes = sfp_get_eth_compliance_codes,
-	.get_fibre_channel_link_length = sfp_get_fibre_channel_link_length,
-	.get_fibre_channel_technology  =  sfp_get_fibre_channel_technology,
-	.get_sfp_plus_cable_technology = sfp_get_sfp_plus_cable_technology,
-	.get_fibre_channel_media = sfp_get_fibre_channel_media,
-	.get_fibre_channel_speed = sfp_get_fibre_channel_speed,
-	.get_encoding =  sfp_get_encoding,
-	.get_nominal_bit_rate = sfp_get_nominal_bit_rate,
-	.get_rate_identifier =  sfp_get_rate_identifier,
-	.get_sm_length =  sfp_get_sm_length,
-	.get_om1_length = sfp_get_om1_length,
-	.get_om2_length = sfp_get_om2_length,
-	.get_om3_length = sfp_get_om3_length,
-	.get_om4_copper_length = sfp_get_om4_length_copper_length,
-	.get_wave_len =  sfp_get_wavelength,
-	.get_passive_cable_compliance = sfp_get_passive_cable_compliance,
-	.get_active_cable_compliance = sfp_get_active_cable_compliance,
-	.get_cc_base = sfp_get_cc_base,
-	.calculate_cc_base = sfp_calculate_cc_base,
-	.get_implemented_options = sfp_get_implemented_options,
-	.get_max_bit_rate =  sfp_get_max_bit_rate,
-	.get_min_bit_rate = sfp_get_min_bit_rate,
-	.get_diagnostic_type =  sfp_get_diagnostic_type,
-	.get_enhanced_options = sfp_get_enhance_options,
-	.get_cc_ext = sfp_get_cc_ext,
-	.calculate_cc_ext = sfp_calculate_cc_ext,
+	.get_identifier = sfp_static_get_identifier,
+	.get_ext_identifier = sfp_static_get_ext_identifier,
+	.get_connector = sfp_static_get_connector,
+	.get_vendor_name = sfp_static_get_vendor_name,
+	.get_vendor_oui = sfp_static_get_vendor_oui,
+	.get_vendor_revision = sfp_static_get_vendor_revision,
+	.get_vendor_part_number = sfp_static_get_vendor_part_number,
+	.get_vendor_serial_number = sfp_static_get_vendor_sn,
+	.get_vendor_date_code = sfp_static_get_vendor_date_code,
+	.get_10g_compliance_codes = sfp_static_get_10g_compliance_codes,
+	.get_infiniband_compliance_codes = sfp_static_get_infiniband_compliance_codes,
+	.get_escon_compliance_codes = sfp_static_get_escon_compliance_codes,
+	.get_sonet_compliance_codes = sfp_static_get_sonet_compliance_codes,
+	.get_eth_compliance_codes = sfp_static_get_eth_compliance_codes,
+	.get_fibre_channel_link_length = sfp_static_get_fibre_channel_link_length,
+	.get_fibre_channel_technology  =  sfp_static_get_fibre_channel_technology,
+	.get_sfp_plus_cable_technology = sfp_static_get_sfp_plus_cable_technology,
+	.get_fibre_channel_media = sfp_static_get_fibre_channel_media,
+	.get_fibre_channel_speed = sfp_static_get_fibre_channel_speed,
+	.get_encoding =  sfp_static_get_encoding,
+	.get_nominal_bit_rate = sfp_static_get_nominal_bit_rate,
+	.get_rate_identifier =  sfp_static_get_rate_identifier,
+	.get_sm_length =  sfp_static_get_sm_length,
+	.get_om1_length = sfp_static_get_om1_length,
+	.get_om2_length = sfp_static_get_om2_length,
+	.get_om3_length = sfp_static_get_om3_length,
+	.get_om4_copper_length = sfp_static_get_om4_length_copper_length,
+	.get_wave_len =  sfp_static_get_wavelength,
+	.get_passive_cable_compliance = sfp_static_get_passive_cable_compliance,
+	.get_active_cable_compliance = sfp_static_get_active_cable_compliance,
+	.get_cc_base = sfp_static_get_cc_base,
+	.calculate_cc_base = sfp_static_calculate_cc_base,
+	.get_implemented_options = sfp_static_get_implemented_options,
+	.get_max_bit_rate =  sfp_static_get_max_bit_rate,
+	.get_min_bit_rate = sfp_static_get_min_bit_rate,
+	.get_diagnostic_type =  sfp_static_get_diagnostic_type,
+	.get_enhanced_options = sfp_static_get_enhance_options,
+	.get_cc_ext = sfp_static_get_cc_ext,
+	.calculate_cc_ext = sfp_static_calculate_cc_ext,
 	.get_vendor_rom = sfp_get_vendor_rom,
 	.get_vendor_rom_size = sfp_get_vendor_rom_size,
 	.get_user_writable_eeprom = sfp_get_user_writable_eeprom,
@@ -1813,9 +3542,19 @@ const struct tcv_functions sfp_funcs = {
 	.get_8079_rom = sfp_get_8079_rom,
 	.raw_read = sfp_read,
 	.raw_write = sfp_write,
+	.read_paged = sfp_read_paged,
+	.write_paged = sfp_write_paged,
 	.get_rx_pwr = sfp_get_rx_pwr,
 	.get_tx_pwr = sfp_get_tx_pwr,
 	.get_temp = sfp_get_temp,
 	.get_voltage = sfp_get_voltage,
 	.get_tx_cur = sfp_get_tx_cur,
+	.get_dd_snapshot = sfp_get_dd_snapshot,
+	.get_a0_image = sfp_get_a0_image,
+	.get_dd_cache_stats = sfp_get_dd_cache_stats,
+	.get_read_ahead_stats = sfp_get_read_ahead_stats,
+	.prepare_dd_snapshot = sfp_prepare_dd_snapshot,
+	.decode_dd_snapshot = sfp_decode_dd_snapshot,
+	.refresh = sfp_refresh,
+	.revalidate = sfp_revalidate,
 };
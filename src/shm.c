@@ -0,0 +1,338 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Shared memory publisher, see libtcv/shm.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "libtcv/shm.h"
+#include "libtcv/tcv_internal.h"
+
+#define SHM_MAGIC			0x4d485354u	/* "TSHM" */
+#define SHM_VERSION			1
+/** Reads of a slot before giving up on a busy publisher */
+#define SHM_READ_TRIES		1000
+
+struct shm_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t nslots;
+	uint32_t slot_size;	//! sizeof(struct shm_slot) of the publisher
+};
+
+struct shm_slot {
+	_Atomic uint32_t seq;	//! odd while the publisher writes the slot
+	uint32_t flags;
+	int32_t index;
+	uint8_t a0[256];
+	tcv_dd_snapshot_t dd;
+};
+
+struct tcv_shm {
+	char *name;				//! publisher only, to remove the object
+	struct shm_header *hdr;
+	struct shm_slot *slots;
+	size_t size;			//! mapped bytes
+	pthread_mutex_t lock;	//! publisher threads, readers never take it
+};
+
+/******************************************************************************/
+
+static tcv_shm_t *shm_alloc(void *map, size_t size)
+{
+	tcv_shm_t *shm;
+
+	shm = malloc(sizeof(tcv_shm_t));
+	if (!shm)
+		return NULL;
+
+	if (pthread_mutex_init(&shm->lock, NULL)) {
+		free(shm);
+		return NULL;
+	}
+
+	shm->name = NULL;
+	shm->hdr = map;
+	shm->slots = (struct shm_slot *) (shm->hdr + 1);
+	shm->size = size;
+	return shm;
+}
+
+/******************************************************************************/
+
+tcv_shm_t *tcv_shm_create(const char *name, size_t nslots)
+{
+	const size_t size = sizeof(struct shm_header) + nslots * sizeof(struct shm_slot);
+	tcv_shm_t *shm;
+	void *map;
+	int fd;
+
+	if (!name || !nslots || nslots > UINT32_MAX)
+		return NULL;
+
+	/* truncating an object readers have mapped would fault them */
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd < 0)
+		return NULL;
+
+	if (ftruncate(fd, size)) {
+		close(fd);
+		shm_unlink(name);
+		return NULL;
+	}
+
+	map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		shm_unlink(name);
+		return NULL;
+	}
+
+	shm = shm_alloc(map, size);
+	if (shm)
+		shm->name = strdup(name);
+	if (!shm || !shm->name) {
+		free(shm);
+		munmap(map, size);
+		shm_unlink(name);
+		return NULL;
+	}
+
+	/* slots are zero filled: sequence 0, nothing published */
+	shm->hdr->version = SHM_VERSION;
+	shm->hdr->nslots = nslots;
+	shm->hdr->slot_size = sizeof(struct shm_slot);
+	/* readers check the magic last */
+	atomic_thread_fence(memory_order_release);
+	shm->hdr->magic = SHM_MAGIC;
+	return shm;
+}
+
+/******************************************************************************/
+
+int tcv_shm_unlink(const char *name)
+{
+	if (!name)
+		return TCV_ERR_INVALID_ARG;
+
+	if (shm_unlink(name) && errno != ENOENT)
+		return TCV_ERR_GENERIC;
+	return 0;
+}
+
+/******************************************************************************/
+
+tcv_shm_t *tcv_shm_open(const char *name)
+{
+	const struct shm_header *hdr;
+	struct stat st;
+	tcv_shm_t *shm;
+	void *map;
+	int fd;
+
+	if (!name)
+		return NULL;
+
+	fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat(fd, &st) || (size_t) st.st_size < sizeof(struct shm_header)) {
+		close(fd);
+		return NULL;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return NULL;
+
+	/* written by a publisher of the same layout */
+	hdr = map;
+	if (hdr->magic != SHM_MAGIC || hdr->version != SHM_VERSION ||
+	    hdr->slot_size != sizeof(struct shm_slot) ||
+	    sizeof(*hdr) + (size_t) hdr->nslots * hdr->slot_size > (size_t) st.st_size) {
+		munmap(map, st.st_size);
+		return NULL;
+	}
+
+	shm = shm_alloc(map, st.st_size);
+	if (!shm)
+		munmap(map, st.st_size);
+
+	return shm;
+}
+
+/******************************************************************************/
+
+int tcv_shm_close(tcv_shm_t *shm)
+{
+	if (!shm)
+		return TCV_ERR_INVALID_ARG;
+
+	munmap(shm->hdr, shm->size);
+	if (shm->name) {
+		shm_unlink(shm->name);
+		free(shm->name);
+	}
+	pthread_mutex_destroy(&shm->lock);
+	free(shm);
+	return 0;
+}
+
+/******************************************************************************/
+
+size_t tcv_shm_slots(const tcv_shm_t *shm)
+{
+	return shm ? shm->hdr->nslots : 0;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Mark a slot as being written, readers retry until slot_end()
+ */
+static void slot_begin(struct shm_slot *s)
+{
+	uint32_t seq = atomic_load_explicit(&s->seq, memory_order_relaxed);
+
+	atomic_store_explicit(&s->seq, seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+}
+
+/******************************************************************************/
+
+static void slot_end(struct shm_slot *s)
+{
+	uint32_t seq = atomic_load_explicit(&s->seq, memory_order_relaxed);
+
+	atomic_store_explicit(&s->seq, seq + 1, memory_order_release);
+}
+
+/******************************************************************************/
+
+int tcv_shm_publish(tcv_shm_t *shm, size_t slot, tcv_t *tcv)
+{
+	uint8_t a0[256];
+	tcv_dd_snapshot_t dd;
+	uint32_t flags = TCV_SHM_A0_VALID;
+	struct shm_slot *s;
+	int ret;
+
+	if (!shm || !shm->name || slot >= shm->hdr->nslots || !tcv || !tcv->created)
+		return TCV_ERR_INVALID_ARG;
+
+	/* all I2C access is done before the slot is touched */
+	tcv_io_lock(tcv);
+	if (!tcv->initialized) {
+		ret = TCV_ERR_NOT_INITIALIZED;
+	} else if (!tcv->fun->get_a0_image) {
+		ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
+	} else {
+		ret = tcv->fun->get_a0_image(tcv, a0, sizeof(a0));
+		if (ret == 0 && tcv->fun->get_dd_snapshot &&
+		    tcv->fun->get_dd_snapshot(tcv, &dd) == 0)
+			flags |= TCV_SHM_DD_VALID;
+	}
+	tcv_io_unlock(tcv);
+	if (ret < 0)
+		return ret;
+
+	s = &shm->slots[slot];
+	pthread_mutex_lock(&shm->lock);
+	slot_begin(s);
+	s->index = tcv->index;
+	s->flags = flags;
+	memcpy(s->a0, a0, sizeof(a0));
+	if (flags & TCV_SHM_DD_VALID)
+		s->dd = dd;
+	slot_end(s);
+	pthread_mutex_unlock(&shm->lock);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_shm_publish_dd(tcv_shm_t *shm, size_t slot,
+                       const tcv_dd_snapshot_t *snapshot)
+{
+	struct shm_slot *s;
+
+	if (!shm || !shm->name || slot >= shm->hdr->nslots || !snapshot)
+		return TCV_ERR_INVALID_ARG;
+
+	s = &shm->slots[slot];
+	pthread_mutex_lock(&shm->lock);
+	slot_begin(s);
+	s->flags |= TCV_SHM_DD_VALID;
+	s->dd = *snapshot;
+	slot_end(s);
+	pthread_mutex_unlock(&shm->lock);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_shm_read(const tcv_shm_t *shm, size_t slot, tcv_shm_port_t *port)
+{
+	const struct shm_slot *s;
+	uint32_t seq;
+	int tries;
+
+	if (!shm || slot >= shm->hdr->nslots || !port)
+		return TCV_ERR_INVALID_ARG;
+
+	s = &shm->slots[slot];
+	for (tries = 0; tries < SHM_READ_TRIES; tries++) {
+		seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+		if (seq & 1)
+			continue;
+
+		port->index = s->index;
+		port->flags = s->flags;
+		memcpy(port->a0, s->a0, sizeof(port->a0));
+		port->dd = s->dd;
+
+		atomic_thread_fence(memory_order_acquire);
+		if (atomic_load_explicit(&s->seq, memory_order_relaxed) != seq)
+			continue;
+
+		return port->flags ? 0 : TCV_ERR_NOT_INITIALIZED;
+	}
+
+	return TCV_ERR_BUSY;
+}
@@ -31,10 +31,18 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
 
 #include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 
 #include "libtcv/tcv_internal.h"
+#include "libtcv/bus.h"
+#include "libtcv/eeprom_cache.h"
+#include "libtcv/image_store.h"
 #include "libtcv/sfp.h"
 #include "libtcv/xfp.h"
 
@@ -54,22 +62,300 @@ static bool tcv_is_valid(tcv_t *tcv)
 
 /******************************************************************************/
 
+#ifdef TCV_LOCK_DEBUG
 /**
- * Check if transceiver was properly initialized
- * @param tcv
- * @return
+ * \brief Instrumentation of one handle lock, see tcv_get_lock_histograms()
+ *
+ * Only exclusive holders are tracked: the I/O lock and writers of the state
+ * lock.
+ */
+struct tcv_lock_debug {
+	atomic_bool owned;	//! Held exclusively by owner
+	_Atomic(pthread_t) owner;	//! Valid while owned
+	uint64_t held_since;	//! Time owner got the lock, used by owner only
+	atomic_uint_fast64_t wait[TCV_LOCK_HIST_BUCKETS];	//! Wait time histogram
+	atomic_uint_fast64_t hold[TCV_LOCK_HIST_BUCKETS];	//! Hold time histogram
+	atomic_uint_fast64_t max_wait_ns;	//! Longest wait
+	atomic_uint_fast64_t max_hold_ns;	//! Longest exclusive hold
+};
+#endif
+
+/**
+ * \brief Counters of one handle lock
+ */
+struct tcv_lock_counters {
+	atomic_uint_fast64_t acquired;	//! Times the lock was taken
+	atomic_uint_fast64_t contended;	//! Times it was held by another thread
+	atomic_uint_fast64_t wait_ns;	//! Time spent waiting for it
+#ifdef TCV_LOCK_DEBUG
+	struct tcv_lock_debug debug;	//! Histograms and owner
+#endif
+};
+
+/**
+ * \brief Handle state used without the handle locks
+ *
+ * Getters count themselves in the readers slot of the current epoch while
+ * they use current. Replaced entries wait in retired until a writer has moved
+ * to the next epoch and the previous slot drained: a getter that came in
+ * later can only have loaded a newer entry, so the wait is bounded by the
+ * getters already running, however busy the handle is.
+ */
+struct tcv_sync {
+	_Atomic(struct tcv_static *) current;	//! Static data, NULL if not initialized
+	atomic_uint epoch;	//! Its low bit selects the readers slot of new getters
+	atomic_uint readers[2];	//! Getters between acquire and release, per slot
+	struct tcv_static *retired;	//! Replaced entries, guarded by the I/O lock
+	struct tcv_lock_counters io;	//! I/O lock contention
+	struct tcv_lock_counters state;	//! State lock contention
+};
+
+/******************************************************************************/
+
+/**
+ * \brief CLOCK_MONOTONIC in nanoseconds
  */
-static bool tcv_is_initialized(tcv_t *tcv)
+static uint64_t tcv_now_ns(void)
 {
-	if (!tcv_is_valid(tcv))
-		return false;
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/******************************************************************************/
+
+/** Clock of the module timing decisions, see tcv_set_clock() */
+static uint64_t (*tcv_clock)(void) = tcv_now_ns;
+
+uint64_t tcv_clock_ns(void)
+{
+	return tcv_clock();
+}
+
+/******************************************************************************/
+
+void tcv_set_clock(uint64_t (*now_ns)(void))
+{
+	tcv_clock = now_ns ? now_ns : tcv_now_ns;
+}
+
+/******************************************************************************/
+
+#ifdef TCV_LOCK_DEBUG
+/**
+ * \brief Histogram bucket of a duration, see tcv_lock_hist_t
+ */
+static unsigned int tcv_lock_bucket(uint64_t ns)
+{
+	uint64_t us = ns / 1000;
+	unsigned int bucket = 0;
+
+	while (us && bucket < TCV_LOCK_HIST_BUCKETS - 1) {
+		us >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
 
-	return tcv->initialized;
+/******************************************************************************/
+
+/**
+ * \brief Raise a maximum
+ */
+static void tcv_lock_max(atomic_uint_fast64_t *max, uint64_t val)
+{
+	uint_fast64_t cur = atomic_load_explicit(max, memory_order_relaxed);
+
+	while (cur < val &&
+	       !atomic_compare_exchange_weak_explicit(max, &cur, val,
+	                                              memory_order_relaxed,
+	                                              memory_order_relaxed))
+		;
 }
+
 /******************************************************************************/
 
 /**
- * Check if tcv exists/is valid and lock for exclusive access
+ * \brief Stop a thread about to wait for a lock it holds itself
+ *
+ * Waiting would never return, the report and the core point at the caller.
+ * \param c counters of the lock
+ * \param name lock name for the report
+ * \param caller return address of the lock function
+ */
+static void tcv_lock_check_owner(struct tcv_lock_counters *c, const char *name,
+                                 void *caller)
+{
+	struct tcv_lock_debug *d = &c->debug;
+
+	if (!atomic_load(&d->owned) ||
+	    !pthread_equal(atomic_load(&d->owner), pthread_self()))
+		return;
+
+	fprintf(stderr, "> %s - Error: %s lock taken again by its owner, "
+	        "called from %p\n", __func__, name, caller);
+	abort();
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Record an acquisition in the histograms
+ * \param c counters of the lock
+ * \param wait time spent waiting
+ * \param now time the lock was got
+ * \param exclusive no other thread holds the lock until tcv_lock_debug_release()
+ */
+static void tcv_lock_debug_acquired(struct tcv_lock_counters *c, uint64_t wait,
+                                    uint64_t now, bool exclusive)
+{
+	struct tcv_lock_debug *d = &c->debug;
+
+	atomic_fetch_add_explicit(&d->wait[tcv_lock_bucket(wait)], 1,
+	                          memory_order_relaxed);
+	tcv_lock_max(&d->max_wait_ns, wait);
+	if (exclusive) {
+		d->held_since = now;
+		atomic_store(&d->owner, pthread_self());
+		atomic_store(&d->owned, true);
+	}
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Record the end of an exclusive hold, before the lock is released
+ * \param c counters of the lock
+ */
+static void tcv_lock_debug_release(struct tcv_lock_counters *c)
+{
+	struct tcv_lock_debug *d = &c->debug;
+	uint64_t hold;
+
+	/* readers of the state lock are not tracked */
+	if (!atomic_load(&d->owned) ||
+	    !pthread_equal(atomic_load(&d->owner), pthread_self()))
+		return;
+
+	hold = tcv_now_ns() - d->held_since;
+	atomic_store(&d->owned, false);
+	atomic_fetch_add_explicit(&d->hold[tcv_lock_bucket(hold)], 1,
+	                          memory_order_relaxed);
+	tcv_lock_max(&d->max_hold_ns, hold);
+}
+
+#else
+
+static inline void tcv_lock_check_owner(struct tcv_lock_counters *c,
+                                        const char *name, void *caller)
+{
+}
+
+static inline void tcv_lock_debug_release(struct tcv_lock_counters *c)
+{
+}
+
+#endif
+
+/******************************************************************************/
+
+/**
+ * \brief Count an acquisition
+ * \param c counters of the lock
+ * \param start time the caller started waiting, 0 if the lock was free
+ * \param exclusive no other thread holds the lock
+ */
+static void tcv_lock_account(struct tcv_lock_counters *c, uint64_t start,
+                             bool exclusive)
+{
+	uint64_t now = 0;
+
+	atomic_fetch_add_explicit(&c->acquired, 1, memory_order_relaxed);
+	if (start) {
+		now = tcv_now_ns();
+		atomic_fetch_add_explicit(&c->contended, 1, memory_order_relaxed);
+		atomic_fetch_add_explicit(&c->wait_ns, now - start,
+		                          memory_order_relaxed);
+	}
+#ifdef TCV_LOCK_DEBUG
+	if (!start)
+		now = start = tcv_now_ns();
+	tcv_lock_debug_acquired(c, now - start, now, exclusive);
+#endif
+}
+
+/******************************************************************************/
+
+void tcv_io_lock(tcv_t *tcv)
+{
+	uint64_t start = 0;
+
+	tcv_lock_check_owner(&tcv->sync->io, "I/O", __builtin_return_address(0));
+	if (pthread_mutex_trylock(&tcv->io_lock)) {
+		start = tcv_now_ns();
+		pthread_mutex_lock(&tcv->io_lock);
+	}
+	tcv_lock_account(&tcv->sync->io, start, true);
+}
+
+/******************************************************************************/
+
+void tcv_io_unlock(tcv_t *tcv)
+{
+	struct tcv_bus *wake = tcv->bus_wake;
+
+	tcv->bus_wake = NULL;
+	tcv_lock_debug_release(&tcv->sync->io);
+	pthread_mutex_unlock(&tcv->io_lock);
+
+	/* requests started now may complete right here */
+	if (wake)
+		tcv_bus_wake(wake);
+}
+
+/******************************************************************************/
+
+void tcv_state_rdlock(tcv_t *tcv)
+{
+	uint64_t start = 0;
+
+	tcv_lock_check_owner(&tcv->sync->state, "state",
+	                     __builtin_return_address(0));
+	if (pthread_rwlock_tryrdlock(&tcv->state_lock)) {
+		start = tcv_now_ns();
+		pthread_rwlock_rdlock(&tcv->state_lock);
+	}
+	tcv_lock_account(&tcv->sync->state, start, false);
+}
+
+/******************************************************************************/
+
+void tcv_state_wrlock(tcv_t *tcv)
+{
+	uint64_t start = 0;
+
+	tcv_lock_check_owner(&tcv->sync->state, "state",
+	                     __builtin_return_address(0));
+	if (pthread_rwlock_trywrlock(&tcv->state_lock)) {
+		start = tcv_now_ns();
+		pthread_rwlock_wrlock(&tcv->state_lock);
+	}
+	tcv_lock_account(&tcv->sync->state, start, true);
+}
+
+/******************************************************************************/
+
+void tcv_state_unlock(tcv_t *tcv)
+{
+	tcv_lock_debug_release(&tcv->sync->state);
+	pthread_rwlock_unlock(&tcv->state_lock);
+}
+
+/******************************************************************************/
+
+/**
+ * Check if tcv exists/is valid and take the I/O lock
  * @param tcv
  * @return
  */
@@ -78,25 +364,170 @@ static bool tcv_check_and_lock_ok(tcv_t* tcv)
 	if (!tcv_is_valid(tcv))
 		return false;
 
-	if (pthread_mutex_lock(&tcv->lock))
-		return false;
-
+	tcv_io_lock(tcv);
 	return true;
 }
 
 /******************************************************************************/
 /**
- * Unlock mutex wrapper to use if tcv_check_and_lock() uses mutex
+ * Release the I/O lock of tcv_check_and_lock_ok()
  * @param tcv
- * @return 0 for success, error code oderwise
+ * @return 0 for success
  */
 static inline int tcv_unlock(tcv_t* tcv)
 {
-	return pthread_mutex_unlock(&tcv->lock);
+	tcv_io_unlock(tcv);
+	return 0;
 }
 
 /******************************************************************************/
-tcv_t * tcv_create(int index, i2c_read_cb_t read, i2c_write_cb_t write)
+
+/**
+ * Check if tcv is initialized and take the I/O lock. Uninitialized handles
+ * are turned away without waiting for transfers in progress.
+ * @param tcv
+ * @return 0 with the I/O lock held, error code otherwise
+ */
+static int tcv_lock_initialized(tcv_t *tcv)
+{
+	bool initialized;
+
+	if (!tcv_is_valid(tcv))
+		return TCV_ERR_INVALID_ARG;
+
+	tcv_state_rdlock(tcv);
+	initialized = tcv->initialized;
+	tcv_state_unlock(tcv);
+	if (!initialized)
+		return TCV_ERR_NOT_INITIALIZED;
+
+	/* may have been re-initialized meanwhile, without success */
+	tcv_io_lock(tcv);
+	if (!tcv->initialized) {
+		tcv_io_unlock(tcv);
+		return TCV_ERR_NOT_INITIALIZED;
+	}
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * Check if tcv is initialized and take the state lock for reading
+ * @param tcv
+ * @return 0 with the state lock held, error code otherwise
+ */
+static int tcv_rdlock_initialized(tcv_t *tcv)
+{
+	if (!tcv_is_valid(tcv))
+		return TCV_ERR_INVALID_ARG;
+
+	tcv_state_rdlock(tcv);
+	if (!tcv->initialized) {
+		tcv_state_unlock(tcv);
+		return TCV_ERR_NOT_INITIALIZED;
+	}
+	return 0;
+}
+
+/******************************************************************************/
+
+const struct tcv_static *tcv_static_acquire(tcv_t *tcv, unsigned *slot)
+{
+	unsigned s;
+
+	/* a reclaim flipping the epoch before the count got in does not wait
+	 * for it, count in the slot it waits for next */
+	for (;;) {
+		s = atomic_load(&tcv->sync->epoch) & 1;
+		atomic_fetch_add(&tcv->sync->readers[s], 1);
+		if ((atomic_load(&tcv->sync->epoch) & 1) == s)
+			break;
+		atomic_fetch_sub(&tcv->sync->readers[s], 1);
+	}
+	*slot = s;
+	return atomic_load(&tcv->sync->current);
+}
+
+/******************************************************************************/
+
+void tcv_static_release(tcv_t *tcv, unsigned slot)
+{
+	atomic_fetch_sub_explicit(&tcv->sync->readers[slot], 1,
+	                          memory_order_release);
+}
+
+/******************************************************************************/
+
+const struct tcv_static *tcv_static_get(const tcv_t *tcv)
+{
+	return atomic_load_explicit(&tcv->sync->current, memory_order_acquire);
+}
+
+/******************************************************************************/
+
+void tcv_static_publish(tcv_t *tcv, struct tcv_static *st)
+{
+	struct tcv_static *old;
+
+	old = atomic_exchange(&tcv->sync->current, st);
+	if (old) {
+		old->retired = tcv->sync->retired;
+		tcv->sync->retired = old;
+	}
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Free the replaced static data once the getters that may still use
+ *        it have returned. Getters starting meanwhile do not delay it.
+ * \param tcv transceiver handle, I/O locked
+ */
+static void tcv_static_reclaim(tcv_t *tcv)
+{
+	struct tcv_static *st;
+	unsigned slot;
+
+	if (!tcv->sync->retired)
+		return;
+
+	slot = atomic_fetch_add(&tcv->sync->epoch, 1) & 1;
+	while (atomic_load(&tcv->sync->readers[slot]))
+		sched_yield();
+
+	while ((st = tcv->sync->retired)) {
+		tcv->sync->retired = st->retired;
+		st->free(st);
+	}
+}
+
+/******************************************************************************/
+/**
+ * Read shim for handles created by tcv_create(): resolve the context back to
+ * the handle and call the index based callback
+ */
+static int tcv_legacy_read(void *ctx, uint8_t devaddr, uint8_t regaddr,
+                           uint8_t* data, size_t len)
+{
+	tcv_t *tcv = (tcv_t*) ctx;
+	return tcv->legacy_read(tcv->index, devaddr, regaddr, data, len);
+}
+
+/******************************************************************************/
+/**
+ * Write shim for handles created by tcv_create()
+ */
+static int tcv_legacy_write(void *ctx, uint8_t devaddr, uint8_t regaddr,
+                            const uint8_t* data, size_t len)
+{
+	tcv_t *tcv = (tcv_t*) ctx;
+	return tcv->legacy_write(tcv->index, devaddr, regaddr, data, len);
+}
+
+/******************************************************************************/
+tcv_t * tcv_create_ex(int index, void *ctx, i2c_read_ex_cb_t read,
+                      i2c_write_ex_cb_t write)
 {
 	tcv_t * tcv;
 	/* Check parameters */
@@ -107,48 +538,300 @@ tcv_t * tcv_create(int index, i2c_read_cb_t read, i2c_write_cb_t write)
 	if (!tcv)
 		return NULL ;
 
-	/* initialize mutex */
-	if (pthread_mutex_init(&tcv->lock, NULL) < 0) {
+	tcv->sync = calloc(1, sizeof(*tcv->sync));
+	if (!tcv->sync) {
+		free(tcv);
+		return NULL ;
+	}
+	atomic_init(&tcv->sync->current, NULL);
+	atomic_init(&tcv->sync->epoch, 0);
+	atomic_init(&tcv->sync->readers[0], 0);
+	atomic_init(&tcv->sync->readers[1], 0);
+
+	/* initialize locks */
+	if (pthread_mutex_init(&tcv->io_lock, NULL)) {
+		free(tcv->sync);
+		free(tcv);
+		return NULL ;
+	}
+	if (pthread_rwlock_init(&tcv->state_lock, NULL)) {
+		pthread_mutex_destroy(&tcv->io_lock);
+		free(tcv->sync);
 		free(tcv);
 		return NULL ;
 	}
 
 	/* Initialize data */
 	tcv->index = index;
+	tcv->ctx = ctx;
 	/* Provide basic read/write functions */
 	tcv->read = read;
 	tcv->write = write;
+	tcv->legacy_read = NULL;
+	tcv->legacy_write = NULL;
+	tcv->readv = NULL;
+	tcv->caps.max_xfer = 0;
+	tcv->caps.smbus_only = 0;
+	tcv->caps.repeated_start = 1;
+	tcv->xfer_max = SIZE_MAX;
+	tcv->queue = NULL;
+	tcv->bus = NULL;
+	tcv->bus_wake = NULL;
+	tcv->bus_channel = -1;
+	tcv->eeprom_cache = NULL;
+	tcv->image_store = NULL;
+	tcv->fun = NULL;
+	tcv->wcfg.page_size = 0;
+	tcv->wcfg.ack_timeout_ms = 0;
+	tcv->wcfg.verify = 0;
+	tcv->pending = NULL;
+	tcv->lazy_init = false;
+	tcv->dd_max_age_ns = 0;
+	tcv->read_ahead = TCV_READ_AHEAD_OFF;
+	tcv->read_ahead_window_ns = 0;
 	tcv->created = true;
-	/* initialize to be able to check in tcv_is_initialized() */
+	/* initialize to be able to check in tcv_lock_initialized() */
 	tcv->data = NULL;
 	tcv->initialized = false;
 	return tcv;
 }
 
 /******************************************************************************/
-static const uint8_t TCV_DEVADDR_A0 = 0x50;
-static const uint8_t TCV_IDENTIFIER = 0x00;
-
-int tcv_init(tcv_t *tcv)
+tcv_t * tcv_create(int index, i2c_read_cb_t read, i2c_write_cb_t write)
 {
-	uint8_t identifier;
-	int ret = 0;
+	tcv_t * tcv;
+	/* Check parameters */
+	if (read == NULL || write == NULL)
+		return NULL ;
+
+	tcv = tcv_create_ex(index, NULL, tcv_legacy_read, tcv_legacy_write);
+	if (!tcv)
+		return NULL ;
+
+	/* The shims need the handle itself to reach the index based callbacks */
+	tcv->ctx = tcv;
+	tcv->legacy_read = read;
+	tcv->legacy_write = write;
+	return tcv;
+}
 
+/******************************************************************************/
+
+int tcv_set_readv(tcv_t *tcv, i2c_readv_cb_t readv)
+{
 	if (!tcv_check_and_lock_ok(tcv))
 		return TCV_ERR_INVALID_ARG;
 
-	ret = tcv->read(tcv->index, TCV_DEVADDR_A0, TCV_IDENTIFIER, &identifier, 1);
-	if (ret < 0) {
+	/* Index based handles have no context the callback could make use of */
+	if (tcv->legacy_read) {
 		tcv_unlock(tcv);
+		return TCV_ERR_INVALID_ARG;
+	}
+
+	tcv->readv = readv;
+	tcv_unlock(tcv);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_set_transport_caps(tcv_t *tcv, const tcv_transport_caps_t *caps)
+{
+	if (!caps)
+		return TCV_ERR_INVALID_ARG;
+
+	if (!tcv_check_and_lock_ok(tcv))
+		return TCV_ERR_INVALID_ARG;
+
+	tcv_state_wrlock(tcv);
+	tcv->caps = *caps;
+	tcv->xfer_max = caps->max_xfer ? caps->max_xfer : SIZE_MAX;
+	if (caps->smbus_only && tcv->xfer_max > TCV_SMBUS_BLOCK_MAX)
+		tcv->xfer_max = TCV_SMBUS_BLOCK_MAX;
+	tcv_state_unlock(tcv);
+
+	tcv_unlock(tcv);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_get_transport_caps(tcv_t *tcv, tcv_transport_caps_t *caps)
+{
+	if (!caps)
+		return TCV_ERR_INVALID_ARG;
+
+	if (!tcv_is_valid(tcv))
+		return TCV_ERR_INVALID_ARG;
+
+	tcv_state_rdlock(tcv);
+	*caps = tcv->caps;
+	tcv_state_unlock(tcv);
+	return 0;
+}
+
+/******************************************************************************/
+
+/**
+ * Chunked read, bus already taken
+ */
+static int tcv_read_chunks(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr,
+                           uint8_t *data, size_t len)
+{
+	size_t chunk;
+	int ret, total = 0;
+
+	/* Largest transfers the adapter takes, never byte by byte */
+	while (len) {
+		chunk = len < tcv->xfer_max ? len : tcv->xfer_max;
+		ret = tcv->read(tcv->ctx, devaddr, regaddr, data, chunk);
+		if (ret < 0)
+			return ret;
+		total += ret;
+
+		regaddr += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	/* sum of what the callback returned, i.e. 0 or the bytes transferred */
+	return total;
+}
+
+/******************************************************************************/
+
+int tcv_xfer_read(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr,
+                  uint8_t *data, size_t len)
+{
+	int ret;
+
+	ret = tcv_bus_enter(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = tcv_read_chunks(tcv, devaddr, regaddr, data, len);
+	tcv_bus_leave(tcv, ret);
+	return ret;
+}
+
+/******************************************************************************/
+
+int tcv_xfer_write(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr,
+                   const uint8_t *data, size_t len)
+{
+	size_t chunk;
+	int ret, total = 0;
+
+	ret = tcv_bus_enter(tcv);
+	if (ret < 0)
 		return ret;
+
+	while (len) {
+		chunk = len < tcv->xfer_max ? len : tcv->xfer_max;
+		ret = tcv->write(tcv->ctx, devaddr, regaddr, data, chunk);
+		if (ret < 0)
+			break;
+		total += ret;
+
+		regaddr += chunk;
+		data += chunk;
+		len -= chunk;
 	}
 
-	/* if someone calls init on a transceiver with alloc'ed data - clear it first */
-	if (tcv->data) {
-		free(tcv->data);
-		tcv->data = NULL;
+	tcv_bus_leave(tcv, ret);
+	return ret < 0 ? ret : total;
+}
+
+/******************************************************************************/
+
+/**
+ * Check if a vectored read can be handed to the readv() callback as is
+ * @param tcv
+ * @param segs
+ * @param nsegs
+ * @return
+ */
+static bool tcv_readv_fits(tcv_t *tcv, const tcv_i2c_segment_t *segs, size_t nsegs)
+{
+	size_t i;
+
+	/* Combined messages need repeated start, SMBus cannot do them */
+	if (!tcv->readv || !tcv->caps.repeated_start || tcv->caps.smbus_only)
+		return false;
+
+	for (i = 0; i < nsegs; i++) {
+		if (segs[i].len > tcv->xfer_max)
+			return false;
 	}
 
+	return true;
+}
+
+/******************************************************************************/
+
+int tcv_readv(tcv_t *tcv, const tcv_i2c_segment_t *segs, size_t nsegs)
+{
+	size_t i;
+	int ret;
+
+	ret = tcv_bus_enter(tcv);
+	if (ret < 0)
+		return ret;
+
+	if (tcv_readv_fits(tcv, segs, nsegs)) {
+		ret = tcv->readv(tcv->ctx, segs, nsegs);
+	} else {
+		for (i = 0; i < nsegs; i++) {
+			ret = tcv_read_chunks(tcv, segs[i].devaddr, segs[i].regaddr,
+			                      segs[i].data, segs[i].len);
+			if (ret < 0)
+				break;
+		}
+	}
+
+	tcv_bus_leave(tcv, ret);
+	return ret < 0 ? ret : 0;
+}
+
+/******************************************************************************/
+static const uint8_t TCV_DEVADDR_A0 = 0x50;
+static const uint8_t TCV_IDENTIFIER = 0x00;
+
+/**
+ * \brief Free the module data of tcv_init()
+ * \param tcv transceiver handle, I/O and state locked
+ */
+static void tcv_free_data(tcv_t *tcv)
+{
+	/* the published static data stays until the new module replaces it */
+	free(tcv->data);
+	tcv->data = NULL;
+}
+
+/******************************************************************************/
+
+/**
+ * \brief Detect the module type and read its static data
+ * \param tcv transceiver handle, I/O locked
+ * \return 0 if ok, error code otherwise
+ */
+static int tcv_init_locked(tcv_t *tcv)
+{
+	uint8_t identifier;
+	int ret = 0;
+
+	ret = tcv_xfer_read(tcv, TCV_DEVADDR_A0, TCV_IDENTIFIER, &identifier, 1);
+	if (ret < 0)
+		return ret;
+
+	/* if someone calls init on a transceiver with alloc'ed data - clear it first */
+	tcv_state_wrlock(tcv);
+	if (tcv->data)
+		tcv_free_data(tcv);
+	/* until the new module is read completely */
+	tcv->initialized = false;
+	tcv_state_unlock(tcv);
+
 	switch (identifier) {
 		case TCV_TYPE_SFP:
 			ret = sfp_init(tcv);
@@ -161,8 +844,27 @@ int tcv_init(tcv_t *tcv)
 //			break;
 
 		default:
-			return TCV_ERR_GENERIC;
+			ret = TCV_ERR_GENERIC;
+			break;
 	}
+
+	/* the old module's static data is gone with it */
+	if (ret < 0)
+		tcv_static_publish(tcv, NULL);
+	tcv_static_reclaim(tcv);
+	return ret;
+}
+
+/******************************************************************************/
+
+int tcv_init(tcv_t *tcv)
+{
+	int ret;
+
+	if (!tcv_check_and_lock_ok(tcv))
+		return TCV_ERR_INVALID_ARG;
+
+	ret = tcv_init_locked(tcv);
 	if (tcv_unlock(tcv))
 		return TCV_ERR_GENERIC;
 
@@ -171,20 +873,85 @@ int tcv_init(tcv_t *tcv)
 
 /******************************************************************************/
 
+int tcv_set_lazy_init(tcv_t *tcv, int lazy)
+{
+	if (!tcv_check_and_lock_ok(tcv))
+		return TCV_ERR_INVALID_ARG;
+
+	tcv->lazy_init = !!lazy;
+	tcv_unlock(tcv);
+	return 0;
+}
+
+/******************************************************************************/
+
+int tcv_revalidate(tcv_t *tcv)
+{
+	int ret;
+
+	ret = tcv_lock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
+	if (tcv->fun->revalidate)
+		ret = tcv->fun->revalidate(tcv);
+	if (ret == 1) {
+		ret = tcv_init_locked(tcv);
+		if (!ret)
+			ret = 1;
+	}
+
+	tcv_unlock(tcv);
+	return ret;
+}
+
+/******************************************************************************/
+
+int tcv_refresh(tcv_t *tcv)
+{
+	int ret;
+
+	ret = tcv_lock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	if (tcv->fun->refresh)
+		ret = tcv->fun->refresh(tcv);
+
+	tcv_unlock(tcv);
+	return ret;
+}
+
+/******************************************************************************/
+
 int tcv_destroy(tcv_t *tcv)
 {
 	int ret = 0;
 
+	if (tcv_is_valid(tcv) && tcv->bus)
+		tcv_bus_detach(tcv);
+	if (tcv_is_valid(tcv) && tcv->eeprom_cache)
+		tcv_eeprom_cache_detach(tcv);
+	if (tcv_is_valid(tcv) && tcv->image_store)
+		tcv_image_store_detach(tcv);
+
 	if (!tcv_check_and_lock_ok(tcv))
 		return TCV_ERR_INVALID_ARG;
 
+	tcv_state_wrlock(tcv);
 	if (tcv->data) {
-		free(tcv->data);
-		tcv->data = NULL;
+		tcv_free_data(tcv);
 		tcv->created = false;
 	}
+	tcv_state_unlock(tcv);
+	tcv_write_pending_free(tcv);
+	tcv_static_publish(tcv, NULL);
+	tcv_static_reclaim(tcv);
 	tcv_unlock(tcv);
-	pthread_mutex_destroy(&tcv->lock);
+	pthread_mutex_destroy(&tcv->io_lock);
+	pthread_rwlock_destroy(&tcv->state_lock);
+	free(tcv->sync);
 	free(tcv);
 
 	return ret;
@@ -194,16 +961,17 @@ int tcv_destroy(tcv_t *tcv)
 
 int tcv_get_identifier(tcv_t *tcv)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (!tcv_is_valid(tcv))
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_identifier(tcv);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_identifier(st);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -211,16 +979,17 @@ int tcv_get_identifier(tcv_t *tcv)
 
 int tcv_get_ext_identifier(tcv_t *tcv)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (!tcv_is_valid(tcv))
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_ext_identifier(tcv);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_ext_identifier(st);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -228,16 +997,17 @@ int tcv_get_ext_identifier(tcv_t *tcv)
 
 int tcv_get_connector(tcv_t *tcv)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (!tcv_is_valid(tcv))
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_connector(tcv);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_connector(st);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -246,16 +1016,17 @@ int tcv_get_connector(tcv_t *tcv)
 int tcv_get_10g_compliance_codes(tcv_t *tcv,
                                  tcv_10g_eth_compliance_codes_t *codes)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv) || !codes)
+	if (!tcv_is_valid(tcv) || !codes)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_10g_compliance_codes(tcv, codes);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_10g_compliance_codes(st, codes);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -264,16 +1035,17 @@ int tcv_get_10g_compliance_codes(tcv_t *tcv,
 int tcv_get_infiniband_compliance_codes(
         tcv_t *tcv, tcv_infiniband_compliance_codes_t *codes)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv) || !codes)
+	if (!tcv_is_valid(tcv) || !codes)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_infiniband_compliance_codes(tcv, codes);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_infiniband_compliance_codes(st, codes);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -282,16 +1054,17 @@ int tcv_get_infiniband_compliance_codes(
 int tcv_get_escon_compliance_codes(tcv_t *tcv,
                                    tcv_escon_compliance_codes_t *codes)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv) || !codes)
+	if (!tcv_is_valid(tcv) || !codes)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_escon_compliance_codes(tcv, codes);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_escon_compliance_codes(st, codes);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -300,16 +1073,17 @@ int tcv_get_escon_compliance_codes(tcv_t *tcv,
 int tcv_get_sonet_compliance_codes(tcv_t *tcv,
                                    tcv_sonet_compliance_codes_t *codes)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv) || !codes)
+	if (!tcv_is_valid(tcv) || !codes)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_sonet_compliance_codes(tcv, codes);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_sonet_compliance_codes(st, codes);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -326,16 +1100,17 @@ int tcv_get_sonet_compliances(tcv_t *tcv, tcv_sonet_compliances_t *compliances)
 
 int tcv_get_eth_compliance_codes(tcv_t *tcv, tcv_eth_compliance_codes_t *codes)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv) || !codes)
+	if (!tcv_is_valid(tcv) || !codes)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_eth_compliance_codes(tcv, codes);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_eth_compliance_codes(st, codes);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -344,16 +1119,17 @@ int tcv_get_eth_compliance_codes(tcv_t *tcv, tcv_eth_compliance_codes_t *codes)
 int tcv_get_fibre_channel_link_length(tcv_t *tcv,
                                       tcv_fibre_channel_link_length_t *lengths)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv) || !lengths)
+	if (!tcv_is_valid(tcv) || !lengths)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_fibre_channel_link_length(tcv, lengths);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_fibre_channel_link_length(st, lengths);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -372,16 +1148,17 @@ int tcv_get_fibre_channel_technology(tcv_t *tcv,
 int tcv_get_sfp_plus_cable_technology(tcv_t *tcv,
                                       sfp_plus_cable_technology_t *technology)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv) || !technology)
+	if (!tcv_is_valid(tcv) || !technology)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_sfp_plus_cable_technology(tcv, technology);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_sfp_plus_cable_technology(st, technology);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -389,17 +1166,17 @@ int tcv_get_sfp_plus_cable_technology(tcv_t *tcv,
 
 int tcv_get_fibre_channel_media(tcv_t *tcv, tcv_fibre_channel_media_t *media)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv) || !media)
-		return TCV_ERR_INVALID_ARG;
-
-	ret = tcv_is_initialized(tcv);
-	if (ret) {
-		ret = tcv->fun->get_fibre_channel_media(tcv, media);
-	}
+	if (!tcv_is_valid(tcv) || !media)
+		return TCV_ERR_INVALID_ARG;
 
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_fibre_channel_media(st, media);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -407,16 +1184,17 @@ int tcv_get_fibre_channel_media(tcv_t *tcv, tcv_fibre_channel_media_t *media)
 
 int tcv_get_fibre_channel_speed(tcv_t *tcv, fibre_channel_speed_t *speed)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv) || !speed)
+	if (!tcv_is_valid(tcv) || !speed)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_fibre_channel_speed(tcv, speed);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_fibre_channel_speed(st, speed);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -424,17 +1202,17 @@ int tcv_get_fibre_channel_speed(tcv_t *tcv, fibre_channel_speed_t *speed)
 
 int tcv_get_encoding(tcv_t *tcv)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (!tcv_is_valid(tcv))
 		return TCV_ERR_INVALID_ARG;
 
-	ret = tcv_is_initialized(tcv);
-	if (ret) {
-		ret = tcv->fun->get_encoding(tcv);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_encoding(st);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -442,17 +1220,17 @@ int tcv_get_encoding(tcv_t *tcv)
 
 int tcv_get_nominal_bit_rate(tcv_t *tcv)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (!tcv_is_valid(tcv))
 		return TCV_ERR_INVALID_ARG;
 
-	ret = tcv_is_initialized(tcv);
-	if (ret) {
-		ret = tcv->fun->get_nominal_bit_rate(tcv);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_nominal_bit_rate(st);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -460,16 +1238,17 @@ int tcv_get_nominal_bit_rate(tcv_t *tcv)
 
 int tcv_get_rate_identifier(tcv_t *tcv)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (!tcv_is_valid(tcv))
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_rate_identifier(tcv);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_rate_identifier(st);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -477,16 +1256,17 @@ int tcv_get_rate_identifier(tcv_t *tcv)
 
 int tcv_get_sm_length(tcv_t *tcv)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (!tcv_is_valid(tcv))
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_sm_length(tcv);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_sm_length(st);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -494,16 +1274,17 @@ int tcv_get_sm_length(tcv_t *tcv)
 
 int tcv_get_om2_length(tcv_t *tcv)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (!tcv_is_valid(tcv))
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_om2_length(tcv);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_om2_length(st);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -511,16 +1292,17 @@ int tcv_get_om2_length(tcv_t *tcv)
 
 int tcv_get_om1_length(tcv_t *tcv)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (!tcv_is_valid(tcv))
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_om1_length(tcv);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_om1_length(st);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -528,16 +1310,17 @@ int tcv_get_om1_length(tcv_t *tcv)
 
 int tcv_get_om4_copper_length(tcv_t *tcv)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (!tcv_is_valid(tcv))
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_om4_copper_length(tcv);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_om4_copper_length(st);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -545,16 +1328,17 @@ int tcv_get_om4_copper_length(tcv_t *tcv)
 
 int tcv_get_om3_length(tcv_t *tcv)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (!tcv_is_valid(tcv))
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_om3_length(tcv);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_om3_length(st);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -562,15 +1346,17 @@ int tcv_get_om3_length(tcv_t *tcv)
 
 int tcv_get_vendor_name(tcv_t *tcv, char* vendor_name)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv) || !vendor_name)
+	if (!tcv_is_valid(tcv) || !vendor_name)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_vendor_name(tcv, vendor_name);
-	}
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_vendor_name(st, vendor_name);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -578,15 +1364,17 @@ int tcv_get_vendor_name(tcv_t *tcv, char* vendor_name)
 
 int tcv_get_vendor_oui(tcv_t *tcv)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (!tcv_is_valid(tcv))
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_vendor_oui(tcv);
-	}
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_vendor_oui(st);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -594,15 +1382,17 @@ int tcv_get_vendor_oui(tcv_t *tcv)
 
 int tcv_get_vendor_revision(tcv_t *tcv, char* rev)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv) || !rev)
+	if (!tcv_is_valid(tcv) || !rev)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_vendor_revision(tcv, rev);
-	}
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_vendor_revision(st, rev);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -610,15 +1400,17 @@ int tcv_get_vendor_revision(tcv_t *tcv, char* rev)
 
 int tcv_get_vendor_part_number(tcv_t *tcv, char* pn)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv) || !pn)
+	if (!tcv_is_valid(tcv) || !pn)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_vendor_part_number(tcv, pn);
-	}
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_vendor_part_number(st, pn);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -626,16 +1418,17 @@ int tcv_get_vendor_part_number(tcv_t *tcv, char* pn)
 
 int tcv_get_wavelength(tcv_t *tcv)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (!tcv_is_valid(tcv))
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_wave_len(tcv);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_wave_len(st);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -644,9 +1437,18 @@ int tcv_get_wavelength(tcv_t *tcv)
 int tcv_get_passive_cable_compliance(tcv_t *tcv,
                                      passive_cable_compliance_t *compliance)
 {
-	fprintf(stderr, "> %s - Error: generic function not implemented\n",
-	        __func__);
-	return TCV_ERR_FEATURE_NOT_AVAILABLE;
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_NOT_INITIALIZED;
+
+	if (!tcv_is_valid(tcv) || !compliance)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_passive_cable_compliance(st, compliance);
+	tcv_static_release(tcv, slot);
+	return ret;
 }
 
 /******************************************************************************/
@@ -654,9 +1456,18 @@ int tcv_get_passive_cable_compliance(tcv_t *tcv,
 int tcv_get_active_cable_compliance(tcv_t *tcv,
                                     active_cable_compliance_t *compliance)
 {
-	fprintf(stderr, "> %s - Error: generic function not implemented\n",
-	        __func__);
-	return TCV_ERR_FEATURE_NOT_AVAILABLE;
+	const struct tcv_static *st;
+	unsigned slot;
+	int ret = TCV_ERR_NOT_INITIALIZED;
+
+	if (!tcv_is_valid(tcv) || !compliance)
+		return TCV_ERR_INVALID_ARG;
+
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_active_cable_compliance(st, compliance);
+	tcv_static_release(tcv, slot);
+	return ret;
 }
 
 /******************************************************************************/
@@ -681,16 +1492,17 @@ int tcv_calculate_cc_base(tcv_t *tcv)
 
 int tcv_get_implemented_options(tcv_t *tcv, tcv_implemented_options_t *options)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv) || !options)
+	if (!tcv_is_valid(tcv) || !options)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_implemented_options(tcv, options);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_implemented_options(st, options);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -698,16 +1510,17 @@ int tcv_get_implemented_options(tcv_t *tcv, tcv_implemented_options_t *options)
 
 int tcv_get_max_bit_rate(tcv_t *tcv)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (!tcv_is_valid(tcv))
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_max_bit_rate(tcv);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_max_bit_rate(st);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -715,16 +1528,17 @@ int tcv_get_max_bit_rate(tcv_t *tcv)
 
 int tcv_get_min_bit_rate(tcv_t *tcv)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (!tcv_is_valid(tcv))
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_min_bit_rate(tcv);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_min_bit_rate(st);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -732,15 +1546,17 @@ int tcv_get_min_bit_rate(tcv_t *tcv)
 
 int tcv_get_vendor_sn(tcv_t *tcv, char* vendor_sn)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv) || !vendor_sn)
+	if (!tcv_is_valid(tcv) || !vendor_sn)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_vendor_serial_number(tcv, vendor_sn);
-	}
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_vendor_serial_number(st, vendor_sn);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -748,15 +1564,17 @@ int tcv_get_vendor_sn(tcv_t *tcv, char* vendor_sn)
 
 int tcv_get_vendor_date_code(tcv_t *tcv, tcv_date_code_t *date_code)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv) || !date_code)
+	if (!tcv_is_valid(tcv) || !date_code)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_vendor_date_code(tcv, date_code);
-	}
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_vendor_date_code(st, date_code);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -764,31 +1582,34 @@ int tcv_get_vendor_date_code(tcv_t *tcv, tcv_date_code_t *date_code)
 
 int tcv_get_diagnostic_type(tcv_t *tcv, tcv_diagnostic_type_t *diag_type)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv) || !diag_type)
+	if (!tcv_is_valid(tcv) || !diag_type)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_diagnostic_type(tcv, diag_type);
-	}
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_diagnostic_type(st, diag_type);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
 /******************************************************************************/
 int tcv_get_enhanced_options(tcv_t *tcv, tcv_enhanced_options_type_t *options)
 {
+	const struct tcv_static *st;
+	unsigned slot;
 	int ret = TCV_ERR_NOT_INITIALIZED;
 
-	if (!tcv_check_and_lock_ok(tcv) || !options)
+	if (!tcv_is_valid(tcv) || !options)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_enhanced_options(tcv, options);
-	}
-
-	tcv_unlock(tcv);
+	st = tcv_static_acquire(tcv, &slot);
+	if (st)
+		ret = st->fun->get_enhanced_options(st, options);
+	tcv_static_release(tcv, slot);
 	return ret;
 }
 
@@ -814,15 +1635,13 @@ int tcv_calculate_cc_ext(tcv_t *tcv)
 
 const uint8_t* tcv_get_vendor_rom(tcv_t *tcv)
 {
-	uint8_t* ret = NULL;
+	uint8_t* ret;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (tcv_lock_initialized(tcv))
 		return NULL ;
 
-	if (tcv_is_initialized(tcv)) {
-		/*cast away const to supress warning, we add const through return */
-		ret = (uint8_t*)tcv->fun->get_vendor_rom(tcv);
-	}
+	/*cast away const to supress warning, we add const through return */
+	ret = (uint8_t*)tcv->fun->get_vendor_rom(tcv);
 
 	tcv_unlock(tcv);
 	return ret;
@@ -832,16 +1651,14 @@ const uint8_t* tcv_get_vendor_rom(tcv_t *tcv)
 
 size_t tcv_get_vendor_rom_size(tcv_t *tcv)
 {
-	int ret = 0;
+	int ret;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (tcv_rdlock_initialized(tcv))
 		return 0;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_vendor_rom_size(tcv);
-	}
+	ret = tcv->fun->get_vendor_rom_size(tcv);
 
-	tcv_unlock(tcv);
+	tcv_state_unlock(tcv);
 	return ret;
 }
 
@@ -849,13 +1666,46 @@ size_t tcv_get_vendor_rom_size(tcv_t *tcv)
 
 const uint8_t* tcv_get_user_writable_eeprom(tcv_t *tcv)
 {
-	const uint8_t *ret = NULL;
+	const uint8_t *ret;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (tcv_lock_initialized(tcv))
 		return NULL ;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->get_user_writable_eeprom(tcv);
+	ret = tcv->fun->get_user_writable_eeprom(tcv);
+
+	tcv_unlock(tcv);
+	return ret;
+}
+
+/******************************************************************************/
+
+int tcv_copy_user_writable_eeprom(tcv_t *tcv, uint8_t *buf, size_t len)
+{
+	const uint8_t *eeprom;
+	size_t size;
+	int ret;
+
+	if (!buf)
+		return TCV_ERR_INVALID_ARG;
+
+	ret = tcv_lock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
+	if (tcv->fun->get_user_writable_eeprom &&
+	    tcv->fun->get_user_writable_eeprom_size) {
+		/* copied before anybody else can write to it */
+		eeprom = tcv->fun->get_user_writable_eeprom(tcv);
+		size = tcv->fun->get_user_writable_eeprom_size(tcv);
+		if (!eeprom) {
+			ret = TCV_ERR_GENERIC;
+		} else {
+			if (len > size)
+				len = size;
+			memcpy(buf, eeprom, len);
+			ret = len;
+		}
 	}
 
 	tcv_unlock(tcv);
@@ -868,13 +1718,13 @@ size_t tcv_get_user_writable_eeprom_size(tcv_t *tcv)
 {
 	int ret = 0;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (tcv_rdlock_initialized(tcv))
 		return 0;
 
 	if (tcv->fun->get_user_writable_eeprom_size)
 		ret = tcv->fun->get_user_writable_eeprom_size(tcv);
 
-	tcv_unlock(tcv);
+	tcv_state_unlock(tcv);
 	return ret;
 }
 
@@ -882,15 +1732,13 @@ size_t tcv_get_user_writable_eeprom_size(tcv_t *tcv)
 
 const uint8_t* tcv_get_8079_rom(tcv_t *tcv)
 {
-	uint8_t* ret = NULL;
+	uint8_t* ret;
 
-	if (!tcv_check_and_lock_ok(tcv))
+	if (tcv_lock_initialized(tcv))
 		return NULL ;
 
-	if (tcv_is_initialized(tcv)) {
-		/*cast away const to supress warning, we add const through return */
-		ret = (uint8_t*) tcv->fun->get_8079_rom(tcv);
-	}
+	/*cast away const to supress warning, we add const through return */
+	ret = (uint8_t*) tcv->fun->get_8079_rom(tcv);
 	tcv_unlock(tcv);
 	return ret;
 
@@ -900,14 +1748,16 @@ const uint8_t* tcv_get_8079_rom(tcv_t *tcv)
 
 int tcv_read(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr, uint8_t* data, size_t len)
 {
-	int ret = TCV_ERR_NOT_INITIALIZED;
+	int ret;
 
-	if (!tcv_check_and_lock_ok(tcv) || !data)
+	if (!data)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->raw_read(tcv, devaddr, regaddr, data, len);
-	}
+	ret = tcv_lock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = tcv->fun->raw_read(tcv, devaddr, regaddr, data, len);
 
 	tcv_unlock(tcv);
 	return ret;
@@ -917,14 +1767,58 @@ int tcv_read(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr, uint8_t* data, size_t
 
 int tcv_write(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr, const uint8_t* data, size_t len)
 {
-	int ret = TCV_ERR_NOT_INITIALIZED;
+	int ret;
 
-	if (!tcv_check_and_lock_ok(tcv) || !data)
+	if (!data)
 		return TCV_ERR_INVALID_ARG;
 
-	if (tcv_is_initialized(tcv)) {
-		ret = tcv->fun->raw_write(tcv, devaddr, regaddr, data, len);
-	}
+	ret = tcv_lock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = tcv->fun->raw_write(tcv, devaddr, regaddr, data, len);
+
+	tcv_unlock(tcv);
+	return ret;
+}
+
+/******************************************************************************/
+
+int tcv_read_paged(tcv_t *tcv, uint8_t page, uint8_t regaddr, uint8_t* data, size_t len)
+{
+	int ret;
+
+	if (!data)
+		return TCV_ERR_INVALID_ARG;
+
+	ret = tcv_lock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
+	if (tcv->fun->read_paged)
+		ret = tcv->fun->read_paged(tcv, page, regaddr, data, len);
+
+	tcv_unlock(tcv);
+	return ret;
+}
+
+/******************************************************************************/
+
+int tcv_write_paged(tcv_t *tcv, uint8_t page, uint8_t regaddr, const uint8_t* data, size_t len)
+{
+	int ret;
+
+	if (!data)
+		return TCV_ERR_INVALID_ARG;
+
+	ret = tcv_lock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
+	if (tcv->fun->write_paged)
+		ret = tcv->fun->write_paged(tcv, page, regaddr, data, len);
 
 	tcv_unlock(tcv);
 	return ret;
@@ -934,11 +1828,16 @@ int tcv_write(tcv_t *tcv, uint8_t devaddr, uint8_t regaddr, const uint8_t* data,
 int tcv_get_temperature(tcv_t* tcv, int16_t* temp)
 {
 	/* Not all have Digital diagnostics */
-	int ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
+	int ret;
 
-	if (!tcv_check_and_lock_ok(tcv) || !temp)
+	if (!temp)
 		return TCV_ERR_INVALID_ARG;
 
+	ret = tcv_lock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
 	if (tcv->fun->get_temp)
 		ret = tcv->fun->get_temp(tcv, temp);
 
@@ -950,11 +1849,16 @@ int tcv_get_temperature(tcv_t* tcv, int16_t* temp)
 int tcv_get_voltage(tcv_t* tcv, uint16_t* vcc)
 {
 	/* Not all have Digital diagnostics */
-	int ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
+	int ret;
 
-	if (!tcv_check_and_lock_ok(tcv) || !vcc)
+	if (!vcc)
 		return TCV_ERR_INVALID_ARG;
 
+	ret = tcv_lock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
 	if (tcv->fun->get_voltage)
 		ret = tcv->fun->get_voltage(tcv, vcc);
 
@@ -967,11 +1871,16 @@ int tcv_get_voltage(tcv_t* tcv, uint16_t* vcc)
 int tcv_get_tx_cur(tcv_t* tcv, uint16_t* cur)
 {
 	/* Not all have Digital diagnostics */
-	int ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
+	int ret;
 
-	if (!tcv_check_and_lock_ok(tcv) || !cur)
+	if (!cur)
 		return TCV_ERR_INVALID_ARG;
 
+	ret = tcv_lock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
 	if (tcv->fun->get_tx_cur)
 		ret = tcv->fun->get_tx_cur(tcv, cur);
 
@@ -983,11 +1892,16 @@ int tcv_get_tx_cur(tcv_t* tcv, uint16_t* cur)
 int tcv_get_rx_pwr(tcv_t* tcv, uint16_t* pwr)
 {
 	/* Not all have Digital diagnostics */
-	int ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
+	int ret;
 
-	if (!tcv_check_and_lock_ok(tcv) || !pwr)
+	if (!pwr)
 		return TCV_ERR_INVALID_ARG;
 
+	ret = tcv_lock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
 	if (tcv->fun->get_rx_pwr)
 		ret = tcv->fun->get_rx_pwr(tcv, pwr);
 
@@ -999,11 +1913,16 @@ int tcv_get_rx_pwr(tcv_t* tcv, uint16_t* pwr)
 int tcv_get_tx_pwr(tcv_t* tcv, uint16_t* pwr)
 {
 	/* Not all have Digital diagnostics */
-	int ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
+	int ret;
 
-	if (!tcv_check_and_lock_ok(tcv) || !pwr)
+	if (!pwr)
 		return TCV_ERR_INVALID_ARG;
 
+	ret = tcv_lock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
 	if (tcv->fun->get_tx_pwr)
 		ret = tcv->fun->get_tx_pwr(tcv, pwr);
 
@@ -1015,11 +1934,16 @@ int tcv_get_tx_pwr(tcv_t* tcv, uint16_t* pwr)
 int tcv_get_temp_warning(tcv_t* tcv, uint16_t* threshold)
 {
 	/* Not all have Digital diagnostics */
-	int ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
+	int ret;
 
-	if (!tcv_check_and_lock_ok(tcv) || !threshold)
+	if (!threshold)
 		return TCV_ERR_INVALID_ARG;
 
+	ret = tcv_lock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
 	if (tcv->fun->get_temp_high_warning)
 		ret = tcv->fun->get_temp_high_warning(tcv, threshold);
 
@@ -1031,11 +1955,16 @@ int tcv_get_temp_warning(tcv_t* tcv, uint16_t* threshold)
 int tcv_get_rx_pwr_warning(tcv_t* tcv, uint16_t* threshold)
 {
 	/* Not all have Digital diagnostics */
-	int ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
+	int ret;
 
-	if (!tcv_check_and_lock_ok(tcv) || !threshold)
+	if (!threshold)
 		return TCV_ERR_INVALID_ARG;
 
+	ret = tcv_lock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
 	if (tcv->fun->get_rx_pwr_high_warning)
 		ret = tcv->fun->get_rx_pwr_high_warning(tcv, threshold);
 
@@ -1047,14 +1976,170 @@ int tcv_get_rx_pwr_warning(tcv_t* tcv, uint16_t* threshold)
 int tcv_get_tx_pwr_warning(tcv_t* tcv, uint16_t* threshold)
 {
 	/* Not all have Digital diagnostics */
-	int ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
+	int ret;
 
-	if (!tcv_check_and_lock_ok(tcv) || !threshold)
+	if (!threshold)
 		return TCV_ERR_INVALID_ARG;
 
+	ret = tcv_lock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
 	if (tcv->fun->get_tx_pwr_high_warning)
 		ret = tcv->fun->get_tx_pwr_high_warning(tcv, threshold);
 
 	tcv_unlock(tcv);
 	return ret;
 }
+
+/******************************************************************************/
+int tcv_get_dd_snapshot(tcv_t* tcv, tcv_dd_snapshot_t* snapshot)
+{
+	/* Not all have Digital diagnostics */
+	int ret;
+
+	if (!snapshot)
+		return TCV_ERR_INVALID_ARG;
+
+	ret = tcv_lock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
+	if (tcv->fun->get_dd_snapshot)
+		ret = tcv->fun->get_dd_snapshot(tcv, snapshot);
+
+	tcv_unlock(tcv);
+	return ret;
+}
+
+/******************************************************************************/
+int tcv_set_dd_cache(tcv_t *tcv, uint32_t max_age_ms)
+{
+	if (!tcv_check_and_lock_ok(tcv))
+		return TCV_ERR_INVALID_ARG;
+
+	tcv->dd_max_age_ns = (uint64_t) max_age_ms * 1000000ULL;
+	tcv_unlock(tcv);
+	return 0;
+}
+
+/******************************************************************************/
+int tcv_get_dd_cache_stats(tcv_t *tcv, tcv_dd_cache_stats_t *stats)
+{
+	int ret;
+
+	if (!stats)
+		return TCV_ERR_INVALID_ARG;
+
+	ret = tcv_rdlock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
+	if (tcv->fun->get_dd_cache_stats)
+		ret = tcv->fun->get_dd_cache_stats(tcv, stats);
+
+	tcv_state_unlock(tcv);
+	return ret;
+}
+
+/******************************************************************************/
+int tcv_set_read_ahead(tcv_t *tcv, tcv_read_ahead_t mode, uint32_t window_ms)
+{
+	if (mode != TCV_READ_AHEAD_OFF && mode != TCV_READ_AHEAD_ON &&
+	    mode != TCV_READ_AHEAD_AUTO)
+		return TCV_ERR_INVALID_ARG;
+
+	if (mode != TCV_READ_AHEAD_OFF && !window_ms)
+		return TCV_ERR_INVALID_ARG;
+
+	if (!tcv_check_and_lock_ok(tcv))
+		return TCV_ERR_INVALID_ARG;
+
+	tcv->read_ahead = mode;
+	tcv->read_ahead_window_ns = (uint64_t) window_ms * 1000000ULL;
+	tcv_unlock(tcv);
+	return 0;
+}
+
+/******************************************************************************/
+int tcv_get_read_ahead_stats(tcv_t *tcv, tcv_read_ahead_stats_t *stats)
+{
+	int ret;
+
+	if (!stats)
+		return TCV_ERR_INVALID_ARG;
+
+	ret = tcv_rdlock_initialized(tcv);
+	if (ret < 0)
+		return ret;
+
+	ret = TCV_ERR_FEATURE_NOT_AVAILABLE;
+	if (tcv->fun->get_read_ahead_stats)
+		ret = tcv->fun->get_read_ahead_stats(tcv, stats);
+
+	tcv_state_unlock(tcv);
+	return ret;
+}
+
+/******************************************************************************/
+/**
+ * \brief Copy the counters of one lock
+ */
+static void tcv_lock_stats_copy(struct tcv_lock_counters *c, tcv_lock_stats_t *stats)
+{
+	stats->acquired = atomic_load_explicit(&c->acquired, memory_order_relaxed);
+	stats->contended = atomic_load_explicit(&c->contended, memory_order_relaxed);
+	stats->wait_ns = atomic_load_explicit(&c->wait_ns, memory_order_relaxed);
+}
+
+/******************************************************************************/
+int tcv_get_lock_stats(tcv_t *tcv, tcv_lock_stats_t *io, tcv_lock_stats_t *state)
+{
+	if (!tcv_is_valid(tcv))
+		return TCV_ERR_INVALID_ARG;
+
+	if (io)
+		tcv_lock_stats_copy(&tcv->sync->io, io);
+	if (state)
+		tcv_lock_stats_copy(&tcv->sync->state, state);
+	return 0;
+}
+
+/******************************************************************************/
+#ifdef TCV_LOCK_DEBUG
+/**
+ * \brief Copy the histograms of one lock
+ */
+static void tcv_lock_hist_copy(struct tcv_lock_counters *c, tcv_lock_hist_t *hist)
+{
+	struct tcv_lock_debug *d = &c->debug;
+	unsigned int i;
+
+	for (i = 0; i < TCV_LOCK_HIST_BUCKETS; i++) {
+		hist->wait[i] = atomic_load_explicit(&d->wait[i], memory_order_relaxed);
+		hist->hold[i] = atomic_load_explicit(&d->hold[i], memory_order_relaxed);
+	}
+	hist->max_wait_ns = atomic_load_explicit(&d->max_wait_ns, memory_order_relaxed);
+	hist->max_hold_ns = atomic_load_explicit(&d->max_hold_ns, memory_order_relaxed);
+}
+#endif
+
+/******************************************************************************/
+int tcv_get_lock_histograms(tcv_t *tcv, tcv_lock_hist_t *io, tcv_lock_hist_t *state)
+{
+	if (!tcv_is_valid(tcv))
+		return TCV_ERR_INVALID_ARG;
+
+#ifdef TCV_LOCK_DEBUG
+	if (io)
+		tcv_lock_hist_copy(&tcv->sync->io, io);
+	if (state)
+		tcv_lock_hist_copy(&tcv->sync->state, state);
+	return 0;
+#else
+	return TCV_ERR_FEATURE_NOT_AVAILABLE;
+#endif
+}
@@ -0,0 +1,577 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Test asynchronous request queues with a transport completing on demand
+ */
+
+#include <memory>
+#include <vector>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+#include <poll.h>
+
+extern "C"{
+#include "libtcv/tcv.h"
+#include "libtcv/async.h"
+#include "libtcv/bus.h"
+}
+#include "gtest/gtest.h"
+#include "fake_hw.hpp"
+#include "fake_tcv.hpp"
+
+using namespace std;
+using namespace TestDoubles;
+
+namespace {
+
+/** Transfer started by the fake transport, completed by the test */
+struct Transfer {
+	FakeTCV *dev;
+	tcv_aio_req_t *req;
+	uint8_t devaddr;
+	uint8_t regaddr;
+	uint8_t *data;
+	size_t len;
+};
+
+deque<Transfer> started;
+bool complete_inline;	// complete from within submit_read()
+int start_error;		// returned by submit_read() if set
+
+int fake_submit_read(void *ctx, tcv_aio_req_t *req, uint8_t devaddr,
+		uint8_t regaddr, uint8_t *data, size_t len)
+{
+	auto dev = static_cast<FakeTCV*>(ctx);
+
+	if (start_error)
+		return start_error;
+
+	dev->count_transaction();
+	if (complete_inline) {
+		dev->read(static_cast<tcv_dev_addr_t>(devaddr), regaddr, data, len);
+		tcv_aio_complete(req, 0);
+		return 0;
+	}
+	started.push_back({ dev, req, devaddr, regaddr, data, len });
+	return 0;
+}
+
+/** finish the oldest transfer */
+void complete_one(int status = 0)
+{
+	Transfer t = started.front();
+	started.pop_front();
+	if (status == 0)
+		t.dev->read(static_cast<tcv_dev_addr_t>(t.devaddr), t.regaddr, t.data, t.len);
+	tcv_aio_complete(t.req, status);
+}
+
+const tcv_aio_ops_t fake_ops = { fake_submit_read };
+
+/** Completion record */
+struct Done {
+	tcv_t *tcv;
+	int status;
+	int tag;
+};
+
+vector<Done> done;
+
+void record(tcv_t *tcv, int status, void *arg)
+{
+	done.push_back({ tcv, status, static_cast<int>(reinterpret_cast<intptr_t>(arg)) });
+}
+
+void *tag(int t)
+{
+	return reinterpret_cast<void *>(static_cast<intptr_t>(t));
+}
+
+}
+
+class TestAsync : public ::testing::Test {
+	public:
+	TestAsync()
+	{
+		add_tcv(1, make_shared<FakeSFP>(1, i2c_read, i2c_write));
+		mtcv = get_tcv(1);
+		tcv = tcv_create_ex(1, mtcv.get(), i2c_read_ctx, i2c_write_ctx);
+		q = tcv_queue_create(&fake_ops);
+		started.clear();
+		done.clear();
+		complete_inline = false;
+		start_error = 0;
+	}
+
+	~TestAsync()
+	{
+		tcv_destroy(tcv);
+		tcv_queue_destroy(q);
+		clear_tcvs();
+	}
+
+	shared_ptr<FakeTCV> mtcv;
+	tcv_t *tcv;
+	tcv_queue_t *q;
+};
+
+TEST_F(TestAsync, submitChecks)
+{
+	uint8_t buf[4];
+	tcv_t *legacy = mtcv->get_ctcv();
+
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_set_queue(legacy, q));
+	EXPECT_EQ(0, tcv_set_queue(tcv, q));
+	EXPECT_EQ(TCV_ERR_NOT_INITIALIZED, tcv_submit_read(tcv, 0x50, 0, buf, 4, record, NULL));
+	ASSERT_EQ(0, tcv_init(tcv));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_submit_read(tcv, 0x50, 0, buf, 4, NULL, NULL));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_submit_read(tcv, 0x50, 254, buf, 4, record, NULL));
+	EXPECT_EQ(0, tcv_set_queue(tcv, NULL));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_submit_read(tcv, 0x50, 0, buf, 4, record, NULL));
+	EXPECT_TRUE(done.empty());
+}
+
+TEST_F(TestAsync, fifoOneInFlight)
+{
+	uint8_t a[4], b[4], c[16];
+	string name = "Async Vendor    ";
+
+	mtcv->manip_eeprom(20, name);
+	ASSERT_EQ(0, tcv_init(tcv));
+	ASSERT_EQ(0, tcv_set_queue(tcv, q));
+
+	EXPECT_EQ(0, tcv_submit_read(tcv, 0x50, 0, a, sizeof(a), record, tag(1)));
+	EXPECT_EQ(0, tcv_submit_read(tcv, 0x50, 4, b, sizeof(b), record, tag(2)));
+	EXPECT_EQ(0, tcv_submit_read(tcv, 0x50, 20, c, sizeof(c), record, tag(3)));
+	EXPECT_EQ(3u, tcv_queue_pending(q));
+	/* the bus is busy with the first one */
+	EXPECT_EQ(1u, started.size());
+	EXPECT_EQ(TCV_ERR_BUSY, tcv_queue_destroy(q));
+
+	while (!started.empty())
+		complete_one();
+
+	ASSERT_EQ(3u, done.size());
+	for (int i = 0; i < 3; i++) {
+		EXPECT_EQ(tcv, done[i].tcv);
+		EXPECT_EQ(0, done[i].status);
+		EXPECT_EQ(i + 1, done[i].tag);
+	}
+	EXPECT_EQ(TCV_TYPE_SFP, a[0]);
+	EXPECT_EQ(0, memcmp(c, name.c_str(), sizeof(c)));
+	EXPECT_EQ(0u, tcv_queue_pending(q));
+}
+
+TEST_F(TestAsync, chunkedByTransportCaps)
+{
+	uint8_t buf[40];
+	tcv_transport_caps_t caps = { 16, 0, 1 };
+
+	ASSERT_EQ(0, tcv_init(tcv));
+	ASSERT_EQ(0, tcv_set_transport_caps(tcv, &caps));
+	ASSERT_EQ(0, tcv_set_queue(tcv, q));
+
+	mtcv->reset_transactions();
+	EXPECT_EQ(0, tcv_submit_read(tcv, 0x50, 0, buf, sizeof(buf), record, NULL));
+	while (!started.empty()) {
+		EXPECT_GE(16u, started.front().len);
+		complete_one();
+	}
+	EXPECT_EQ(3u, mtcv->get_transactions());
+	ASSERT_EQ(1u, done.size());
+	EXPECT_EQ(0, done[0].status);
+}
+
+TEST_F(TestAsync, inlineCompletion)
+{
+	uint8_t buf[100][2];
+
+	ASSERT_EQ(0, tcv_init(tcv));
+	ASSERT_EQ(0, tcv_set_queue(tcv, q));
+	complete_inline = true;
+
+	for (int i = 0; i < 100; i++)
+		EXPECT_EQ(0, tcv_submit_read(tcv, 0x51, 96, buf[i], 2, record, tag(i)));
+
+	ASSERT_EQ(100u, done.size());
+	EXPECT_EQ(99, done[99].tag);
+	EXPECT_EQ(0u, tcv_queue_pending(q));
+}
+
+TEST_F(TestAsync, errorsReachCallback)
+{
+	uint8_t buf[4];
+
+	ASSERT_EQ(0, tcv_init(tcv));
+	ASSERT_EQ(0, tcv_set_queue(tcv, q));
+
+	EXPECT_EQ(0, tcv_submit_read(tcv, 0x50, 0, buf, 4, record, tag(1)));
+	start_error = TCV_ERR_GENERIC;
+	EXPECT_EQ(0, tcv_submit_read(tcv, 0x50, 0, buf, 4, record, tag(2)));
+	complete_one(TCV_ERR_GENERIC);
+
+	ASSERT_EQ(2u, done.size());
+	EXPECT_EQ(TCV_ERR_GENERIC, done[0].status);
+	EXPECT_EQ(TCV_ERR_GENERIC, done[1].status);
+	EXPECT_EQ(2, done[1].tag);
+}
+
+TEST_F(TestAsync, destroyWhileBusy)
+{
+	uint8_t buf[4];
+
+	ASSERT_EQ(0, tcv_init(tcv));
+	ASSERT_EQ(0, tcv_set_queue(tcv, q));
+
+	EXPECT_EQ(0, tcv_submit_read(tcv, 0x50, 0, buf, 4, record, tag(1)));
+	EXPECT_EQ(0, tcv_submit_read(tcv, 0x50, 0, buf, 4, record, tag(2)));
+	EXPECT_EQ(TCV_ERR_BUSY, tcv_queue_destroy(q));
+	complete_one();
+	EXPECT_EQ(TCV_ERR_BUSY, tcv_queue_destroy(q));
+	complete_one();
+	EXPECT_EQ(2u, done.size());
+
+	EXPECT_EQ(0, tcv_set_queue(tcv, NULL));
+	EXPECT_EQ(0, tcv_queue_destroy(q));
+	q = tcv_queue_create(&fake_ops);
+}
+
+TEST_F(TestAsync, blockingCallWhileBusHeld)
+{
+	uint8_t a[4], b[4];
+	tcv_bus_t *bus = tcv_bus_create(NULL, NULL);
+
+	add_tcv(2, make_shared<FakeSFP>(2, i2c_read, i2c_write));
+	tcv_t *other = tcv_create_ex(2, get_tcv(2).get(), i2c_read_ctx, i2c_write_ctx);
+	ASSERT_EQ(0, tcv_init(tcv));
+	ASSERT_EQ(0, tcv_init(other));
+	ASSERT_EQ(0, tcv_bus_attach(bus, tcv, TCV_BUS_NO_MUX));
+	ASSERT_EQ(0, tcv_bus_attach(bus, other, TCV_BUS_NO_MUX));
+	ASSERT_EQ(0, tcv_set_queue(tcv, q));
+
+	EXPECT_EQ(0, tcv_submit_read(tcv, 0x50, 0, a, sizeof(a), record, NULL));
+	ASSERT_EQ(1u, started.size());
+	/* only this thread can complete the request, waiting would hang */
+	EXPECT_EQ(TCV_ERR_BUSY, tcv_read(other, 0x50, 0, b, sizeof(b)));
+	complete_one();
+	ASSERT_EQ(1u, done.size());
+	EXPECT_EQ(int(sizeof(b)), tcv_read(other, 0x50, 0, b, sizeof(b)));
+	EXPECT_EQ(TCV_TYPE_SFP, b[0]);
+
+	EXPECT_EQ(0, tcv_set_queue(tcv, NULL));
+	tcv_destroy(other);
+	EXPECT_EQ(0, tcv_bus_detach(tcv));
+	EXPECT_EQ(0, tcv_bus_destroy(bus));
+}
+
+TEST_F(TestAsync, otherThreadWaitsForBus)
+{
+	uint8_t a[4], b[4];
+	tcv_bus_t *bus = tcv_bus_create(NULL, NULL);
+	atomic<bool> read_done(false);
+
+	add_tcv(2, make_shared<FakeSFP>(2, i2c_read, i2c_write));
+	tcv_t *other = tcv_create_ex(2, get_tcv(2).get(), i2c_read_ctx, i2c_write_ctx);
+	ASSERT_EQ(0, tcv_init(tcv));
+	ASSERT_EQ(0, tcv_init(other));
+	ASSERT_EQ(0, tcv_bus_attach(bus, tcv, TCV_BUS_NO_MUX));
+	ASSERT_EQ(0, tcv_bus_attach(bus, other, TCV_BUS_NO_MUX));
+	ASSERT_EQ(0, tcv_set_queue(tcv, q));
+
+	EXPECT_EQ(0, tcv_submit_read(tcv, 0x50, 0, a, sizeof(a), record, NULL));
+	ASSERT_EQ(1u, started.size());
+	/* this thread completes the request, others just wait for it */
+	thread reader([&] {
+		EXPECT_EQ(int(sizeof(b)), tcv_read(other, 0x50, 0, b, sizeof(b)));
+		read_done = true;
+	});
+	this_thread::sleep_for(chrono::milliseconds(20));
+	EXPECT_FALSE(read_done);
+	complete_one();
+	reader.join();
+	ASSERT_EQ(1u, done.size());
+	EXPECT_EQ(TCV_TYPE_SFP, b[0]);
+
+	EXPECT_EQ(0, tcv_set_queue(tcv, NULL));
+	tcv_destroy(other);
+	EXPECT_EQ(0, tcv_bus_detach(tcv));
+	EXPECT_EQ(0, tcv_bus_destroy(bus));
+}
+
+TEST_F(TestAsync, queuesShareBus)
+{
+	uint8_t a[4], b[4];
+	tcv_bus_t *bus = tcv_bus_create(NULL, NULL);
+	tcv_queue_t *q2 = tcv_queue_create(&fake_ops);
+
+	add_tcv(2, make_shared<FakeSFP>(2, i2c_read, i2c_write));
+	tcv_t *other = tcv_create_ex(2, get_tcv(2).get(), i2c_read_ctx, i2c_write_ctx);
+	ASSERT_EQ(0, tcv_init(tcv));
+	ASSERT_EQ(0, tcv_init(other));
+	ASSERT_EQ(0, tcv_bus_attach(bus, tcv, TCV_BUS_NO_MUX));
+	ASSERT_EQ(0, tcv_bus_attach(bus, other, TCV_BUS_NO_MUX));
+	ASSERT_EQ(0, tcv_set_queue(tcv, q));
+	ASSERT_EQ(0, tcv_set_queue(other, q2));
+
+	EXPECT_EQ(0, tcv_submit_read(tcv, 0x50, 0, a, sizeof(a), record, tag(1)));
+	EXPECT_EQ(0, tcv_submit_read(other, 0x50, 0, b, sizeof(b), record, tag(2)));
+	/* the second one waits for the bus */
+	ASSERT_EQ(1u, started.size());
+	EXPECT_EQ(1u, tcv_queue_pending(q2));
+	complete_one();
+	ASSERT_EQ(1u, started.size());
+	complete_one();
+	ASSERT_EQ(2u, done.size());
+	EXPECT_EQ(1, done[0].tag);
+	EXPECT_EQ(2, done[1].tag);
+	EXPECT_EQ(0u, tcv_queue_pending(q2));
+
+	/* a waiting queue can go away */
+	EXPECT_EQ(0, tcv_submit_read(tcv, 0x50, 0, a, sizeof(a), record, tag(3)));
+	EXPECT_EQ(0, tcv_submit_read(other, 0x50, 0, b, sizeof(b), record, tag(4)));
+	EXPECT_EQ(0, tcv_set_queue(other, NULL));
+	EXPECT_EQ(0, tcv_queue_destroy(q2));
+	complete_one();
+	EXPECT_TRUE(started.empty());
+	ASSERT_EQ(4u, done.size());
+	EXPECT_EQ(4, done[2].tag);
+	EXPECT_EQ(TCV_ERR_CANCELED, done[2].status);
+	EXPECT_EQ(0, done[3].status);
+
+	EXPECT_EQ(0, tcv_set_queue(tcv, NULL));
+	tcv_destroy(other);
+	EXPECT_EQ(0, tcv_bus_detach(tcv));
+	EXPECT_EQ(0, tcv_bus_destroy(bus));
+}
+
+namespace {
+
+bool gate_armed;	// the next gated_read() holds the bus
+promise<void> gate_entered;
+shared_future<void> gate_open;
+
+/** read holding the bus until the test opens the gate once armed */
+int gated_read(void *ctx, uint8_t devaddr, uint8_t regaddr, uint8_t *data,
+		size_t len)
+{
+	if (gate_armed) {
+		gate_armed = false;
+		gate_entered.set_value();
+		gate_open.wait();
+	}
+	return i2c_read_ctx(ctx, devaddr, regaddr, data, len);
+}
+
+}
+
+TEST_F(TestAsync, startsAfterBlockingCall)
+{
+	uint8_t a[4], b[4];
+	tcv_bus_t *bus = tcv_bus_create(NULL, NULL);
+	promise<void> open;
+
+	add_tcv(2, make_shared<FakeSFP>(2, i2c_read, i2c_write));
+	tcv_t *other = tcv_create_ex(2, get_tcv(2).get(), gated_read, i2c_write_ctx);
+	gate_armed = false;
+	ASSERT_EQ(0, tcv_init(tcv));
+	ASSERT_EQ(0, tcv_init(other));
+	ASSERT_EQ(0, tcv_bus_attach(bus, tcv, TCV_BUS_NO_MUX));
+	ASSERT_EQ(0, tcv_bus_attach(bus, other, TCV_BUS_NO_MUX));
+	ASSERT_EQ(0, tcv_set_queue(tcv, q));
+
+	gate_entered = promise<void>();
+	gate_open = open.get_future().share();
+	gate_armed = true;
+	thread reader([&] {
+		EXPECT_EQ(int(sizeof(b)), tcv_read(other, 0x50, 0, b, sizeof(b)));
+	});
+	gate_entered.get_future().wait();
+
+	EXPECT_EQ(0, tcv_submit_read(tcv, 0x50, 0, a, sizeof(a), record, NULL));
+	EXPECT_TRUE(started.empty());
+	open.set_value();
+	reader.join();
+	/* the blocking call started the request on its way out */
+	ASSERT_EQ(1u, started.size());
+	complete_one();
+	ASSERT_EQ(1u, done.size());
+	EXPECT_EQ(0, done[0].status);
+
+	EXPECT_EQ(0, tcv_set_queue(tcv, NULL));
+	tcv_destroy(other);
+	EXPECT_EQ(0, tcv_bus_detach(tcv));
+	EXPECT_EQ(0, tcv_bus_destroy(bus));
+}
+
+TEST_F(TestAsync, ddSnapshotExternalCalib)
+{
+	tcv_dd_snapshot_t snap, sync_snap;
+
+	mtcv->manip_eeprom(92, 0x50); // Externally calibrated
+	mtcv->manip_dd(56, 0.0f);
+	mtcv->manip_dd(60, 0.0f);
+	mtcv->manip_dd(64, 0.0f);
+	mtcv->manip_dd(68, 0.222775f);
+	mtcv->manip_dd(72, -3.787173f);
+	mtcv->manip_dd(76, int16_t(0x0108));
+	mtcv->manip_dd(78, int16_t(1000));
+	mtcv->manip_dd(80, int16_t(0x0102));
+	mtcv->manip_dd(82, int16_t(-235));
+	mtcv->manip_dd(84, int16_t(272));
+	mtcv->manip_dd(86, int16_t(32));
+	mtcv->manip_dd(88, int16_t(0x0401));
+	mtcv->manip_dd(90, int16_t(2125));
+	mtcv->manip_dd(96, int16_t(12416));
+	mtcv->manip_dd(98, int16_t(3300));
+	mtcv->manip_dd(100, int16_t(3210));
+	mtcv->manip_dd(102, int16_t(17543));
+	mtcv->manip_dd(104, uint16_t(16224));
+	ASSERT_EQ(0, tcv_init(tcv));
+	ASSERT_EQ(0, tcv_set_queue(tcv, q));
+
+	mtcv->reset_transactions();
+	EXPECT_EQ(0, tcv_submit_dd_snapshot(tcv, &snap, record, NULL));
+	ASSERT_EQ(1u, started.size());
+	complete_one();
+	EXPECT_EQ(1u, mtcv->get_transactions());
+	ASSERT_EQ(1u, done.size());
+	EXPECT_EQ(0, done[0].status);
+
+	EXPECT_EQ(0, tcv_get_dd_snapshot(tcv, &sync_snap));
+	EXPECT_EQ(sync_snap.temp, snap.temp);
+	EXPECT_EQ(sync_snap.vcc, snap.vcc);
+	EXPECT_EQ(sync_snap.tx_cur, snap.tx_cur);
+	EXPECT_EQ(sync_snap.tx_pwr, snap.tx_pwr);
+	EXPECT_EQ(sync_snap.rx_pwr, snap.rx_pwr);
+	EXPECT_NE(0u, snap.timestamp);
+}
+
+TEST_F(TestAsync, ddSnapshotNotPresent)
+{
+	tcv_dd_snapshot_t snap;
+
+	mtcv->manip_eeprom(92, 0x00);
+	ASSERT_EQ(0, tcv_init(tcv));
+	ASSERT_EQ(0, tcv_set_queue(tcv, q));
+	EXPECT_EQ(TCV_ERR_DIAGNOSTICS_INFO_NOT_PRESENT,
+			tcv_submit_dd_snapshot(tcv, &snap, record, NULL));
+	EXPECT_TRUE(started.empty());
+}
+
+namespace {
+
+bool readable(int fd)
+{
+	struct pollfd pfd = { fd, POLLIN, 0 };
+	return poll(&pfd, 1, 0) == 1;
+}
+
+}
+
+TEST_F(TestAsync, loopDefersCompletion)
+{
+	uint8_t a[2], b[2];
+	tcv_loop_t *loop = tcv_loop_create();
+	ASSERT_NE(nullptr, loop);
+	int fd = tcv_loop_get_fd(loop);
+	ASSERT_LE(0, fd);
+
+	ASSERT_EQ(0, tcv_init(tcv));
+	ASSERT_EQ(0, tcv_set_queue(tcv, q));
+	ASSERT_EQ(0, tcv_queue_set_loop(q, loop));
+	EXPECT_FALSE(readable(fd));
+
+	EXPECT_EQ(0, tcv_submit_read(tcv, 0x51, 96, a, 2, record, tag(1)));
+	EXPECT_EQ(0, tcv_submit_read(tcv, 0x51, 98, b, 2, record, tag(2)));
+	EXPECT_EQ(TCV_ERR_BUSY, tcv_queue_set_loop(q, NULL));
+	complete_one();
+	/* bus moves on, callback waits for the loop */
+	EXPECT_EQ(1u, started.size());
+	EXPECT_TRUE(done.empty());
+	EXPECT_TRUE(readable(fd));
+
+	EXPECT_EQ(1, tcv_loop_step(loop));
+	ASSERT_EQ(1u, done.size());
+	EXPECT_EQ(1, done[0].tag);
+	EXPECT_FALSE(readable(fd));
+
+	complete_one();
+	EXPECT_EQ(1, tcv_loop_step(loop));
+	EXPECT_EQ(2u, done.size());
+	EXPECT_EQ(0, tcv_loop_step(loop));
+
+	EXPECT_EQ(TCV_ERR_BUSY, tcv_loop_destroy(loop));
+	EXPECT_EQ(0, tcv_queue_set_loop(q, NULL));
+	EXPECT_EQ(0, tcv_loop_destroy(loop));
+}
+
+TEST_F(TestAsync, loopRunsQueueWithoutTransport)
+{
+	uint8_t id;
+	tcv_dd_snapshot_t snap;
+	tcv_queue_t *sync_q = tcv_queue_create(NULL);
+	tcv_loop_t *loop = tcv_loop_create();
+	ASSERT_NE(nullptr, sync_q);
+	ASSERT_NE(nullptr, loop);
+	int fd = tcv_loop_get_fd(loop);
+
+	mtcv->manip_dd(96, int16_t(0x1234));
+	ASSERT_EQ(0, tcv_init(tcv));
+	ASSERT_EQ(0, tcv_set_queue(tcv, sync_q));
+	/* nothing would ever carry the request out */
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_submit_read(tcv, 0x50, 0, &id, 1, record, NULL));
+
+	ASSERT_EQ(0, tcv_queue_set_loop(sync_q, loop));
+	EXPECT_EQ(0, tcv_submit_read(tcv, 0x50, 0, &id, 1, record, tag(1)));
+	EXPECT_EQ(0, tcv_submit_dd_snapshot(tcv, &snap, record, tag(2)));
+	EXPECT_TRUE(done.empty());
+	EXPECT_TRUE(readable(fd));
+
+	/* one request per step, the fd stays readable while work is left */
+	EXPECT_EQ(1, tcv_loop_step(loop));
+	EXPECT_TRUE(readable(fd));
+	EXPECT_EQ(1, tcv_loop_step(loop));
+	EXPECT_FALSE(readable(fd));
+
+	ASSERT_EQ(2u, done.size());
+	EXPECT_EQ(1, done[0].tag);
+	EXPECT_EQ(0, done[0].status);
+	EXPECT_EQ(TCV_TYPE_SFP, id);
+	EXPECT_EQ(2, done[1].tag);
+	EXPECT_EQ(0, done[1].status);
+	EXPECT_EQ(0x1234, snap.temp);
+
+	EXPECT_EQ(0, tcv_set_queue(tcv, NULL));
+	EXPECT_EQ(0, tcv_queue_destroy(sync_q));
+	EXPECT_EQ(0, tcv_loop_destroy(loop));
+}
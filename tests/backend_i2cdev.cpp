@@ -0,0 +1,297 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Test the i2c-dev backend against an ioctl stand-in, no adapter needed
+ */
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#include <dlfcn.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+extern "C"{
+#include "libtcv/tcv.h"
+#include "libtcv/i2cdev.h"
+#include "libtcv/tcv_internal.h"
+}
+#include "gtest/gtest.h"
+#include "fake_hw.hpp"
+#include "fake_tcv.hpp"
+
+using namespace std;
+using namespace TestDoubles;
+
+namespace {
+
+/** State of the emulated adapter, only used while active is set */
+struct FakeAdapter {
+	bool active;
+	unsigned long funcs;
+	FakeTCV *dev;
+	long slave;
+	unsigned int rdwr;		//! I2C_RDWR ioctls
+	unsigned int smbus;		//! I2C_SMBUS ioctls
+	unsigned int select;	//! I2C_SLAVE_FORCE ioctls
+	vector<uint8_t> written;	//! last written message incl. register
+};
+
+FakeAdapter adapter;
+
+int fake_rdwr(struct i2c_rdwr_ioctl_data *xfer)
+{
+	adapter.rdwr++;
+	for (unsigned int i = 0; i < xfer->nmsgs; i++) {
+		struct i2c_msg *m = &xfer->msgs[i];
+		tcv_dev_addr_t dev = static_cast<tcv_dev_addr_t>(m->addr);
+
+		if (m->flags & I2C_M_RD)
+			return -1; // read without register pointer
+		/* register pointer followed by repeated start read */
+		if (m->len == 1 && i + 1 < xfer->nmsgs &&
+				(xfer->msgs[i + 1].flags & I2C_M_RD)) {
+			struct i2c_msg *r = &xfer->msgs[++i];
+			if (adapter.dev->read(dev, m->buf[0], r->buf, r->len) < 0)
+				return -1;
+			continue;
+		}
+		adapter.written.assign(m->buf, m->buf + m->len);
+	}
+	return 0;
+}
+
+int fake_smbus(struct i2c_smbus_ioctl_data *args)
+{
+	tcv_dev_addr_t dev = static_cast<tcv_dev_addr_t>(adapter.slave);
+
+	adapter.smbus++;
+	if (args->size != I2C_SMBUS_I2C_BLOCK_DATA)
+		return -1;
+	if (args->data->block[0] > I2C_SMBUS_BLOCK_MAX)
+		return -1;
+	if (args->read_write == I2C_SMBUS_READ)
+		return adapter.dev->read(dev, args->command, &args->data->block[1],
+				args->data->block[0]) < 0 ? -1 : 0;
+
+	adapter.written.assign(1, args->command);
+	adapter.written.insert(adapter.written.end(), &args->data->block[1],
+			&args->data->block[1] + args->data->block[0]);
+	return 0;
+}
+
+}
+
+/* Stand-in for the libc ioctl, everything but i2c-dev requests is forwarded */
+extern "C" int ioctl(int fd, unsigned long request, ...)
+{
+	typedef int (*ioctl_fn)(int, unsigned long, ...);
+	static ioctl_fn next_ioctl = (ioctl_fn) dlsym(RTLD_NEXT, "ioctl");
+	va_list ap;
+	void *arg;
+
+	va_start(ap, request);
+	arg = va_arg(ap, void *);
+	va_end(ap);
+
+	if (adapter.active) {
+		switch (request) {
+			case I2C_FUNCS:
+				*static_cast<unsigned long *>(arg) = adapter.funcs;
+				return 0;
+			case I2C_SLAVE:
+				/* the module is claimed by at24/optoe */
+				errno = EBUSY;
+				return -1;
+			case I2C_SLAVE_FORCE:
+				adapter.select++;
+				adapter.slave = reinterpret_cast<long>(arg);
+				return 0;
+			case I2C_RDWR:
+				return fake_rdwr(static_cast<struct i2c_rdwr_ioctl_data *>(arg));
+			case I2C_SMBUS:
+				return fake_smbus(static_cast<struct i2c_smbus_ioctl_data *>(arg));
+		}
+	}
+	return next_ioctl(fd, request, arg);
+}
+
+class TestI2cdev : public ::testing::Test {
+	public:
+	TestI2cdev()
+	{
+		char tmpl[] = "/tmp/libtcv-i2cdev-XXXXXX";
+
+		dir = mkdtemp(tmpl);
+		/* regular file standing in for the device node of bus 2 */
+		close(open((dir + "/i2c-2").c_str(), O_CREAT | O_RDWR, 0600));
+		path_fmt = dir + "/i2c-%d";
+
+		sfp = make_shared<FakeSFP>(2, i2c_read, i2c_write);
+		adapter = FakeAdapter();
+		adapter.active = true;
+		adapter.funcs = I2C_FUNC_I2C | I2C_FUNC_SMBUS_I2C_BLOCK;
+		adapter.dev = sfp.get();
+		adapter.slave = -1;
+	}
+
+	~TestI2cdev()
+	{
+		adapter.active = false;
+		unlink((dir + "/i2c-2").c_str());
+		rmdir(dir.c_str());
+	}
+
+	string dir;
+	string path_fmt;
+	shared_ptr<FakeSFP> sfp;
+};
+
+TEST_F(TestI2cdev, missingBus)
+{
+	tcv_i2cdev_t *pool = tcv_i2cdev_open(path_fmt.c_str());
+	ASSERT_NE(nullptr, pool);
+	EXPECT_EQ(nullptr, tcv_i2cdev_create(pool, 5));
+	tcv_i2cdev_close(pool);
+}
+
+TEST_F(TestI2cdev, functionalityDetected)
+{
+	unsigned long funcs = 0;
+	tcv_i2cdev_t *pool = tcv_i2cdev_open(path_fmt.c_str());
+	ASSERT_NE(nullptr, pool);
+
+	adapter.funcs = I2C_FUNC_SMBUS_I2C_BLOCK;
+	EXPECT_EQ(0, tcv_i2cdev_get_funcs(pool, 2, &funcs));
+	EXPECT_EQ((unsigned long) I2C_FUNC_SMBUS_I2C_BLOCK, funcs);
+	EXPECT_GT(0, tcv_i2cdev_get_funcs(pool, 5, &funcs));
+	tcv_i2cdev_close(pool);
+}
+
+TEST_F(TestI2cdev, combinedReadWrite)
+{
+	char vendor[TCV_VENDOR_NAME_SIZE + 1];
+	const uint8_t pw[] = { 0x12, 0x34 };
+	tcv_i2cdev_t *pool = tcv_i2cdev_open(path_fmt.c_str());
+	ASSERT_NE(nullptr, pool);
+
+	sfp->manip_eeprom(20, string("I2CDEV VENDOR   "));
+	tcv_t *tcv = tcv_i2cdev_create(pool, 2);
+	ASSERT_NE(nullptr, tcv);
+
+	adapter.rdwr = 0;
+	ASSERT_EQ(0, tcv_init(tcv));
+	/* identifier, then the A0h image, each one pointer write + repeated
+	 * start read */
+	EXPECT_EQ(2u, adapter.rdwr);
+	EXPECT_EQ(0u, adapter.select);
+	EXPECT_EQ(0, tcv_get_vendor_name(tcv, vendor));
+	EXPECT_STREQ("I2CDEV VENDOR   ", vendor);
+
+	EXPECT_EQ(0, tcv_write(tcv, 0x51, 123, pw, sizeof(pw)));
+	EXPECT_EQ(vector<uint8_t>({ 123, 0x12, 0x34 }), adapter.written);
+
+	tcv_destroy(tcv);
+	tcv_i2cdev_close(pool);
+}
+
+TEST_F(TestI2cdev, vectoredRead)
+{
+	uint8_t id, temp[2], rx[2];
+	tcv_i2c_segment_t segs[] = {
+		{ 0x50, 0, &id, 1 },
+		{ 0x51, 96, temp, 2 },
+		{ 0x51, 104, rx, 2 },
+	};
+	tcv_i2cdev_t *pool = tcv_i2cdev_open(path_fmt.c_str());
+	ASSERT_NE(nullptr, pool);
+	tcv_t *tcv = tcv_i2cdev_create(pool, 2);
+	ASSERT_NE(nullptr, tcv);
+
+	sfp->manip_dd(96, int16_t(0x1234));
+	sfp->manip_dd(104, uint16_t(0xbeef));
+	adapter.rdwr = 0;
+	EXPECT_EQ(0, tcv_readv(tcv, segs, 3));
+	EXPECT_EQ(1u, adapter.rdwr);
+	EXPECT_EQ(TCV_TYPE_SFP, id);
+	EXPECT_EQ(0x12, temp[0]);
+	EXPECT_EQ(0x34, temp[1]);
+	EXPECT_EQ(0xbe, rx[0]);
+	EXPECT_EQ(0xef, rx[1]);
+
+	tcv_destroy(tcv);
+	tcv_i2cdev_close(pool);
+}
+
+TEST_F(TestI2cdev, smbusFallback)
+{
+	char vendor[TCV_VENDOR_NAME_SIZE + 1];
+	const uint8_t pw[] = { 0x12, 0x34 };
+	tcv_i2cdev_t *pool = tcv_i2cdev_open(path_fmt.c_str());
+	ASSERT_NE(nullptr, pool);
+
+	adapter.funcs = I2C_FUNC_SMBUS_I2C_BLOCK;
+	sfp->manip_eeprom(20, string("SMBUS VENDOR    "));
+	tcv_t *tcv = tcv_i2cdev_create(pool, 2);
+	ASSERT_NE(nullptr, tcv);
+
+	ASSERT_EQ(0, tcv_init(tcv));
+	EXPECT_EQ(0u, adapter.rdwr);
+	/* identifier plus A0h image in 32 byte blocks, slave selected once */
+	EXPECT_EQ(1 + 256u / I2C_SMBUS_BLOCK_MAX, adapter.smbus);
+	EXPECT_EQ(1u, adapter.select);
+	EXPECT_EQ(0, tcv_get_vendor_name(tcv, vendor));
+	EXPECT_STREQ("SMBUS VENDOR    ", vendor);
+
+	EXPECT_EQ(0, tcv_write(tcv, 0x51, 123, pw, sizeof(pw)));
+	EXPECT_EQ(2u, adapter.select);
+	EXPECT_EQ(vector<uint8_t>({ 123, 0x12, 0x34 }), adapter.written);
+
+	tcv_destroy(tcv);
+	tcv_i2cdev_close(pool);
+}
+
+TEST_F(TestI2cdev, noBlockTransfers)
+{
+	tcv_i2cdev_t *pool = tcv_i2cdev_open(path_fmt.c_str());
+	ASSERT_NE(nullptr, pool);
+
+	adapter.funcs = I2C_FUNC_SMBUS_BYTE_DATA;
+	tcv_t *tcv = tcv_i2cdev_create(pool, 2);
+	ASSERT_NE(nullptr, tcv);
+	EXPECT_GT(0, tcv_init(tcv));
+
+	tcv_destroy(tcv);
+	tcv_i2cdev_close(pool);
+}
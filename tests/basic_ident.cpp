@@ -34,10 +34,15 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <chrono>
 
 extern "C"{
 #include "libtcv/tcv.h"
+#include "libtcv/tcv_internal.h"
 }
 #include "gtest/gtest.h"
 #include "fake_hw.hpp"
@@ -101,6 +106,56 @@ TEST_F(TestFixtureClass, identSFP)
 	EXPECT_EQ(TCV_TYPE_SFP, tcv_get_identifier(tcv));
 }
 
+/* Handle created with context carrying callbacks */
+TEST_F(TestFixtureClass, createWithContext)
+{
+	auto mtcv = get_tcv(1);
+	string name = "Fritz & Frieda  "; //16 chars
+	char buf[128];
+	mtcv->manip_eeprom(20, name);
+
+	EXPECT_EQ(nullptr, tcv_create_ex(7, mtcv.get(), NULL, i2c_write_ctx));
+
+	tcv_t *tcv = tcv_create_ex(7, mtcv.get(), i2c_read_ctx, i2c_write_ctx);
+	ASSERT_NE(nullptr, tcv);
+	EXPECT_EQ(0, tcv_init(tcv));
+	EXPECT_EQ(TCV_TYPE_SFP, tcv_get_identifier(tcv));
+	EXPECT_EQ(0, tcv_get_vendor_name(tcv, buf));
+	EXPECT_STREQ(name.c_str(), buf);
+	EXPECT_EQ(0, tcv_destroy(tcv));
+}
+
+/* Transfers are split to what the adapter can handle */
+TEST_F(TestFixtureClass, transportCapsChunking)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	string name = "Chunked Vendor  "; //16 chars
+	char buf[128];
+	tcv_transport_caps_t caps = { 0, 1, 0 }; // SMBus only
+	tcv_transport_caps_t read_back;
+
+	mtcv->manip_eeprom(20, name);
+	EXPECT_EQ(0, tcv_set_transport_caps(tcv, &caps));
+	EXPECT_EQ(0, tcv_get_transport_caps(tcv, &read_back));
+	EXPECT_EQ(1, read_back.smbus_only);
+
+	mtcv->reset_transactions();
+	ASSERT_EQ(0, tcv_init(tcv));
+	/* identifier + A0h in blocks of 32 bytes */
+	EXPECT_EQ(1u + 256 / TCV_SMBUS_BLOCK_MAX, mtcv->get_transactions());
+	EXPECT_EQ(0, tcv_get_vendor_name(tcv, buf));
+	EXPECT_STREQ(name.c_str(), buf);
+
+	/* explicit limit below the SMBus block size */
+	caps = { 16, 0, 1 };
+	EXPECT_EQ(0, tcv_set_transport_caps(tcv, &caps));
+	mtcv->reset_transactions();
+	EXPECT_EQ(40, tcv_read(tcv, 0x50, 0, reinterpret_cast<uint8_t*>(buf), 40));
+	EXPECT_EQ(3u, mtcv->get_transactions());
+	EXPECT_EQ(0, memcmp(buf + 20, name.c_str(), name.length()));
+}
+
 /* Test update vendor oui */
 TEST_F(TestFixtureClass, getVendorOUI)
 {
@@ -344,3 +399,443 @@ TEST_F(TestFixtureClass, doubleDestroy)
 	ASSERT_EQ(TCV_ERR_INVALID_ARG, ret);
 }
 
+
+/* Revalidation reads a few bytes and only re-initializes a different module */
+TEST_F(TestFixtureClass, revalidate)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	char sn[TCV_VENDOR_SN_SIZE + 1];
+
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_revalidate(NULL));
+	EXPECT_EQ(TCV_ERR_NOT_INITIALIZED, tcv_revalidate(tcv));
+
+	mtcv->manip_eeprom(68, "SN0001          ");
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	mtcv->reset_transactions();
+	EXPECT_EQ(0, tcv_revalidate(tcv));
+	EXPECT_EQ(3u, mtcv->get_transactions());
+
+	/* same module, vendor specific bytes are not checked */
+	mtcv->manip_eeprom(100, 0x13);
+	EXPECT_EQ(0, tcv_revalidate(tcv));
+
+	mtcv->manip_eeprom(68, "SN0002          ");
+	mtcv->reset_transactions();
+	EXPECT_EQ(1, tcv_revalidate(tcv));
+	EXPECT_EQ(5u, mtcv->get_transactions()); // slice + identifier + A0h
+	EXPECT_EQ(0, tcv_get_vendor_sn(tcv, sn));
+	EXPECT_STREQ("SN0002          ", sn);
+	EXPECT_EQ(0, tcv_revalidate(tcv));
+
+	/* unknown module: handle needs init again */
+	mtcv->manip_eeprom(0, 0x55);
+	EXPECT_EQ(TCV_ERR_GENERIC, tcv_revalidate(tcv));
+	EXPECT_EQ(TCV_ERR_NOT_INITIALIZED, tcv_revalidate(tcv));
+}
+
+namespace {
+
+unsigned readv_calls;
+
+int counting_readv(void *ctx, const tcv_i2c_segment_t *segs, size_t nsegs)
+{
+	readv_calls++;
+	return i2c_readv_ctx(ctx, segs, nsegs);
+}
+
+}
+
+/* With a vectored read callback the identity check is one transaction */
+TEST_F(TestFixtureClass, revalidateVectored)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = tcv_create_ex(1, mtcv.get(), i2c_read_ctx, i2c_write_ctx);
+
+	ASSERT_NE(nullptr, tcv);
+	EXPECT_EQ(0, tcv_set_readv(tcv, counting_readv));
+	mtcv->manip_eeprom(68, "SN0001          ");
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	readv_calls = 0;
+	mtcv->reset_transactions();
+	EXPECT_EQ(0, tcv_revalidate(tcv));
+	EXPECT_EQ(1u, readv_calls);
+	EXPECT_EQ(1u, mtcv->get_transactions());
+
+	/* a different serial number is seen through the vectored read too */
+	mtcv->manip_eeprom(68, "SN0002          ");
+	readv_calls = 0;
+	EXPECT_EQ(1, tcv_revalidate(tcv));
+	EXPECT_EQ(1u, readv_calls);
+	tcv_destroy(tcv);
+}
+
+/* Lazy init reads the vendor specific and SFF-8079 areas on first use */
+TEST_F(TestFixtureClass, lazyInit)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	const tcv_transport_caps_t smbus = {0, 1, 0};
+	char sn[TCV_VENDOR_SN_SIZE + 1];
+	string vrom = "A.C.M.E", rom = "Hallo Welt!";
+
+	mtcv->manip_eeprom(68, "SN0001          ");
+	mtcv->manip_eeprom(96, vrom);
+	mtcv->manip_eeprom(128, rom);
+	ASSERT_EQ(0, tcv_set_transport_caps(tcv, &smbus));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_set_lazy_init(NULL, 1));
+	ASSERT_EQ(0, tcv_set_lazy_init(tcv, 1));
+
+	mtcv->reset_transactions();
+	ASSERT_EQ(0, tcv_init(tcv));
+	EXPECT_EQ(4u, mtcv->get_transactions()); // identifier + 3 blocks
+	EXPECT_EQ(0, tcv_get_vendor_sn(tcv, sn));
+	EXPECT_STREQ("SN0001          ", sn);
+	EXPECT_EQ(4u, mtcv->get_transactions());
+
+	const uint8_t* buff = tcv_get_vendor_rom(tcv);
+	ASSERT_NE(nullptr, buff);
+	EXPECT_EQ(vrom, string(reinterpret_cast<const char*>(buff), vrom.size()));
+	EXPECT_EQ(5u, mtcv->get_transactions());
+
+	buff = tcv_get_8079_rom(tcv);
+	ASSERT_NE(nullptr, buff);
+	EXPECT_EQ(rom, string(reinterpret_cast<const char*>(buff), rom.size()));
+	EXPECT_EQ(9u, mtcv->get_transactions());
+	tcv_get_vendor_rom(tcv);
+	tcv_get_8079_rom(tcv);
+	EXPECT_EQ(9u, mtcv->get_transactions());
+
+	/* back to complete reads */
+	ASSERT_EQ(0, tcv_set_lazy_init(tcv, 0));
+	mtcv->reset_transactions();
+	ASSERT_EQ(0, tcv_init(tcv));
+	EXPECT_EQ(9u, mtcv->get_transactions());
+}
+
+/* User EEPROM is read once and written through */
+TEST_F(TestFixtureClass, userWritableEepromCached)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	const uint8_t tag[] = {'T', 'A', 'G'};
+	uint8_t copy[200];
+	const uint8_t page = 1;
+
+	EXPECT_EQ(TCV_ERR_NOT_INITIALIZED, tcv_copy_user_writable_eeprom(tcv, copy, sizeof(copy)));
+	mtcv->manip_dd(128, uint16_t(0x4142));
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	mtcv->reset_transactions();
+	const uint8_t *eeprom = tcv_get_user_writable_eeprom(tcv);
+	ASSERT_NE(nullptr, eeprom);
+	EXPECT_EQ(0x41, eeprom[0]);
+	EXPECT_EQ(120, tcv_copy_user_writable_eeprom(tcv, copy, sizeof(copy)));
+	EXPECT_EQ(2, tcv_copy_user_writable_eeprom(tcv, copy, 2));
+	EXPECT_EQ(1u, mtcv->get_transactions());
+	EXPECT_EQ(0x42, copy[1]);
+
+	/* the write lands in the copy, the fake module ignores it */
+	EXPECT_LE(0, tcv_write(tcv, 0x51, 246, tag, sizeof(tag)));
+	EXPECT_EQ(120, tcv_copy_user_writable_eeprom(tcv, copy, sizeof(copy)));
+	EXPECT_EQ('T', copy[118]);
+	EXPECT_EQ('A', copy[119]);
+	EXPECT_EQ(2u, mtcv->get_transactions());
+
+	/* another page hides it */
+	EXPECT_LE(0, tcv_write(tcv, 0x51, 127, &page, 1));
+	EXPECT_EQ(120, tcv_copy_user_writable_eeprom(tcv, copy, sizeof(copy)));
+	EXPECT_EQ(0xFF, copy[119]);
+	EXPECT_EQ(4u, mtcv->get_transactions());
+
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_copy_user_writable_eeprom(tcv, NULL, 1));
+}
+
+/* Static getters do not wait for I/O running on the same handle */
+TEST_F(TestFixtureClass, staticGettersLockFree)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	char name[TCV_VENDOR_NAME_SIZE + 1];
+	int16_t temp;
+
+	mtcv->manip_eeprom(20, "LOCKFREE VENDOR ");
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	mtcv->set_latency(300000, 0);
+	thread ddm([tcv, &temp] { EXPECT_EQ(0, tcv_get_temperature(tcv, &temp)); });
+	this_thread::sleep_for(chrono::milliseconds(50));
+
+	auto start = chrono::steady_clock::now();
+	EXPECT_EQ(0, tcv_get_vendor_name(tcv, name));
+	EXPECT_EQ(TCV_TYPE_SFP, tcv_get_identifier(tcv));
+	auto elapsed = chrono::steady_clock::now() - start;
+	EXPECT_LT(elapsed, chrono::milliseconds(150));
+	EXPECT_STREQ("LOCKFREE VENDOR ", name);
+
+	ddm.join();
+	mtcv->set_latency(0, 0);
+}
+
+/* Getters running while the handle is re-initialized see one module or the
+ * other, never a handle without static data */
+TEST_F(TestFixtureClass, staticGettersDuringInit)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	atomic<bool> done(false);
+	atomic<unsigned> reads(0), started(0);
+
+	mtcv->manip_eeprom(20, "SAME VENDOR     ");
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	auto reader = [tcv, &done, &reads, &started] {
+		char name[TCV_VENDOR_NAME_SIZE + 1];
+
+		started++;
+		while (!done) {
+			ASSERT_EQ(TCV_TYPE_SFP, tcv_get_identifier(tcv));
+			ASSERT_EQ(0, tcv_get_vendor_name(tcv, name));
+			ASSERT_STREQ("SAME VENDOR     ", name);
+			reads++;
+		}
+	};
+	vector<thread> readers;
+	for (int i = 0; i < 4; i++)
+		readers.emplace_back(reader);
+	/* inits are quick, make sure they overlap the reads */
+	while (started < readers.size())
+		this_thread::yield();
+
+	for (int i = 0; i < 5000; i++)
+		ASSERT_EQ(0, tcv_init(tcv));
+
+	done = true;
+	for (auto &r : readers)
+		r.join();
+	EXPECT_GT(reads.load(), 0u);
+}
+
+/* Static data stays valid between acquire and release however often it is
+ * replaced meanwhile */
+TEST_F(TestFixtureClass, staticReclaimStress)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	atomic<bool> done(false);
+	atomic<unsigned> reads(0), started(0);
+
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	auto reader = [tcv, &done, &reads, &started] {
+		const struct tcv_static *st;
+		char name[TCV_VENDOR_NAME_SIZE + 1];
+		unsigned slot;
+		int id, ret;
+
+		started++;
+		while (!done) {
+			st = tcv_static_acquire(tcv, &slot);
+			id = ret = -1;
+			if (st) {
+				this_thread::yield();
+				id = st->fun->get_identifier(st);
+				ret = st->fun->get_vendor_name(st, name);
+			}
+			/* a failed assertion must not leave the entry in use */
+			tcv_static_release(tcv, slot);
+			ASSERT_EQ(TCV_TYPE_SFP, id);
+			ASSERT_EQ(0, ret);
+			reads++;
+		}
+	};
+	vector<thread> readers;
+	for (unsigned i = 0; i < 2 * thread::hardware_concurrency() + 2; i++)
+		readers.emplace_back(reader);
+	while (started < readers.size())
+		this_thread::yield();
+
+	/* every init publishes a new entry and reclaims the old one */
+	for (int i = 0; i < 20000; i++)
+		ASSERT_EQ(0, tcv_init(tcv));
+
+	done = true;
+	for (auto &r : readers)
+		r.join();
+	EXPECT_GT(reads.load(), 0u);
+}
+
+/* State queries do not wait for a transfer on the same handle */
+TEST_F(TestFixtureClass, stateQueriesDuringTransfer)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	tcv_t *fresh = get_tcv(3)->get_ctcv();
+	tcv_transport_caps_t caps;
+	tcv_dd_cache_stats_t cache;
+	tcv_lock_stats_t io, state;
+	uint16_t vcc;
+	int16_t temp;
+
+	ASSERT_EQ(0, tcv_init(tcv));
+	ASSERT_EQ(0, tcv_get_lock_stats(tcv, &io, NULL));
+	EXPECT_EQ(0u, io.contended);
+
+	mtcv->set_latency(300000, 0);
+	thread ddm([tcv, &temp] { EXPECT_EQ(0, tcv_get_temperature(tcv, &temp)); });
+	this_thread::sleep_for(chrono::milliseconds(50));
+
+	auto start = chrono::steady_clock::now();
+	EXPECT_EQ(0, tcv_get_transport_caps(tcv, &caps));
+	EXPECT_EQ(0, tcv_get_dd_cache_stats(tcv, &cache));
+	EXPECT_EQ(TCV_ERR_NOT_INITIALIZED, tcv_get_temperature(fresh, &temp));
+	EXPECT_EQ(0, tcv_get_lock_stats(tcv, &io, &state));
+	EXPECT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(150));
+
+	/* a second transfer queues up behind the first one */
+	EXPECT_EQ(0, tcv_get_voltage(tcv, &vcc));
+	ddm.join();
+	mtcv->set_latency(0, 0);
+
+	ASSERT_EQ(0, tcv_get_lock_stats(tcv, &io, &state));
+	EXPECT_GE(io.contended, 1u);
+	EXPECT_GT(io.wait_ns, 0u);
+	EXPECT_GT(state.acquired, 0u);
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_get_lock_stats(NULL, &io, &state));
+}
+
+/* Compliance getters built on other getters of the same handle */
+TEST_F(TestFixtureClass, cableCompliance)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	active_cable_compliance_t active;
+	passive_cable_compliance_t passive;
+
+	/* active and passive cable */
+	mtcv->manip_eeprom(8, (uint8_t) 0x0C);
+	mtcv->manip_eeprom(60, (uint8_t) 0x0C);
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	ASSERT_EQ(0, tcv_get_active_cable_compliance(tcv, &active));
+	EXPECT_EQ(1, active.bits.fc_pi_4_limiting_compliant);
+	EXPECT_EQ(1, active.bits.sff_8431_limiting_compliant);
+	EXPECT_EQ(0, active.bits.fc_pi_4_apndx_h_compliant);
+	EXPECT_EQ(0, active.bits.sff_8431_apndx_e_compliant);
+	ASSERT_EQ(0, tcv_get_passive_cable_compliance(tcv, &passive));
+	EXPECT_EQ(0, passive.bits.fc_pi_4_apndx_h_compliant);
+	EXPECT_EQ(0, passive.bits.sff_8431_apndx_e_compliant);
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_get_active_cable_compliance(tcv, NULL));
+}
+
+/* Getters built on other getters read one module even while it is swapped */
+TEST_F(TestFixtureClass, compositeGettersDuringModuleSwap)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	atomic<bool> done(false);
+
+	auto optical = [mtcv] {
+		mtcv->manip_eeprom(2, (uint8_t) TCV_CONN_LC);
+		mtcv->manip_eeprom(8, (uint8_t) 0x00);
+		mtcv->manip_eeprom(18, (uint8_t) 5);
+		mtcv->manip_eeprom(60, vector<uint8_t>{0x03, 0x52});
+	};
+	auto passive = [mtcv] {
+		mtcv->manip_eeprom(2, (uint8_t) TCV_CONN_COPPER_PIGTAIL);
+		mtcv->manip_eeprom(8, (uint8_t) 0x04);
+		mtcv->manip_eeprom(18, (uint8_t) 3);
+		mtcv->manip_eeprom(60, vector<uint8_t>{0x01, 0x00});
+	};
+	optical();
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	auto reader = [tcv, &done] {
+		passive_cable_compliance_t compliance;
+
+		while (!done) {
+			int wavelength = tcv_get_wavelength(tcv);
+			if (wavelength != TCV_ERR_FEATURE_NOT_AVAILABLE) {
+				ASSERT_EQ(850, wavelength);
+			}
+
+			int length = tcv_get_om4_copper_length(tcv);
+			ASSERT_TRUE(length == 50 || length == 3) << length;
+
+			int ret = tcv_get_passive_cable_compliance(tcv, &compliance);
+			if (ret != TCV_ERR_FEATURE_NOT_AVAILABLE) {
+				ASSERT_EQ(0, ret);
+				ASSERT_EQ(1, compliance.bits.fc_pi_4_apndx_h_compliant);
+				ASSERT_EQ(0, compliance.bits.sff_8431_apndx_e_compliant);
+			}
+		}
+	};
+	vector<thread> readers;
+	for (int i = 0; i < 4; i++)
+		readers.emplace_back(reader);
+
+	for (int i = 0; i < 2000; i++) {
+		if (i % 2)
+			optical();
+		else
+			passive();
+		ASSERT_EQ(0, tcv_init(tcv));
+	}
+
+	done = true;
+	for (auto &r : readers)
+		r.join();
+}
+
+#ifdef TCV_LOCK_DEBUG
+TEST_F(TestFixtureClass, lockHistograms)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	tcv_lock_hist_t io, state;
+	uint64_t waits = 0, holds = 0, writes = 0;
+	int16_t temp;
+
+	ASSERT_EQ(0, tcv_init(tcv));
+	mtcv->set_latency(2000, 0);
+	EXPECT_EQ(0, tcv_get_temperature(tcv, &temp));
+	mtcv->set_latency(0, 0);
+
+	ASSERT_EQ(0, tcv_get_lock_histograms(tcv, &io, &state));
+	for (int i = 0; i < TCV_LOCK_HIST_BUCKETS; i++) {
+		waits += io.wait[i];
+		holds += io.hold[i];
+		writes += state.hold[i];
+	}
+	EXPECT_GT(waits, 0u);
+	EXPECT_EQ(waits, holds);
+	/* the temperature read held the lock for the whole transfer */
+	EXPECT_GE(io.max_hold_ns, 2000000u);
+	/* tcv_init() published the module data */
+	EXPECT_GT(writes, 0u);
+}
+
+TEST_F(TestFixtureClass, lockReentryAborts)
+{
+	tcv_t *tcv = get_tcv(1)->get_ctcv();
+
+	EXPECT_DEATH({
+		tcv_io_lock(tcv);
+		tcv_io_lock(tcv);
+	}, "I/O lock taken again");
+	EXPECT_DEATH({
+		tcv_state_wrlock(tcv);
+		tcv_state_rdlock(tcv);
+	}, "state lock taken again");
+}
+#else
+TEST_F(TestFixtureClass, lockHistograms)
+{
+	tcv_lock_hist_t io;
+
+	EXPECT_EQ(TCV_ERR_FEATURE_NOT_AVAILABLE,
+	          tcv_get_lock_histograms(get_tcv(1)->get_ctcv(), &io, NULL));
+}
+#endif
@@ -0,0 +1,260 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Test bus serialization and mux channel caching
+ */
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+extern "C"{
+#include "libtcv/tcv.h"
+#include "libtcv/bus.h"
+#include "libtcv/async.h"
+}
+#include "gtest/gtest.h"
+#include "fake_hw.hpp"
+#include "fake_tcv.hpp"
+
+using namespace std;
+using namespace TestDoubles;
+
+namespace {
+
+/** Mux with the channels behind it */
+struct FakeMux {
+	int channel = -1;
+	vector<int> selects;
+	bool fail_select = false;
+	atomic<int> users{0};	// transfers running at the same time
+	bool overlap = false;
+};
+
+/** Port behind a mux channel */
+struct Port {
+	FakeMux *mux;
+	FakeTCV *dev;
+	int channel;
+	bool fail = false;
+};
+
+int mux_select(void *ctx, int channel)
+{
+	auto mux = static_cast<FakeMux*>(ctx);
+	if (mux->fail_select)
+		return -1;
+	mux->selects.push_back(channel);
+	mux->channel = channel;
+	return 0;
+}
+
+int port_read(void *ctx, uint8_t dev_addr, uint8_t reg_addr, uint8_t* data, size_t len)
+{
+	auto port = static_cast<Port*>(ctx);
+	int ret;
+
+	if (port->mux->users++)
+		port->mux->overlap = true;
+	/* only reachable while the mux routes to the port */
+	if (port->fail || port->mux->channel != port->channel)
+		ret = -1;
+	else
+		ret = port->dev->read(static_cast<tcv_dev_addr_t>(dev_addr), reg_addr, data, len);
+	port->mux->users--;
+	return ret;
+}
+
+int port_write(void *ctx, uint8_t dev_addr, uint8_t reg_addr, const uint8_t* data, size_t len)
+{
+	return 0;
+}
+
+deque<pair<tcv_aio_req_t*, Port*>> started;
+
+int port_submit_read(void *ctx, tcv_aio_req_t *req, uint8_t devaddr,
+		uint8_t regaddr, uint8_t *data, size_t len)
+{
+	auto port = static_cast<Port*>(ctx);
+	if (port->mux->channel != port->channel)
+		return -1;
+	started.push_back({ req, port });
+	return 0;
+}
+
+const tcv_aio_ops_t port_ops = { port_submit_read };
+
+vector<int> order;
+
+void record(tcv_t *tcv, int status, void *arg)
+{
+	order.push_back(static_cast<int>(reinterpret_cast<intptr_t>(arg)));
+}
+
+}
+
+class TestBus : public ::testing::Test {
+	public:
+	TestBus()
+	{
+		for (int i = 0; i < 2; i++) {
+			add_tcv(i, make_shared<FakeSFP>(i, i2c_read, i2c_write));
+			ports[i] = { &mux, get_tcv(i).get(), i };
+			tcvs[i] = tcv_create_ex(i, &ports[i], port_read, port_write);
+		}
+		bus = tcv_bus_create(&mux, mux_select);
+		started.clear();
+		order.clear();
+	}
+
+	~TestBus()
+	{
+		for (int i = 0; i < 2; i++)
+			tcv_destroy(tcvs[i]);
+		EXPECT_EQ(0, tcv_bus_destroy(bus));
+		clear_tcvs();
+	}
+
+	FakeMux mux;
+	Port ports[2];
+	tcv_t *tcvs[2];
+	tcv_bus_t *bus;
+};
+
+TEST_F(TestBus, attachChecks)
+{
+	tcv_bus_t *plain = tcv_bus_create(NULL, NULL);
+
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_bus_attach(plain, tcvs[0], 0));
+	EXPECT_EQ(0, tcv_bus_attach(plain, tcvs[0], TCV_BUS_NO_MUX));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_bus_attach(bus, tcvs[0], 0));
+	EXPECT_EQ(TCV_ERR_BUSY, tcv_bus_destroy(plain));
+	EXPECT_EQ(0, tcv_bus_detach(tcvs[0]));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_bus_detach(tcvs[0]));
+	EXPECT_EQ(0, tcv_bus_destroy(plain));
+}
+
+TEST_F(TestBus, muxSelectOnlyOnChange)
+{
+	tcv_bus_stats_t stats;
+	int16_t temp;
+
+	ASSERT_EQ(0, tcv_bus_attach(bus, tcvs[0], 0));
+	ASSERT_EQ(0, tcv_bus_attach(bus, tcvs[1], 1));
+
+	ASSERT_EQ(0, tcv_init(tcvs[0]));
+	ASSERT_EQ(0, tcv_get_temperature(tcvs[0], &temp));
+	ASSERT_EQ(0, tcv_get_temperature(tcvs[0], &temp));
+	ASSERT_EQ(0, tcv_init(tcvs[1]));
+	ASSERT_EQ(0, tcv_get_temperature(tcvs[1], &temp));
+	ASSERT_EQ(0, tcv_get_temperature(tcvs[0], &temp));
+
+	EXPECT_EQ(vector<int>({ 0, 1, 0 }), mux.selects);
+	EXPECT_EQ(0, tcv_bus_get_stats(bus, &stats));
+	EXPECT_EQ(3u, stats.mux_selects);
+	EXPECT_EQ(stats.transactions, stats.mux_selects + stats.mux_skipped);
+
+	/* external change of the mux */
+	tcv_bus_invalidate(bus);
+	ASSERT_EQ(0, tcv_get_temperature(tcvs[0], &temp));
+	EXPECT_EQ(4u, mux.selects.size());
+}
+
+TEST_F(TestBus, errorsDropCachedChannel)
+{
+	int16_t temp;
+
+	ASSERT_EQ(0, tcv_bus_attach(bus, tcvs[0], 0));
+	ASSERT_EQ(0, tcv_init(tcvs[0]));
+	EXPECT_EQ(1u, mux.selects.size());
+
+	mux.fail_select = true;
+	tcv_bus_invalidate(bus);
+	EXPECT_GT(0, tcv_get_temperature(tcvs[0], &temp));
+	mux.fail_select = false;
+	ASSERT_EQ(0, tcv_get_temperature(tcvs[0], &temp));
+	EXPECT_EQ(2u, mux.selects.size());
+
+	ports[0].fail = true;
+	EXPECT_GT(0, tcv_get_temperature(tcvs[0], &temp));
+	ports[0].fail = false;
+	ASSERT_EQ(0, tcv_get_temperature(tcvs[0], &temp));
+	EXPECT_EQ(3u, mux.selects.size());
+}
+
+TEST_F(TestBus, serializedAcrossThreads)
+{
+	ASSERT_EQ(0, tcv_bus_attach(bus, tcvs[0], 0));
+	ASSERT_EQ(0, tcv_bus_attach(bus, tcvs[1], 1));
+	ASSERT_EQ(0, tcv_init(tcvs[0]));
+	ASSERT_EQ(0, tcv_init(tcvs[1]));
+
+	auto poll = [](tcv_t *tcv) {
+		int16_t temp;
+		for (int i = 0; i < 2000; i++)
+			EXPECT_EQ(0, tcv_get_temperature(tcv, &temp));
+	};
+	thread a(poll, tcvs[0]);
+	thread b(poll, tcvs[1]);
+	a.join();
+	b.join();
+	EXPECT_FALSE(mux.overlap);
+}
+
+TEST_F(TestBus, queuedWorkGroupedByChannel)
+{
+	uint8_t buf[6][2];
+	tcv_queue_t *q = tcv_queue_create(&port_ops);
+
+	ASSERT_EQ(0, tcv_bus_attach(bus, tcvs[0], 0));
+	ASSERT_EQ(0, tcv_bus_attach(bus, tcvs[1], 1));
+	ASSERT_EQ(0, tcv_init(tcvs[0]));
+	ASSERT_EQ(0, tcv_init(tcvs[1]));
+	ASSERT_EQ(0, tcv_set_queue(tcvs[0], q));
+	ASSERT_EQ(0, tcv_set_queue(tcvs[1], q));
+	mux.selects.clear();
+
+	/* interleaved ports, the first one routes the bus to channel 0 */
+	for (intptr_t i = 0; i < 6; i++)
+		EXPECT_EQ(0, tcv_submit_read(tcvs[i % 2], 0x51, 96, buf[i], 2, record,
+				reinterpret_cast<void*>(i)));
+
+	while (!started.empty()) {
+		auto t = started.front();
+		started.pop_front();
+		tcv_aio_complete(t.first, 0);
+	}
+
+	EXPECT_EQ(vector<int>({ 0, 2, 4, 1, 3, 5 }), order);
+	EXPECT_EQ(vector<int>({ 0, 1 }), mux.selects);
+
+	tcv_set_queue(tcvs[0], NULL);
+	tcv_set_queue(tcvs[1], NULL);
+	EXPECT_EQ(0, tcv_queue_destroy(q));
+}
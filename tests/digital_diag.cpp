@@ -8,16 +8,19 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <cstring>
 #include <cstdint>
 #include <iostream>
 
 extern "C"{
 #include "libtcv/tcv.h"
+#include "libtcv/tcv_internal.h"
 }
 #include "gtest/gtest.h"
 #include "fake_hw.hpp"
 #include "fake_tcv.hpp"
 #include <cmath>
+#include <unistd.h>
 
 using namespace std;
 using namespace TestDoubles;
@@ -32,6 +35,8 @@ class TestDiagnosticSetup : public ::testing::Test {
 
 	~TestDiagnosticSetup()
 	{
+		tcv_set_clock(NULL);
+		use_fake_clock(false);
 		clear_tcvs();
 	}
 };
@@ -132,6 +137,8 @@ TEST_F(TestDiagnosticSetup, tempExternalCalib)
 	mtcv->manip_dd(84, slope_f);
 	mtcv->manip_dd(86, offset_f);
 	mtcv->manip_dd(96, temp_f);
+	/* calibration constants are cached, pick up the new ones */
+	EXPECT_EQ(0, tcv_refresh(tcv));
 
 	float expected = (slope * temp) + offset;
 
@@ -252,6 +259,8 @@ TEST_F(TestDiagnosticSetup, txPwrExternalCalib)
     mtcv->manip_dd(80, slope);
     mtcv->manip_dd(82, offset);
     mtcv->manip_dd(102, adval);
+    /* calibration constants are cached, pick up the new ones */
+    EXPECT_EQ(0, tcv_refresh(tcv));
 
     int expected = (slope * adval) / 256 + offset;
 
@@ -314,6 +323,8 @@ TEST_F(TestDiagnosticSetup, rxPwrExternalCalib)
 	mtcv->manip_dd(72, pwr_fac[0]);
 
 	mtcv->manip_dd(104, adval);
+	/* calibration constants are cached, pick up the new ones */
+	EXPECT_EQ(0, tcv_refresh(tcv));
 
 	expected = (uint16_t)(pwr_fac[4] * pow(adval,4) +
 			pwr_fac[3] * pow(adval,3) +
@@ -324,3 +335,405 @@ TEST_F(TestDiagnosticSetup, rxPwrExternalCalib)
 	EXPECT_EQ(0, tcv_get_rx_pwr(tcv, &pwr_read));
 	EXPECT_EQ(expected, pwr_read);
 }
+
+
+namespace {
+
+unsigned readv_calls;
+
+int counting_readv(void *ctx, const tcv_i2c_segment_t *segs, size_t nsegs)
+{
+	readv_calls++;
+	return i2c_readv_ctx(ctx, segs, nsegs);
+}
+
+}
+
+/* Regions spread over both devices take one transaction with a vectored
+ * read callback, one per region without */
+TEST_F(TestDiagnosticSetup, vectoredRead)
+{
+	auto mtcv = get_tcv(1);
+	uint8_t id, vcc[2], slope[2];
+	const tcv_i2c_segment_t segs[] = {
+		{ 0x50, 0, &id, 1 },
+		{ 0x51, 98, vcc, 2 },
+		{ 0x51, 88, slope, 2 },
+	};
+
+	mtcv->manip_dd(88, int16_t(0x0401));
+	mtcv->manip_dd(98, int16_t(3300));
+
+	tcv_t *tcv = tcv_create_ex(1, mtcv.get(), i2c_read_ctx, i2c_write_ctx);
+	ASSERT_NE(nullptr, tcv);
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	mtcv->reset_transactions();
+	EXPECT_EQ(0, tcv_readv(tcv, segs, 3));
+	EXPECT_EQ(3u, mtcv->get_transactions());
+
+	EXPECT_EQ(0, tcv_set_readv(tcv, counting_readv));
+	readv_calls = 0;
+	mtcv->reset_transactions();
+	memset(vcc, 0, sizeof(vcc));
+	EXPECT_EQ(0, tcv_readv(tcv, segs, 3));
+	EXPECT_EQ(1u, readv_calls);
+	EXPECT_EQ(1u, mtcv->get_transactions());
+	EXPECT_EQ(TCV_TYPE_SFP, id);
+	EXPECT_EQ(3300, (vcc[0] << 8) | vcc[1]);
+	EXPECT_EQ(0x0401, (slope[0] << 8) | slope[1]);
+
+	/* index based handles can't take a vectored callback */
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_set_readv(mtcv->get_ctcv(), i2c_readv_ctx));
+	tcv_destroy(tcv);
+}
+
+
+/* All values of an internally calibrated module in one transaction */
+TEST_F(TestDiagnosticSetup, snapshotInternalCalib)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	tcv_dd_snapshot_t snap, later;
+
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_get_dd_snapshot(NULL, &snap));
+	EXPECT_EQ(TCV_ERR_NOT_INITIALIZED, tcv_get_dd_snapshot(tcv, &snap));
+
+	mtcv->manip_eeprom(92, 0x60); // Internally calibrated
+	ASSERT_EQ(0, tcv_init(tcv));
+	mtcv->manip_dd(96, int16_t(-384));
+	mtcv->manip_dd(98, uint16_t(33000));
+	mtcv->manip_dd(100, uint16_t(3210));
+	mtcv->manip_dd(102, uint16_t(17543));
+	mtcv->manip_dd(104, uint16_t(16224));
+
+	mtcv->reset_transactions();
+	EXPECT_EQ(0, tcv_get_dd_snapshot(tcv, &snap));
+	EXPECT_EQ(1u, mtcv->get_transactions());
+	EXPECT_EQ(-384, snap.temp);
+	EXPECT_EQ(33000, snap.vcc);
+	EXPECT_EQ(3210, snap.tx_cur);
+	EXPECT_EQ(17543, snap.tx_pwr);
+	EXPECT_EQ(16224, snap.rx_pwr);
+
+	EXPECT_EQ(0, tcv_get_dd_snapshot(tcv, &later));
+	EXPECT_LE(snap.timestamp, later.timestamp);
+}
+
+/* Snapshot of an externally calibrated module matches the single getters */
+TEST_F(TestDiagnosticSetup, snapshotExternalCalib)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	tcv_dd_snapshot_t snap;
+	int16_t temp;
+	uint16_t vcc, cur, txpwr, rxpwr;
+
+	mtcv->manip_eeprom(92, 0x50); // Externally calibrated
+	mtcv->manip_dd(56, 0.0f);
+	mtcv->manip_dd(60, 0.0f);
+	mtcv->manip_dd(64, 0.0f);
+	mtcv->manip_dd(68, 0.222775f);
+	mtcv->manip_dd(72, -3.787173f);
+	mtcv->manip_dd(76, int16_t(0x0108));
+	mtcv->manip_dd(78, int16_t(1000));
+	mtcv->manip_dd(80, int16_t(0x0102));
+	mtcv->manip_dd(82, int16_t(-235));
+	mtcv->manip_dd(84, int16_t(272));
+	mtcv->manip_dd(86, int16_t(32));
+	mtcv->manip_dd(88, int16_t(0x0401));
+	mtcv->manip_dd(90, int16_t(2125));
+	mtcv->manip_dd(96, int16_t(12416));
+	mtcv->manip_dd(98, int16_t(3300));
+	mtcv->manip_dd(100, int16_t(3210));
+	mtcv->manip_dd(102, int16_t(17543));
+	mtcv->manip_dd(104, uint16_t(16224));
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	mtcv->reset_transactions();
+	EXPECT_EQ(0, tcv_get_dd_snapshot(tcv, &snap));
+	EXPECT_EQ(1u, mtcv->get_transactions());
+
+	EXPECT_EQ(0, tcv_get_temperature(tcv, &temp));
+	EXPECT_EQ(0, tcv_get_voltage(tcv, &vcc));
+	EXPECT_EQ(0, tcv_get_tx_cur(tcv, &cur));
+	EXPECT_EQ(0, tcv_get_tx_pwr(tcv, &txpwr));
+	EXPECT_EQ(0, tcv_get_rx_pwr(tcv, &rxpwr));
+	EXPECT_EQ(temp, snap.temp);
+	EXPECT_EQ(vcc, snap.vcc);
+	EXPECT_EQ(cur, snap.tx_cur);
+	EXPECT_EQ(txpwr, snap.tx_pwr);
+	EXPECT_EQ(rxpwr, snap.rx_pwr);
+}
+
+
+/* Calibration constants are read at init, readings are one A/D access */
+TEST_F(TestDiagnosticSetup, calibrationCached)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	uint16_t cur_read;
+	int16_t slope = 0x0108;
+	int16_t offset = 1000;
+
+	mtcv->manip_eeprom(92, 0x58); // Externally calibrated
+	mtcv->manip_dd(76, slope);
+	mtcv->manip_dd(78, offset);
+	mtcv->manip_dd(100, int16_t(3210));
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	mtcv->reset_transactions();
+	EXPECT_EQ(0, tcv_get_tx_cur(tcv, &cur_read));
+	EXPECT_EQ(1u, mtcv->get_transactions());
+	EXPECT_EQ((slope * 3210) / 256 + offset, cur_read);
+
+	/* stale until refreshed */
+	mtcv->manip_dd(78, int16_t(0));
+	EXPECT_EQ(0, tcv_get_tx_cur(tcv, &cur_read));
+	EXPECT_EQ((slope * 3210) / 256 + offset, cur_read);
+	EXPECT_EQ(0, tcv_refresh(tcv));
+	EXPECT_EQ(0, tcv_get_tx_cur(tcv, &cur_read));
+	EXPECT_EQ((slope * 3210) / 256, cur_read);
+}
+
+TEST_F(TestDiagnosticSetup, noDiagnosticsImplemented)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	int16_t temp;
+	uint16_t val;
+	tcv_dd_snapshot_t snapshot;
+
+	mtcv->manip_eeprom(92, 0x00); // no digital diagnostics
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	mtcv->reset_transactions();
+	EXPECT_EQ(TCV_ERR_DIAGNOSTICS_INFO_NOT_PRESENT, tcv_get_temperature(tcv, &temp));
+	EXPECT_EQ(TCV_ERR_DIAGNOSTICS_INFO_NOT_PRESENT, tcv_get_voltage(tcv, &val));
+	EXPECT_EQ(TCV_ERR_DIAGNOSTICS_INFO_NOT_PRESENT, tcv_get_tx_cur(tcv, &val));
+	EXPECT_EQ(TCV_ERR_DIAGNOSTICS_INFO_NOT_PRESENT, tcv_get_tx_pwr(tcv, &val));
+	EXPECT_EQ(TCV_ERR_DIAGNOSTICS_INFO_NOT_PRESENT, tcv_get_rx_pwr(tcv, &val));
+	EXPECT_EQ(TCV_ERR_DIAGNOSTICS_INFO_NOT_PRESENT, tcv_get_dd_snapshot(tcv, &snapshot));
+	/* nothing is read from the module */
+	EXPECT_EQ(0u, mtcv->get_transactions());
+}
+
+TEST_F(TestDiagnosticSetup, pagedAccess)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	uint8_t buf[8];
+	const uint8_t page = 2;
+
+	EXPECT_EQ(TCV_ERR_NOT_INITIALIZED, tcv_read_paged(tcv, 1, 128, buf, sizeof(buf)));
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	mtcv->reset_transactions();
+	EXPECT_LE(0, tcv_read_paged(tcv, 1, 128, buf, sizeof(buf)));
+	EXPECT_EQ(2u, mtcv->get_transactions()); // select + read
+	EXPECT_LE(0, tcv_read_paged(tcv, 1, 200, buf, sizeof(buf)));
+	EXPECT_EQ(3u, mtcv->get_transactions()); // page still selected
+	/* lower half is not paged */
+	EXPECT_LE(0, tcv_read_paged(tcv, 2, 96, buf, sizeof(buf)));
+	EXPECT_EQ(4u, mtcv->get_transactions());
+	EXPECT_LE(0, tcv_write_paged(tcv, 2, 128, buf, sizeof(buf)));
+	EXPECT_EQ(6u, mtcv->get_transactions());
+
+	/* raw write of the select register drops the cached page */
+	EXPECT_LE(0, tcv_write(tcv, 0x51, 127, &page, 1));
+	mtcv->reset_transactions();
+	EXPECT_LE(0, tcv_read_paged(tcv, 2, 128, buf, sizeof(buf)));
+	EXPECT_EQ(2u, mtcv->get_transactions());
+
+	/* as does re-init */
+	ASSERT_EQ(0, tcv_init(tcv));
+	mtcv->reset_transactions();
+	EXPECT_LE(0, tcv_read_paged(tcv, 2, 128, buf, sizeof(buf)));
+	EXPECT_EQ(2u, mtcv->get_transactions());
+
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_read_paged(tcv, 2, 250, buf, sizeof(buf)));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_write_paged(tcv, 2, 124, buf, sizeof(buf)));
+}
+
+/* Cached diagnostics come from one burst read until they expire */
+TEST_F(TestDiagnosticSetup, diagnosticsCache)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	tcv_dd_cache_stats_t stats;
+	tcv_dd_snapshot_t snap;
+	int16_t temp;
+	uint16_t vcc, rx_pwr;
+
+	EXPECT_EQ(TCV_ERR_NOT_INITIALIZED, tcv_get_dd_cache_stats(tcv, &stats));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_set_dd_cache(NULL, 1000));
+	EXPECT_EQ(0, tcv_set_dd_cache(tcv, 60000));
+
+	mtcv->manip_eeprom(92, 0x60); // Internally calibrated
+	ASSERT_EQ(0, tcv_init(tcv));
+	mtcv->manip_dd(96, int16_t(-384));
+	mtcv->manip_dd(98, uint16_t(33000));
+	mtcv->manip_dd(104, uint16_t(16224));
+
+	mtcv->reset_transactions();
+	EXPECT_EQ(0, tcv_get_temperature(tcv, &temp));
+	EXPECT_EQ(0, tcv_get_voltage(tcv, &vcc));
+	EXPECT_EQ(0, tcv_get_rx_pwr(tcv, &rx_pwr));
+	EXPECT_EQ(0, tcv_get_dd_snapshot(tcv, &snap));
+	EXPECT_EQ(1u, mtcv->get_transactions());
+	EXPECT_EQ(-384, temp);
+	EXPECT_EQ(33000, vcc);
+	EXPECT_EQ(16224, rx_pwr);
+	EXPECT_EQ(16224, snap.rx_pwr);
+
+	ASSERT_EQ(0, tcv_get_dd_cache_stats(tcv, &stats));
+	EXPECT_EQ(1u, stats.misses);
+	EXPECT_EQ(3u, stats.hits);
+
+	/* module changes go unnoticed until the values expire */
+	mtcv->manip_dd(96, int16_t(256));
+	EXPECT_EQ(0, tcv_get_temperature(tcv, &temp));
+	EXPECT_EQ(-384, temp);
+
+	/* A2h writes drop them */
+	EXPECT_LE(0, tcv_write(tcv, 0x51, 110, (const uint8_t *) "\0", 1));
+	EXPECT_EQ(0, tcv_get_temperature(tcv, &temp));
+	EXPECT_EQ(256, temp);
+
+	EXPECT_EQ(0, tcv_set_dd_cache(tcv, 1));
+	mtcv->manip_dd(96, int16_t(512));
+	usleep(2000);
+	EXPECT_EQ(0, tcv_get_temperature(tcv, &temp));
+	EXPECT_EQ(512, temp);
+
+	/* disabled: every getter reads */
+	EXPECT_EQ(0, tcv_set_dd_cache(tcv, 0));
+	mtcv->reset_transactions();
+	EXPECT_EQ(0, tcv_get_temperature(tcv, &temp));
+	EXPECT_EQ(0, tcv_get_voltage(tcv, &vcc));
+	EXPECT_EQ(2u, mtcv->get_transactions());
+
+	/* counters restart with init */
+	ASSERT_EQ(0, tcv_init(tcv));
+	ASSERT_EQ(0, tcv_get_dd_cache_stats(tcv, &stats));
+	EXPECT_EQ(0u, stats.hits + stats.misses);
+}
+
+TEST_F(TestDiagnosticSetup, readAhead)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	tcv_read_ahead_stats_t stats;
+	int16_t temp;
+	uint16_t vcc, cur, tx_pwr, rx_pwr;
+
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_set_read_ahead(NULL, TCV_READ_AHEAD_ON, 100));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_set_read_ahead(tcv, TCV_READ_AHEAD_ON, 0));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_set_read_ahead(tcv, (tcv_read_ahead_t) 7, 100));
+	EXPECT_EQ(TCV_ERR_NOT_INITIALIZED, tcv_get_read_ahead_stats(tcv, &stats));
+	EXPECT_EQ(0, tcv_set_read_ahead(tcv, TCV_READ_AHEAD_ON, 60000));
+
+	mtcv->manip_eeprom(92, 0x60); // Internally calibrated
+	ASSERT_EQ(0, tcv_init(tcv));
+	mtcv->manip_dd(96, int16_t(-384));
+	mtcv->manip_dd(98, uint16_t(33000));
+	mtcv->manip_dd(100, uint16_t(1234));
+	mtcv->manip_dd(102, uint16_t(4321));
+	mtcv->manip_dd(104, uint16_t(16224));
+
+	/* one region read serves all values once */
+	mtcv->reset_transactions();
+	EXPECT_EQ(0, tcv_get_temperature(tcv, &temp));
+	EXPECT_EQ(0, tcv_get_voltage(tcv, &vcc));
+	EXPECT_EQ(0, tcv_get_tx_cur(tcv, &cur));
+	EXPECT_EQ(0, tcv_get_tx_pwr(tcv, &tx_pwr));
+	EXPECT_EQ(0, tcv_get_rx_pwr(tcv, &rx_pwr));
+	EXPECT_EQ(1u, mtcv->get_transactions());
+	EXPECT_EQ(-384, temp);
+	EXPECT_EQ(33000, vcc);
+	EXPECT_EQ(1234, cur);
+	EXPECT_EQ(4321, tx_pwr);
+	EXPECT_EQ(16224, rx_pwr);
+
+	ASSERT_EQ(0, tcv_get_read_ahead_stats(tcv, &stats));
+	EXPECT_EQ(1u, stats.fills);
+	EXPECT_EQ(0u, stats.word_reads);
+	EXPECT_EQ(4u, stats.hits);
+	EXPECT_EQ(16u, stats.bytes_read);
+	EXPECT_EQ(8u, stats.bytes_saved);
+
+	/* asking again reads the module again */
+	mtcv->manip_dd(96, int16_t(256));
+	EXPECT_EQ(0, tcv_get_temperature(tcv, &temp));
+	EXPECT_EQ(256, temp);
+	EXPECT_EQ(2u, mtcv->get_transactions());
+
+	/* A2h writes drop the region */
+	mtcv->manip_dd(98, uint16_t(3300));
+	EXPECT_LE(0, tcv_write(tcv, 0x51, 110, (const uint8_t *) "\0", 1));
+	mtcv->reset_transactions();
+	EXPECT_EQ(0, tcv_get_voltage(tcv, &vcc));
+	EXPECT_EQ(3300, vcc);
+	EXPECT_EQ(1u, mtcv->get_transactions());
+
+	/* off: every getter reads its value */
+	EXPECT_EQ(0, tcv_set_read_ahead(tcv, TCV_READ_AHEAD_OFF, 0));
+	mtcv->reset_transactions();
+	EXPECT_EQ(0, tcv_get_temperature(tcv, &temp));
+	EXPECT_EQ(0, tcv_get_rx_pwr(tcv, &rx_pwr));
+	EXPECT_EQ(2u, mtcv->get_transactions());
+
+	/* counters restart with init */
+	ASSERT_EQ(0, tcv_init(tcv));
+	ASSERT_EQ(0, tcv_get_read_ahead_stats(tcv, &stats));
+	EXPECT_EQ(0u, stats.fills + stats.word_reads + stats.hits);
+}
+
+/* Read all five values per round, return the transactions of the last one */
+static unsigned int read_ahead_rounds(shared_ptr<FakeTCV> mtcv, int rounds)
+{
+	tcv_t *tcv = mtcv->get_ctcv();
+	int16_t temp;
+	uint16_t vcc, cur, tx_pwr, rx_pwr;
+
+	for (int i = 0; i < rounds; i++) {
+		mtcv->reset_transactions();
+		EXPECT_EQ(0, tcv_get_temperature(tcv, &temp));
+		EXPECT_EQ(0, tcv_get_voltage(tcv, &vcc));
+		EXPECT_EQ(0, tcv_get_tx_cur(tcv, &cur));
+		EXPECT_EQ(0, tcv_get_tx_pwr(tcv, &tx_pwr));
+		EXPECT_EQ(0, tcv_get_rx_pwr(tcv, &rx_pwr));
+	}
+	return mtcv->get_transactions();
+}
+
+TEST_F(TestDiagnosticSetup, readAheadAuto)
+{
+	auto mtcv = get_tcv(1);
+	tcv_t *tcv = mtcv->get_ctcv();
+	tcv_read_ahead_stats_t stats;
+
+	/* costs are measured on the simulated clock, no real sleeps */
+	use_fake_clock(true);
+	tcv_set_clock(fake_clock_ns);
+
+	mtcv->manip_eeprom(92, 0x60); // Internally calibrated
+	EXPECT_EQ(0, tcv_set_read_ahead(tcv, TCV_READ_AHEAD_AUTO, 60000));
+
+	/* transactions dominate: fetch the region */
+	mtcv->set_latency(3000, 0);
+	ASSERT_EQ(0, tcv_init(tcv));
+	EXPECT_EQ(1u, read_ahead_rounds(mtcv, 8));
+	ASSERT_EQ(0, tcv_get_read_ahead_stats(tcv, &stats));
+	EXPECT_LT(0u, stats.hits);
+	EXPECT_EQ(3000000u, stats.xfer_ns);
+	EXPECT_EQ(0u, stats.byte_ns);
+
+	/* bytes dominate: read the values only */
+	mtcv->set_latency(0, 1000);
+	ASSERT_EQ(0, tcv_init(tcv));
+	EXPECT_EQ(5u, read_ahead_rounds(mtcv, 6));
+	ASSERT_EQ(0, tcv_get_read_ahead_stats(tcv, &stats));
+	EXPECT_EQ(1000000u, stats.byte_ns);
+	mtcv->set_latency(0, 0);
+}
@@ -0,0 +1,159 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Test the persistent EEPROM cache
+ */
+
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
+extern "C"{
+#include "libtcv/tcv.h"
+#include "libtcv/eeprom_cache.h"
+}
+#include "gtest/gtest.h"
+#include "fake_hw.hpp"
+#include "fake_tcv.hpp"
+
+using namespace std;
+using namespace TestDoubles;
+
+class TestEepromCache : public ::testing::Test {
+	public:
+	char dir[32] = "/tmp/tcv-cache-XXXXXX";
+	tcv_eeprom_cache_t *cache = nullptr;
+
+	TestEepromCache()
+	{
+		if (mkdtemp(dir))
+			cache = tcv_eeprom_cache_open(dir);
+	}
+
+	~TestEepromCache()
+	{
+		clear_tcvs();
+		tcv_eeprom_cache_close(cache);
+		unlink((string(dir) + "/a0-1").c_str());
+		rmdir(dir);
+	}
+
+	/** Plug a module into port 1 of a freshly started process */
+	shared_ptr<FakeTCV> restart(const string &serial)
+	{
+		const tcv_transport_caps_t smbus = {0, 1, 0};
+
+		clear_tcvs();
+		add_tcv(1, make_shared<FakeSFP>(1, i2c_read, i2c_write));
+		auto mtcv = get_tcv(1);
+		mtcv->manip_eeprom(20, "ACME CORP.      ");
+		mtcv->manip_eeprom(68, serial);
+		tcv_set_transport_caps(mtcv->get_ctcv(), &smbus);
+		EXPECT_EQ(0, tcv_eeprom_cache_attach(cache, mtcv->get_ctcv()));
+		return mtcv;
+	}
+
+	tcv_eeprom_cache_stats_t stats()
+	{
+		tcv_eeprom_cache_stats_t s;
+
+		EXPECT_EQ(0, tcv_eeprom_cache_get_stats(cache, &s));
+		return s;
+	}
+};
+
+/* Second start only reads the validation slice */
+TEST_F(TestEepromCache, warmRestart)
+{
+	char vendor[TCV_VENDOR_NAME_SIZE + 1];
+	ASSERT_NE(nullptr, cache);
+
+	auto mtcv = restart("SN0001          ");
+	ASSERT_EQ(0, tcv_init(mtcv->get_ctcv()));
+	EXPECT_EQ(9u, mtcv->get_transactions()); // identifier + 8 SMBus blocks
+	EXPECT_EQ(1u, stats().misses);
+	EXPECT_EQ(1u, stats().stores);
+
+	mtcv = restart("SN0001          ");
+	ASSERT_EQ(0, tcv_init(mtcv->get_ctcv()));
+	EXPECT_EQ(3u, mtcv->get_transactions()); // identifier + CC_BASE + 68-95
+	EXPECT_EQ(1u, stats().hits);
+	EXPECT_EQ(1u, stats().stores);
+	EXPECT_EQ(0, tcv_get_vendor_name(mtcv->get_ctcv(), vendor));
+	EXPECT_STREQ("ACME CORP.      ", vendor);
+}
+
+/* Another module in the port is read completely */
+TEST_F(TestEepromCache, moduleSwapped)
+{
+	char sn[TCV_VENDOR_SN_SIZE + 1];
+	ASSERT_NE(nullptr, cache);
+
+	auto mtcv = restart("SN0001          ");
+	ASSERT_EQ(0, tcv_init(mtcv->get_ctcv()));
+
+	mtcv = restart("SN0002          ");
+	ASSERT_EQ(0, tcv_init(mtcv->get_ctcv()));
+	EXPECT_EQ(11u, mtcv->get_transactions());
+	EXPECT_EQ(2u, stats().misses);
+	EXPECT_EQ(0, tcv_get_vendor_sn(mtcv->get_ctcv(), sn));
+	EXPECT_STREQ("SN0002          ", sn);
+
+	/* handles keep the cache busy */
+	EXPECT_EQ(TCV_ERR_BUSY, tcv_eeprom_cache_close(cache));
+	EXPECT_EQ(0, tcv_eeprom_cache_detach(mtcv->get_ctcv()));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_eeprom_cache_detach(mtcv->get_ctcv()));
+}
+
+/* Corrupted files and EEPROM writes are not trusted */
+TEST_F(TestEepromCache, invalidImage)
+{
+	const uint8_t byte = 0x42;
+	ASSERT_NE(nullptr, cache);
+
+	auto mtcv = restart("SN0001          ");
+	ASSERT_EQ(0, tcv_init(mtcv->get_ctcv()));
+
+	{
+		fstream f(string(dir) + "/a0-1", ios::in | ios::out | ios::binary);
+		f.seekp(100);
+		f.put(0x13);
+	}
+	mtcv = restart("SN0001          ");
+	ASSERT_EQ(0, tcv_init(mtcv->get_ctcv()));
+	EXPECT_EQ(0u, stats().hits);
+	EXPECT_EQ(2u, stats().stores);
+
+	EXPECT_LE(0, tcv_write(mtcv->get_ctcv(), 0x50, 100, &byte, 1));
+	mtcv = restart("SN0001          ");
+	ASSERT_EQ(0, tcv_init(mtcv->get_ctcv()));
+	EXPECT_EQ(0u, stats().hits);
+	EXPECT_EQ(3u, stats().misses);
+}
@@ -0,0 +1,239 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Test the EEPROM write engine against a simulated paged EEPROM
+ */
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+extern "C"{
+#include "libtcv/tcv.h"
+#include "libtcv/eeprom_write.h"
+}
+#include "gtest/gtest.h"
+
+using namespace std;
+
+namespace {
+
+/** EEPROM with 8 byte pages and a write cycle of some polls */
+struct FakeEeprom {
+	uint8_t mem[2][256];
+	size_t page = 8;
+	int cycle = 3;			// NACKed accesses after every write
+	int busy = 0;			// NACKs left of the current write cycle
+	bool corrupt = false;	// store the first byte wrong
+	int nacks = 0;			// writes NACKed before the next one goes through
+	vector<pair<uint8_t, size_t>> writes;	// regaddr, length
+	unsigned polls = 0;
+
+	uint8_t *device(uint8_t devaddr)
+	{
+		return mem[devaddr == 0x51];
+	}
+};
+
+int eeprom_read(void *ctx, uint8_t devaddr, uint8_t regaddr, uint8_t *data, size_t len)
+{
+	auto e = static_cast<FakeEeprom *>(ctx);
+
+	if (e->busy) {
+		e->busy--;
+		e->polls++;
+		return -1;
+	}
+	memcpy(data, e->device(devaddr) + regaddr, len);
+	return len;
+}
+
+int eeprom_write(void *ctx, uint8_t devaddr, uint8_t regaddr, const uint8_t *data, size_t len)
+{
+	auto e = static_cast<FakeEeprom *>(ctx);
+	size_t i, base = regaddr & ~(e->page - 1);
+
+	if (e->busy)
+		return -1;
+	if (e->nacks) {
+		e->nacks--;
+		return -1;
+	}
+
+	e->writes.push_back({ regaddr, len });
+	/* addresses wrap around within the page */
+	for (i = 0; i < len; i++)
+		e->device(devaddr)[base + (regaddr - base + i) % e->page] = data[i];
+	if (e->corrupt)
+		e->device(devaddr)[regaddr] ^= 0xFF;
+	e->busy = e->cycle;
+	return len;
+}
+
+}
+
+class TestEepromWrite : public ::testing::Test {
+	public:
+	FakeEeprom eeprom;
+	tcv_t *tcv;
+
+	TestEepromWrite()
+	{
+		memset(eeprom.mem, 0xFF, sizeof(eeprom.mem));
+		eeprom.mem[0][0] = TCV_TYPE_SFP;
+		eeprom.mem[0][92] = 0;
+		tcv = tcv_create_ex(1, &eeprom, eeprom_read, eeprom_write);
+	}
+
+	~TestEepromWrite()
+	{
+		tcv_destroy(tcv);
+	}
+};
+
+/* Without configuration writes go out as given */
+TEST_F(TestEepromWrite, unconfigured)
+{
+	uint8_t data[20] = {};
+
+	ASSERT_EQ(0, tcv_init(tcv));
+	EXPECT_LE(0, tcv_write(tcv, 0x51, 128, data, sizeof(data)));
+	ASSERT_EQ(1u, eeprom.writes.size());
+	EXPECT_EQ(20u, eeprom.writes[0].second);
+}
+
+/* Writes are split on pages and wait for every write cycle */
+TEST_F(TestEepromWrite, pageSplitAndAckPolling)
+{
+	const tcv_write_config_t config = { 8, 100, 1 };
+	uint8_t data[20], back[20];
+
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = i;
+
+	tcv_write_config_t bad = config;
+	bad.page_size = 12;
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_set_write_config(tcv, &bad));
+	/* verifying needs the end of the write cycle */
+	bad = config;
+	bad.ack_timeout_ms = 0;
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_set_write_config(tcv, &bad));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_set_write_config(NULL, &config));
+	ASSERT_EQ(0, tcv_set_write_config(tcv, &config));
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	EXPECT_EQ(20, tcv_write(tcv, 0x51, 130, data, sizeof(data)));
+	ASSERT_EQ(3u, eeprom.writes.size());
+	EXPECT_EQ(make_pair(uint8_t(130), size_t(6)), eeprom.writes[0]);
+	EXPECT_EQ(make_pair(uint8_t(136), size_t(8)), eeprom.writes[1]);
+	EXPECT_EQ(make_pair(uint8_t(144), size_t(6)), eeprom.writes[2]);
+	EXPECT_EQ(9u, eeprom.polls);
+
+	EXPECT_LE(0, tcv_read(tcv, 0x51, 130, back, sizeof(back)));
+	EXPECT_EQ(0, memcmp(data, back, sizeof(data)));
+}
+
+/* A write cycle beyond the timeout and bad data are reported */
+TEST_F(TestEepromWrite, timeoutAndVerify)
+{
+	tcv_write_config_t config = { 8, 1, 1 };
+	const uint8_t data[4] = { 1, 2, 3, 4 };
+
+	ASSERT_EQ(0, tcv_set_write_config(tcv, &config));
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	eeprom.cycle = 1 << 30;
+	EXPECT_EQ(TCV_ERR_TIMEOUT, tcv_write(tcv, 0x51, 128, data, sizeof(data)));
+	eeprom.busy = 0;
+	eeprom.cycle = 1;
+
+	eeprom.corrupt = true;
+	EXPECT_EQ(TCV_ERR_VERIFY, tcv_write(tcv, 0x51, 128, data, sizeof(data)));
+	eeprom.corrupt = false;
+	EXPECT_EQ(4, tcv_write(tcv, 0x51, 128, data, sizeof(data)));
+}
+
+/* Deferred writes are merged into runs */
+TEST_F(TestEepromWrite, deferredCoalescing)
+{
+	const tcv_write_config_t config = { 8, 100, 0 };
+	const uint8_t a[] = { 1, 2, 3 }, b[] = { 4, 5 }, c[] = { 6 };
+
+	ASSERT_EQ(0, tcv_set_write_config(tcv, &config));
+	EXPECT_EQ(TCV_ERR_NOT_INITIALIZED, tcv_flush(tcv));
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	EXPECT_EQ(0, tcv_write_deferred(tcv, 0x51, 130, a, sizeof(a)));
+	EXPECT_EQ(0, tcv_write_deferred(tcv, 0x51, 133, b, sizeof(b)));
+	EXPECT_EQ(0, tcv_write_deferred(tcv, 0x51, 131, c, sizeof(c)));
+	EXPECT_EQ(0, tcv_write_deferred(tcv, 0x51, 200, c, sizeof(c)));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_write_deferred(tcv, 0x51, 255, a, sizeof(a)));
+	EXPECT_TRUE(eeprom.writes.empty());
+
+	EXPECT_EQ(0, tcv_flush(tcv));
+	ASSERT_EQ(2u, eeprom.writes.size());
+	EXPECT_EQ(make_pair(uint8_t(130), size_t(5)), eeprom.writes[0]);
+	EXPECT_EQ(make_pair(uint8_t(200), size_t(1)), eeprom.writes[1]);
+	EXPECT_EQ(1, eeprom.mem[1][130]);
+	EXPECT_EQ(6, eeprom.mem[1][131]);
+	EXPECT_EQ(5, eeprom.mem[1][134]);
+
+	/* nothing left */
+	EXPECT_EQ(0, tcv_flush(tcv));
+	EXPECT_EQ(2u, eeprom.writes.size());
+
+	/* MSA area of A0h stays protected, such writes are dropped */
+	EXPECT_EQ(0, tcv_write_deferred(tcv, 0x50, 10, a, sizeof(a)));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_flush(tcv));
+	EXPECT_EQ(0, tcv_flush(tcv));
+}
+
+/* Deferred data survives a failed flush */
+TEST_F(TestEepromWrite, deferredRetry)
+{
+	const tcv_write_config_t config = { 8, 100, 0 };
+	const uint8_t a[] = { 1, 2 }, b[] = { 3 };
+
+	ASSERT_EQ(0, tcv_set_write_config(tcv, &config));
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	EXPECT_EQ(0, tcv_write_deferred(tcv, 0x51, 130, a, sizeof(a)));
+	EXPECT_EQ(0, tcv_write_deferred(tcv, 0x51, 140, b, sizeof(b)));
+	eeprom.nacks = 1;
+	EXPECT_GT(0, tcv_flush(tcv));
+	ASSERT_EQ(1u, eeprom.writes.size());
+	EXPECT_EQ(make_pair(uint8_t(140), size_t(1)), eeprom.writes[0]);
+
+	/* only the failed run goes out again */
+	EXPECT_EQ(0, tcv_flush(tcv));
+	ASSERT_EQ(2u, eeprom.writes.size());
+	EXPECT_EQ(make_pair(uint8_t(130), size_t(2)), eeprom.writes[1]);
+	EXPECT_EQ(1, eeprom.mem[1][130]);
+	EXPECT_EQ(2, eeprom.mem[1][131]);
+
+	EXPECT_EQ(0, tcv_flush(tcv));
+	EXPECT_EQ(2u, eeprom.writes.size());
+}
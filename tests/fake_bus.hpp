@@ -0,0 +1,128 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Handles on several buses whose ports notice transfers running at the same
+ * time, shared by the suites driving a whole fleet
+ */
+
+#ifndef FAKE_BUS_HPP_
+#define FAKE_BUS_HPP_
+
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+extern "C"{
+#include "libtcv/tcv.h"
+#include "libtcv/bus.h"
+}
+#include "gtest/gtest.h"
+#include "fake_hw.hpp"
+#include "fake_tcv.hpp"
+
+namespace TestDoubles {
+
+const int BUSES = 4;
+const int PORTS = 4;
+const int HANDLES = BUSES * PORTS;
+
+/** Bus noticing transfers running at the same time */
+struct FakeBus {
+	std::atomic<int> users{0};
+	std::atomic<bool> overlap{false};
+};
+
+/** Port on a bus */
+struct Port {
+	FakeBus *bus;
+	FakeTCV *dev;
+	std::atomic<int> delay_ms{0};	// spent by every read
+	std::atomic<bool> fail{false};	// reads fail
+	std::atomic<int> polls{0};		// counted by the test
+};
+
+inline int port_read(void *ctx, std::uint8_t dev_addr, std::uint8_t reg_addr,
+		std::uint8_t* data, std::size_t len)
+{
+	auto port = static_cast<Port*>(ctx);
+	int ret = -1;
+
+	if (port->bus->users++)
+		port->bus->overlap = true;
+	std::this_thread::sleep_for(std::chrono::milliseconds(port->delay_ms));
+	if (!port->fail)
+		ret = port->dev->read(static_cast<tcv_dev_addr_t>(dev_addr), reg_addr, data, len);
+	port->bus->users--;
+	return ret;
+}
+
+inline int port_write(void *ctx, std::uint8_t dev_addr, std::uint8_t reg_addr,
+		const std::uint8_t* data, std::size_t len)
+{
+	return 0;
+}
+
+/** PORTS handles on each of BUSES buses, created but not initialized */
+class TestFleet : public ::testing::Test {
+	public:
+	TestFleet()
+	{
+		for (int i = 0; i < HANDLES; i++) {
+			add_tcv(i, std::make_shared<FakeSFP>(i, i2c_read, i2c_write));
+			ports[i].bus = &fake_buses[i / PORTS];
+			ports[i].dev = get_tcv(i).get();
+			tcvs[i] = tcv_create_ex(i, &ports[i], port_read, port_write);
+		}
+		for (int b = 0; b < BUSES; b++)
+			buses[b] = tcv_bus_create(NULL, NULL);
+	}
+
+	~TestFleet()
+	{
+		for (int i = 0; i < HANDLES; i++)
+			tcv_destroy(tcvs[i]);
+		for (int b = 0; b < BUSES; b++)
+			EXPECT_EQ(0, tcv_bus_destroy(buses[b]));
+		clear_tcvs();
+	}
+
+	void attach()
+	{
+		for (int i = 0; i < HANDLES; i++)
+			ASSERT_EQ(0, tcv_bus_attach(buses[i / PORTS], tcvs[i], TCV_BUS_NO_MUX));
+	}
+
+	FakeBus fake_buses[BUSES];
+	Port ports[HANDLES];
+	tcv_t *tcvs[HANDLES];
+	tcv_bus_t *buses[BUSES];
+};
+
+}
+
+#endif /* FAKE_BUS_HPP_ */
@@ -73,6 +73,7 @@ extern "C" int i2c_write(int index, uint8_t dev_addr, uint8_t reg_addr, const ui
 {
 	auto tcv = get_tcv(index);
 	if (tcv != nullptr) {
+		tcv->count_transaction();
 		return tcv->write(static_cast<tcv_dev_addr_t>(dev_addr), reg_addr, data, len);
 	}
 	return -1;
@@ -82,10 +83,38 @@ extern "C" int i2c_read(int index, uint8_t dev_addr, uint8_t reg_addr, uint8_t*
 {
 	auto tcv = get_tcv(index);
 	if (tcv != nullptr ) {
+		tcv->count_transaction();
+		tcv->bus_delay(len);
 		return tcv->read(static_cast<tcv_dev_addr_t>(dev_addr), reg_addr, data, len);
 	}
 	return -1;
 }
 
+extern "C" int i2c_write_ctx(void *ctx, uint8_t dev_addr, uint8_t reg_addr, const uint8_t* data, size_t len)
+{
+	auto tcv = static_cast<FakeTCV*>(ctx);
+	tcv->count_transaction();
+	return tcv->write(static_cast<tcv_dev_addr_t>(dev_addr), reg_addr, data, len);
+}
+
+extern "C" int i2c_read_ctx(void *ctx, uint8_t dev_addr, uint8_t reg_addr, uint8_t* data, size_t len)
+{
+	auto tcv = static_cast<FakeTCV*>(ctx);
+	tcv->count_transaction();
+	return tcv->read(static_cast<tcv_dev_addr_t>(dev_addr), reg_addr, data, len);
+}
+
+extern "C" int i2c_readv_ctx(void *ctx, const tcv_i2c_segment_t *segs, size_t nsegs)
+{
+	auto tcv = static_cast<FakeTCV*>(ctx);
+	tcv->count_transaction();
+	for (size_t i = 0; i < nsegs; i++) {
+		if (tcv->read(static_cast<tcv_dev_addr_t>(segs[i].devaddr),
+		              segs[i].regaddr, segs[i].data, segs[i].len) < 0)
+			return -1;
+	}
+	return 0;
+}
+
 }
 
@@ -34,6 +34,7 @@
 #ifndef FAKE_HW_I2C_H_
 #define FAKE_HW_I2C_H_
 #include <cstdint>
+#include "libtcv/tcv.h"
 
 extern "C" int i2c_write(int index, std::uint8_t dev_addr,
 		std::uint8_t reg_addr, const std::uint8_t* data, std::size_t len);
@@ -42,6 +43,17 @@ extern "C" int i2c_write(int index, std::uint8_t dev_addr,
 extern "C" int i2c_read(int index, std::uint8_t dev_addr, std::uint8_t reg_addr,
 		std::uint8_t* data, std::size_t len);
 
+/* Context carrying variants for tcv_create_ex(), ctx is a FakeTCV* */
+extern "C" int i2c_write_ctx(void *ctx, std::uint8_t dev_addr,
+		std::uint8_t reg_addr, const std::uint8_t* data, std::size_t len);
+
+extern "C" int i2c_read_ctx(void *ctx, std::uint8_t dev_addr,
+		std::uint8_t reg_addr, std::uint8_t* data, std::size_t len);
+
+/* Vectored read, the whole batch counts as one transaction */
+extern "C" int i2c_readv_ctx(void *ctx, const tcv_i2c_segment_t *segs,
+		std::size_t nsegs);
+
 
 
 #endif /* FAKE_HW_I2C_H_ */
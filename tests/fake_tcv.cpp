@@ -33,17 +33,39 @@
 /************************************************************************************/
 
 #include <algorithm>    // std::copy
+#include <atomic>
 #include <vector>
 #include "fake_tcv.hpp"
 
 extern "C"{
 #include <arpa/inet.h> /* nthol, htons etc */
+#include <unistd.h> /* usleep */
 }
 
 using namespace std;
 
 namespace TestDoubles{
 
+static atomic<bool> fake_clock_on(false);
+static atomic<uint64_t> fake_clock(0);
+
+uint64_t fake_clock_ns()
+{
+	return fake_clock;
+}
+
+void use_fake_clock(bool on)
+{
+	fake_clock_on = on;
+}
+
+void FakeTCV::bus_delay(std::size_t len) const
+{
+	if (fake_clock_on)
+		fake_clock += (xfer_us + len * byte_us) * 1000ULL;
+	else if (xfer_us || byte_us)
+		usleep(xfer_us + len * byte_us);
+}
 
 int FakeTCV::write(tcv_dev_addr_t device, std::uint8_t regaddr,
 		const std::uint8_t * data, std::size_t size)
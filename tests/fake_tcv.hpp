@@ -58,7 +58,8 @@ class FakeTCV
 {
 	public:
 		FakeTCV(int index, i2c_read_cb_t read, i2c_write_cb_t write, std::size_t pagesize = 256)
-			: eeprom(pagesize,0xFF) , diagnostics(pagesize, 0xFF)
+			: eeprom(pagesize,0xFF) , diagnostics(pagesize, 0xFF), transactions(0),
+			  xfer_us(0), byte_us(0)
 		{
 			tcv = tcv_create(index, i2c_read, i2c_write);
 		}
@@ -85,6 +86,43 @@ class FakeTCV
 		* Instrumentation functions
 		**********************/
 
+		/**
+		 * Account one I2C bus transaction (one callback invocation)
+		 */
+		void count_transaction()
+		{
+			transactions++;
+		}
+
+		/**
+		 * Number of I2C bus transactions since construction or last reset
+		 */
+		unsigned int get_transactions() const
+		{
+			return transactions;
+		}
+
+		void reset_transactions()
+		{
+			transactions = 0;
+		}
+
+		/**
+		 * Simulate bus timing, every transaction takes
+		 * xfer + len * byte microseconds
+		 */
+		void set_latency(unsigned int xfer, unsigned int byte)
+		{
+			xfer_us = xfer;
+			byte_us = byte;
+		}
+
+		/**
+		 * Spend the simulated time of a transaction of len bytes,
+		 * see use_fake_clock()
+		 */
+		void bus_delay(std::size_t len) const;
+
 		/**
 		 * Manipulate eeprom content for test
 		 * @param index offset where to start
@@ -162,6 +200,9 @@ class FakeTCV
 		std::vector<std::uint8_t> eeprom;
 		std::vector<uint8_t> diagnostics;
 		tcv_t* tcv;
+		unsigned int transactions;
+		unsigned int xfer_us;
+		unsigned int byte_us;
 
 		/**
 		 * Checks if up to length bytes can be accessed in containter
@@ -207,6 +248,18 @@ class FakeXFP: public FakeTCV
 		;
 
 };
+
+/**
+ * Simulated time in nanoseconds, FakeTCV::bus_delay() advances it instead of
+ * sleeping while enabled. Handed to tcv_set_clock() it makes the timing
+ * decisions of the library deterministic.
+ */
+std::uint64_t fake_clock_ns();
+
+/**
+ * Switch bus_delay() between the simulated clock and real sleeps
+ */
+void use_fake_clock(bool on);
 }
 
 #endif /* FAKE_TCV_HPP_ */
@@ -0,0 +1,143 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Test sharing of A0h images between modules of the same part
+ */
+
+#include <memory>
+#include <string>
+#include <cstdint>
+
+extern "C"{
+#include "libtcv/tcv.h"
+#include "libtcv/image_store.h"
+}
+#include "gtest/gtest.h"
+#include "fake_hw.hpp"
+#include "fake_tcv.hpp"
+
+using namespace std;
+using namespace TestDoubles;
+
+class TestImageStore : public ::testing::Test {
+	public:
+	tcv_image_store_t *store;
+
+	TestImageStore()
+	{
+		store = tcv_image_store_create();
+		for (int i = 1; i <= 3; i++) {
+			add_tcv(i, make_shared<FakeSFP>(i, i2c_read, i2c_write));
+			get_tcv(i)->manip_eeprom(20, "ACME CORP.      ");
+			get_tcv(i)->manip_eeprom(68, "SN000" + to_string(i) + "          ");
+			get_tcv(i)->manip_eeprom(96, "VENDOR DATA");
+		}
+	}
+
+	~TestImageStore()
+	{
+		clear_tcvs();
+		EXPECT_EQ(0, tcv_image_store_destroy(store));
+	}
+
+	tcv_image_store_stats_t stats()
+	{
+		tcv_image_store_stats_t s;
+
+		EXPECT_EQ(0, tcv_image_store_get_stats(store, &s));
+		return s;
+	}
+};
+
+/* Same part, one image; per module fields stay apart */
+TEST_F(TestImageStore, sharedImage)
+{
+	char sn[TCV_VENDOR_SN_SIZE + 1], vendor[TCV_VENDOR_NAME_SIZE + 1];
+
+	ASSERT_NE(nullptr, store);
+	for (int i = 1; i <= 3; i++) {
+		ASSERT_EQ(0, tcv_image_store_attach(store, get_tcv(i)->get_ctcv()));
+		ASSERT_EQ(0, tcv_init(get_tcv(i)->get_ctcv()));
+	}
+	EXPECT_EQ(1u, stats().images);
+	EXPECT_EQ(3u, stats().references);
+
+	for (int i = 1; i <= 3; i++) {
+		tcv_t *tcv = get_tcv(i)->get_ctcv();
+		EXPECT_EQ(0, tcv_get_vendor_sn(tcv, sn));
+		EXPECT_EQ("SN000" + to_string(i) + "          ", string(sn));
+		EXPECT_EQ(0, tcv_get_vendor_name(tcv, vendor));
+		EXPECT_STREQ("ACME CORP.      ", vendor);
+		EXPECT_EQ(string("VENDOR DATA"), string((const char *) tcv_get_vendor_rom(tcv), 11));
+	}
+	EXPECT_EQ(tcv_get_vendor_rom(get_tcv(1)->get_ctcv()),
+	          tcv_get_vendor_rom(get_tcv(3)->get_ctcv()));
+
+	/* busy while images are in use */
+	EXPECT_EQ(TCV_ERR_BUSY, tcv_image_store_destroy(store));
+	ASSERT_EQ(0, tcv_image_store_detach(get_tcv(3)->get_ctcv()));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_image_store_detach(get_tcv(3)->get_ctcv()));
+	ASSERT_EQ(0, tcv_init(get_tcv(3)->get_ctcv()));
+	EXPECT_EQ(2u, stats().references);
+	EXPECT_EQ(0, tcv_get_vendor_sn(get_tcv(3)->get_ctcv(), sn));
+	EXPECT_STREQ("SN0003          ", sn);
+}
+
+/* Another part gets its own image, released with the last user */
+TEST_F(TestImageStore, distinctParts)
+{
+	ASSERT_NE(nullptr, store);
+	get_tcv(2)->manip_eeprom(40, "OTHER PART      ");
+	for (int i = 1; i <= 2; i++) {
+		ASSERT_EQ(0, tcv_image_store_attach(store, get_tcv(i)->get_ctcv()));
+		ASSERT_EQ(0, tcv_init(get_tcv(i)->get_ctcv()));
+	}
+	EXPECT_EQ(2u, stats().images);
+
+	/* new module of the first part */
+	get_tcv(2)->manip_eeprom(40, string(16, '\xff'));
+	ASSERT_EQ(0, tcv_init(get_tcv(2)->get_ctcv()));
+	EXPECT_EQ(1u, stats().images);
+	EXPECT_EQ(2u, stats().references);
+}
+
+/* Lazily loaded images are shared once complete */
+TEST_F(TestImageStore, lazyInit)
+{
+	tcv_t *tcv = get_tcv(1)->get_ctcv();
+	char sn[TCV_VENDOR_SN_SIZE + 1];
+
+	ASSERT_NE(nullptr, store);
+	ASSERT_EQ(0, tcv_image_store_attach(store, tcv));
+	ASSERT_EQ(0, tcv_set_lazy_init(tcv, 1));
+	ASSERT_EQ(0, tcv_init(tcv));
+	EXPECT_EQ(0u, stats().images);
+
+	ASSERT_NE(nullptr, tcv_get_8079_rom(tcv));
+	EXPECT_EQ(1u, stats().images);
+	EXPECT_EQ(0, tcv_get_vendor_sn(tcv, sn));
+	EXPECT_STREQ("SN0001          ", sn);
+}
@@ -0,0 +1,122 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Test parallel initialization of handles on several buses
+ */
+
+#include <atomic>
+#include <chrono>
+
+extern "C"{
+#include "libtcv/tcv.h"
+#include "libtcv/parallel.h"
+}
+#include "gtest/gtest.h"
+#include "fake_bus.hpp"
+
+using namespace std;
+using namespace TestDoubles;
+
+namespace {
+
+void count(tcv_t *tcv, int status, void *arg)
+{
+	(*static_cast<atomic<int>*>(arg))++;
+}
+
+}
+
+class TestParallelInit : public TestFleet {
+	public:
+	TestParallelInit()
+	{
+		for (int i = 0; i < HANDLES; i++)
+			ports[i].delay_ms = 2;
+	}
+};
+
+TEST_F(TestParallelInit, busesInParallel)
+{
+	tcv_parallel_opts_t opts = {};
+	int results[HANDLES];
+
+	attach();
+
+	auto start = chrono::steady_clock::now();
+	for (int i = 0; i < HANDLES; i++)
+		ASSERT_EQ(0, tcv_init(tcvs[i]));
+	auto serial = chrono::steady_clock::now() - start;
+
+	opts.threads = BUSES;
+	opts.results = results;
+	start = chrono::steady_clock::now();
+	EXPECT_EQ(HANDLES, tcv_init_many(tcvs, HANDLES, &opts));
+	auto parallel = chrono::steady_clock::now() - start;
+
+	for (int i = 0; i < HANDLES; i++)
+		EXPECT_EQ(0, results[i]);
+	/* each bus is still used by one handle at a time */
+	for (int b = 0; b < BUSES; b++)
+		EXPECT_FALSE(fake_buses[b].overlap);
+	EXPECT_LT(parallel * 2, serial);
+}
+
+TEST_F(TestParallelInit, perHandleResults)
+{
+	tcv_parallel_opts_t opts = {};
+	atomic<int> done(0);
+	tcv_t *handles[] = { tcvs[0], NULL, tcvs[1], tcvs[2] };
+	int results[4];
+
+	ports[1].fail = true;
+	opts.results = results;
+	opts.done = count;
+	opts.arg = &done;
+
+	EXPECT_EQ(2, tcv_init_many(handles, 4, &opts));
+	EXPECT_EQ(0, results[0]);
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, results[1]);
+	EXPECT_GT(0, results[2]);
+	EXPECT_EQ(0, results[3]);
+	EXPECT_EQ(4, done);
+
+	EXPECT_EQ(TCV_TYPE_SFP, tcv_get_identifier(tcvs[2]));
+	EXPECT_EQ(TCV_ERR_NOT_INITIALIZED, tcv_get_identifier(tcvs[1]));
+}
+
+TEST_F(TestParallelInit, argumentChecks)
+{
+	tcv_parallel_opts_t opts = {};
+
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_init_many(NULL, 1, NULL));
+	EXPECT_EQ(0, tcv_init_many(NULL, 0, NULL));
+
+	/* the caller alone */
+	attach();
+	opts.threads = 1;
+	EXPECT_EQ(HANDLES, tcv_init_many(tcvs, HANDLES, &opts));
+	EXPECT_EQ(HANDLES, tcv_init_many(tcvs, HANDLES, NULL));
+}
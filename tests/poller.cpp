@@ -0,0 +1,170 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Test the digital diagnostics poll engine
+ */
+
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+extern "C"{
+#include "libtcv/tcv.h"
+#include "libtcv/poller.h"
+}
+#include "gtest/gtest.h"
+#include "fake_bus.hpp"
+
+using namespace std;
+using namespace TestDoubles;
+
+class TestPoller : public TestFleet {
+	public:
+	TestPoller()
+	{
+		for (int i = 0; i < HANDLES; i++)
+			tcv_init(tcvs[i]);
+		opts.cb = polled;
+		opts.arg = this;
+	}
+
+	static void polled(tcv_t *tcv, int status, const tcv_dd_snapshot_t *snapshot,
+	                   void *arg)
+	{
+		auto self = static_cast<TestPoller*>(arg);
+
+		if (status < 0 || !snapshot) {
+			self->failed++;
+			return;
+		}
+		for (int i = 0; i < HANDLES; i++)
+			if (self->tcvs[i] == tcv)
+				self->ports[i].polls++;
+	}
+
+	/** Run a poller for a while */
+	tcv_poll_stats_t run(int ms)
+	{
+		tcv_poll_stats_t stats = {};
+		tcv_poller_t *poller = tcv_poller_create(tcvs, HANDLES, &opts);
+
+		EXPECT_NE(nullptr, poller);
+		if (!poller)
+			return stats;
+		this_thread::sleep_for(chrono::milliseconds(ms));
+		EXPECT_EQ(0, tcv_poller_get_stats(poller, &stats));
+		EXPECT_EQ(0, tcv_poller_destroy(poller));
+		return stats;
+	}
+
+	tcv_poll_opts_t opts = {};
+	atomic<int> failed{0};
+};
+
+TEST_F(TestPoller, pollsEveryPortEachCycle)
+{
+	attach();
+	for (int i = 0; i < HANDLES; i++)
+		ports[i].delay_ms = 1;
+	opts.threads = BUSES;
+	opts.interval_ms = 50;
+
+	tcv_poll_stats_t stats = run(230);
+
+	EXPECT_EQ(0, failed);
+	EXPECT_GE(stats.cycles, 4u);
+	EXPECT_GE(stats.completed, 4u);
+	EXPECT_EQ(0u, stats.overruns);
+	EXPECT_EQ(0u, stats.errors);
+	EXPECT_GT(stats.last_cycle_ns, 0u);
+	EXPECT_LT(stats.max_cycle_ns, 50000000u);
+	for (int i = 0; i < HANDLES; i++)
+		EXPECT_GE(ports[i].polls, 4) << "port " << i;
+	for (int b = 0; b < BUSES; b++)
+		EXPECT_FALSE(fake_buses[b].overlap);
+}
+
+/* A stuck port delays its own bus only */
+TEST_F(TestPoller, stuckPortKeepsOtherBuses)
+{
+	attach();
+	ports[0].delay_ms = 250;
+	opts.threads = BUSES;
+	opts.interval_ms = 40;
+
+	tcv_poll_stats_t stats = run(330);
+
+	EXPECT_GT(stats.overruns, 0u);
+	/* the other ports of the stuck bus had their turn before it came back */
+	for (int i = 1; i < PORTS; i++)
+		EXPECT_GE(ports[i].polls, 1) << "port " << i;
+	for (int i = PORTS; i < HANDLES; i++)
+		EXPECT_GE(ports[i].polls, 7) << "port " << i;
+	EXPECT_FALSE(fake_buses[0].overlap);
+}
+
+/* Idle workers take over buses of a busy one */
+TEST_F(TestPoller, idleWorkersSteal)
+{
+	attach();
+	for (int i = 0; i < PORTS; i++)
+		ports[i].delay_ms = 10;
+	opts.threads = 2;
+	opts.interval_ms = 100;
+
+	tcv_poll_stats_t stats = run(150);
+
+	EXPECT_GT(stats.steals, 0u);
+	EXPECT_GE(stats.completed, 1u);
+	for (int b = 0; b < BUSES; b++)
+		EXPECT_FALSE(fake_buses[b].overlap);
+}
+
+TEST_F(TestPoller, handlesWithoutBus)
+{
+	opts.threads = 3;
+	opts.interval_ms = 20;
+
+	tcv_poll_stats_t stats = run(70);
+
+	EXPECT_GE(stats.completed, 2u);
+	for (int i = 0; i < HANDLES; i++)
+		EXPECT_GE(ports[i].polls, 2) << "port " << i;
+}
+
+TEST_F(TestPoller, argumentChecks)
+{
+	tcv_poll_stats_t stats;
+
+	opts.interval_ms = 10;
+	EXPECT_EQ(nullptr, tcv_poller_create(NULL, HANDLES, &opts));
+	EXPECT_EQ(nullptr, tcv_poller_create(tcvs, 0, &opts));
+	EXPECT_EQ(nullptr, tcv_poller_create(tcvs, HANDLES, NULL));
+	opts.interval_ms = 0;
+	EXPECT_EQ(nullptr, tcv_poller_create(tcvs, HANDLES, &opts));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_poller_destroy(NULL));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_poller_get_stats(NULL, &stats));
+}
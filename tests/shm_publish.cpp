@@ -0,0 +1,181 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 George Redivo
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Test the shared memory publisher and its lock-free readers
+ */
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <unistd.h>
+
+extern "C"{
+#include "libtcv/tcv.h"
+#include "libtcv/shm.h"
+}
+#include "gtest/gtest.h"
+#include "fake_hw.hpp"
+#include "fake_tcv.hpp"
+
+using namespace std;
+using namespace TestDoubles;
+
+class TestShm : public ::testing::Test {
+	public:
+	string name = "/libtcv-test-" + to_string(getpid());
+	tcv_shm_t *pub;
+
+	TestShm()
+	{
+		add_tcv(1, make_shared<FakeSFP>(1, i2c_read, i2c_write));
+		add_tcv(3, make_shared<FakeSFP>(3, i2c_read, i2c_write));
+		tcv_shm_unlink(name.c_str());
+		pub = tcv_shm_create(name.c_str(), 4);
+	}
+
+	~TestShm()
+	{
+		tcv_shm_close(pub);
+		clear_tcvs();
+	}
+};
+
+/* Readers see what was published without touching the module */
+TEST_F(TestShm, publishAndRead)
+{
+	auto mtcv = get_tcv(3);
+	tcv_t *tcv = mtcv->get_ctcv();
+	tcv_shm_port_t port;
+
+	ASSERT_NE(nullptr, pub);
+	mtcv->manip_eeprom(20, "ACME CORP.      ");
+	mtcv->manip_dd(96, int16_t(-384));
+	EXPECT_EQ(TCV_ERR_NOT_INITIALIZED, tcv_shm_publish(pub, 2, tcv));
+	ASSERT_EQ(0, tcv_init(tcv));
+
+	tcv_shm_t *reader = tcv_shm_open(name.c_str());
+	ASSERT_NE(nullptr, reader);
+	EXPECT_EQ(4u, tcv_shm_slots(reader));
+	EXPECT_EQ(TCV_ERR_NOT_INITIALIZED, tcv_shm_read(reader, 2, &port));
+
+	EXPECT_EQ(0, tcv_shm_publish(pub, 2, tcv));
+	mtcv->reset_transactions();
+	ASSERT_EQ(0, tcv_shm_read(reader, 2, &port));
+	EXPECT_EQ(0u, mtcv->get_transactions());
+	EXPECT_EQ(3, port.index);
+	EXPECT_EQ(uint32_t(TCV_SHM_A0_VALID | TCV_SHM_DD_VALID), port.flags);
+	EXPECT_EQ(TCV_TYPE_SFP, port.a0[0]);
+	EXPECT_EQ(string("ACME CORP.      "), string((const char *) &port.a0[20], 16));
+	EXPECT_EQ(-384, port.dd.temp);
+
+	tcv_dd_snapshot_t snap = port.dd;
+	snap.temp = 256;
+	EXPECT_EQ(0, tcv_shm_publish_dd(pub, 2, &snap));
+	ASSERT_EQ(0, tcv_shm_read(reader, 2, &port));
+	EXPECT_EQ(256, port.dd.temp);
+	EXPECT_EQ(TCV_TYPE_SFP, port.a0[0]);
+
+	/* readers cannot publish */
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_shm_publish_dd(reader, 2, &snap));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_shm_read(reader, 4, &port));
+	EXPECT_EQ(0, tcv_shm_close(reader));
+	EXPECT_EQ(nullptr, tcv_shm_open("/libtcv-test-missing"));
+}
+
+/* An existing object is left alone until it is unlinked explicitly */
+TEST_F(TestShm, existingObject)
+{
+	auto mtcv = get_tcv(3);
+	tcv_t *tcv = mtcv->get_ctcv();
+	tcv_shm_port_t port;
+
+	ASSERT_NE(nullptr, pub);
+	ASSERT_EQ(0, tcv_init(tcv));
+	EXPECT_EQ(0, tcv_shm_publish(pub, 1, tcv));
+	tcv_shm_t *reader = tcv_shm_open(name.c_str());
+	ASSERT_NE(nullptr, reader);
+
+	EXPECT_EQ(nullptr, tcv_shm_create(name.c_str(), 2));
+	EXPECT_EQ(TCV_ERR_INVALID_ARG, tcv_shm_unlink(NULL));
+	EXPECT_EQ(0, tcv_shm_unlink(name.c_str()));
+	EXPECT_EQ(0, tcv_shm_unlink(name.c_str()));
+
+	/* the reader keeps the old object, a new one does not touch it */
+	tcv_shm_t *next = tcv_shm_create(name.c_str(), 2);
+	ASSERT_NE(nullptr, next);
+	ASSERT_EQ(0, tcv_shm_read(reader, 1, &port));
+	EXPECT_EQ(3, port.index);
+	EXPECT_EQ(4u, tcv_shm_slots(reader));
+	EXPECT_EQ(0, tcv_shm_close(reader));
+
+	reader = tcv_shm_open(name.c_str());
+	ASSERT_NE(nullptr, reader);
+	EXPECT_EQ(2u, tcv_shm_slots(reader));
+	EXPECT_EQ(0, tcv_shm_close(reader));
+	EXPECT_EQ(0, tcv_shm_close(next));
+}
+
+/* Readers never see a half written slot */
+TEST_F(TestShm, consistentReads)
+{
+	atomic<bool> stop{false};
+	atomic<unsigned> torn{0}, reads{0};
+	tcv_dd_snapshot_t snap = {};
+
+	ASSERT_NE(nullptr, pub);
+	tcv_shm_t *reader = tcv_shm_open(name.c_str());
+	ASSERT_NE(nullptr, reader);
+	EXPECT_EQ(0, tcv_shm_publish_dd(pub, 0, &snap));
+
+	thread rd([&] {
+		tcv_shm_port_t port;
+		while (!stop) {
+			if (tcv_shm_read(reader, 0, &port) == 0) {
+				reads++;
+				if (uint16_t(port.dd.temp) != port.dd.vcc ||
+				    port.dd.vcc != port.dd.rx_pwr ||
+				    port.dd.timestamp != port.dd.vcc)
+					torn++;
+			}
+		}
+	});
+
+	for (uint16_t i = 0; i < 20000 || reads < 100; i++) {
+		snap.temp = i;
+		snap.vcc = i;
+		snap.rx_pwr = i;
+		snap.timestamp = i;
+		tcv_shm_publish_dd(pub, 0, &snap);
+	}
+	stop = true;
+	rd.join();
+
+	EXPECT_EQ(0u, torn);
+	EXPECT_LT(0u, reads);
+	tcv_shm_close(reader);
+}